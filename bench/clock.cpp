@@ -2,6 +2,8 @@
 
 #include <chrono>
 
+#include <blackhole/clock.hpp>
+
 #ifdef __linux__
 #   include <sys/time.h>
 #endif
@@ -55,6 +57,34 @@ high_resolution_clock(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+static
+void
+source(::benchmark::State& state, const std::shared_ptr<clock_source_t>& clock) {
+    while (state.KeepRunning()) {
+        ::benchmark::DoNotOptimize(clock->now());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+source_precise(::benchmark::State& state) {
+    source(state, clock_source::precise());
+}
+
+static
+void
+source_coarse(::benchmark::State& state) {
+    source(state, clock_source::coarse());
+}
+
+static
+void
+source_tsc(::benchmark::State& state) {
+    source(state, clock_source::tsc());
+}
+
 #ifdef __linux__
 NBENCHMARK("clock.coarse", monotonic_coarse);
 NBENCHMARK("clock.precise", monotonic_precise);
@@ -63,5 +93,9 @@ NBENCHMARK("clock.precise", monotonic_precise);
 NBENCHMARK("clock.system", system_clock);
 NBENCHMARK("clock.high_resolution", high_resolution_clock);
 
+NBENCHMARK("clock.source[precise]", source_precise);
+NBENCHMARK("clock.source[coarse]", source_coarse);
+NBENCHMARK("clock.source[tsc]", source_tsc);
+
 }  // namespace benchmark
 }  // namespace blackhole
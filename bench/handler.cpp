@@ -0,0 +1,105 @@
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/handler/asynchronous.hpp>
+#include <blackhole/handler/blocking.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/stdext/string_view.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+
+namespace {
+
+class null_sink_t : public sink_t {
+public:
+    auto emit(const record_t&, const string_view&) -> void override {}
+};
+
+}  // namespace
+
+/// Measures the caller side cost of handling a record, which includes formatting for the blocking
+/// handler and only the record copy for the asynchronous one.
+template<typename T>
+static void handle(::benchmark::State& state) {
+    auto handler = builder<T>()
+        .set(builder<formatter::string_t>("{timestamp} {severity}: {message}, [{...}]").build())
+        .add(std::unique_ptr<sink_t>(new null_sink_t))
+        .build();
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key#1", "value#1"}, {"key#2", 42}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    record.activate();
+
+    while (state.KeepRunning()) {
+        handler->handle(record);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void handle_blocking(::benchmark::State& state) {
+    handle<handler::blocking_t>(state);
+}
+
+static void handle_asynchronous(::benchmark::State& state) {
+    handle<handler::asynchronous_t>(state);
+}
+
+/// Measures the blocking handler with lines of the given size, larger than the writer inline
+/// buffer, reporting the number of heap allocations per record.
+static void handle_blocking_lines(::benchmark::State& state, std::size_t size) {
+    auto handler = builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{severity}: {message}, payload={payload}").build())
+        .add(std::unique_ptr<sink_t>(new null_sink_t))
+        .build();
+
+    const std::string payload(size, 'x');
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"payload", payload}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    record.activate();
+
+    // Warm up, so the buffer reaches its steady-state capacity.
+    handler->handle(record);
+
+    const auto before = allocations();
+
+    while (state.KeepRunning()) {
+        handler->handle(record);
+    }
+
+    const auto count = allocations() - before;
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel("allocations per record: " +
+        std::to_string(static_cast<double>(count) / static_cast<double>(state.iterations())));
+}
+
+static void handle_blocking_1k(::benchmark::State& state) {
+    handle_blocking_lines(state, 1024);
+}
+
+static void handle_blocking_4k(::benchmark::State& state) {
+    handle_blocking_lines(state, 4096);
+}
+
+NBENCHMARK("handler.blocking", handle_blocking);
+NBENCHMARK("handler.blocking[line: 1KiB]", handle_blocking_1k);
+NBENCHMARK("handler.blocking[line: 4KiB]", handle_blocking_4k);
+NBENCHMARK("handler.asynchronous", handle_asynchronous);
+
+}  // namespace benchmark
+}  // namespace blackhole
@@ -4,6 +4,7 @@
 #include <benchmark/benchmark.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/clock.hpp>
 #include <blackhole/extensions/facade.hpp>
 #include <blackhole/handler.hpp>
 #include <blackhole/logger.hpp>
@@ -16,10 +17,26 @@
 namespace blackhole {
 namespace benchmark {
 
+namespace {
+
+/// Accepts everything and does nothing, allowing to measure the logger itself.
+class null_handler_t : public handler_t {
+public:
+    auto handle(const record_t&) -> void override {}
+};
+
+auto null_handlers() -> std::vector<std::unique_ptr<handler_t>> {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(new null_handler_t);
+    return handlers;
+}
+
+}  // namespace
+
 static
 void
 literal(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -32,7 +49,7 @@ literal(::benchmark::State& state) {
 static
 void
 string(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     const std::string string("[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
@@ -46,10 +63,41 @@ string(::benchmark::State& state) {
 static
 void
 literal_reject(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     root.filter([](const record_t&) -> bool {
         return false;
-    });
+    }, 1);
+
+    logger_facade<root_logger_t> logger(root);
+
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+literal_stripped(::benchmark::State& state) {
+    root_logger_t root(null_handlers());
+    logger_facade<root_logger_t, 1> logger(root);
+
+    const std::string path("/porn.png");
+    while (state.KeepRunning()) {
+        BLACKHOLE_LOG(logger, 0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET {} HTTP/1.0' 200 2326",
+            path + path
+        );
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+literal_with_clock(::benchmark::State& state, std::shared_ptr<clock_source_t> clock) {
+    root_logger_t root(null_handlers());
+    root.clock(std::move(clock));
 
     logger_facade<root_logger_t> logger(root);
 
@@ -60,10 +108,28 @@ literal_reject(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+static
+void
+literal_with_precise_clock(::benchmark::State& state) {
+    literal_with_clock(state, clock_source::precise());
+}
+
+static
+void
+literal_with_coarse_clock(::benchmark::State& state) {
+    literal_with_clock(state, clock_source::coarse());
+}
+
+static
+void
+literal_with_tsc_clock(::benchmark::State& state) {
+    literal_with_clock(state, clock_source::tsc());
+}
+
 static
 void
 literal_with_arg(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -78,7 +144,7 @@ literal_with_arg(::benchmark::State& state) {
 static
 void
 literal_with_lazy_arg(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     const auto path = "/porn.png";
@@ -96,7 +162,7 @@ literal_with_lazy_arg(::benchmark::State& state) {
 static
 void
 literal_with_args(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -111,7 +177,7 @@ literal_with_args(::benchmark::State& state) {
 static
 void
 literal_with_args_using_cpp14_formatter(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -130,7 +196,7 @@ literal_with_args_using_cpp14_formatter(::benchmark::State& state) {
 static
 void
 literal_with_attributes(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -147,7 +213,7 @@ literal_with_attributes(::benchmark::State& state) {
 static
 void
 literal_with_scoped_attributes(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     const scope::holder_t scoped(root, {
@@ -164,7 +230,7 @@ literal_with_scoped_attributes(::benchmark::State& state) {
 }
 
 static void literal_with_scoped_attributes_everytime(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -183,7 +249,7 @@ static void literal_with_scoped_attributes_everytime(::benchmark::State& state)
 static
 void
 literal_with_args_and_attributes(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     logger_facade<root_logger_t> logger(root);
 
     while (state.KeepRunning()) {
@@ -203,7 +269,7 @@ literal_with_args_and_attributes(::benchmark::State& state) {
 static
 void
 literal_with_args_and_attributes_and_wrapper(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
     wrapper_t wrapper{root, {
         {"key#0", {500}},
         {"key#1", {"value#1"}}
@@ -228,7 +294,7 @@ literal_with_args_and_attributes_and_wrapper(::benchmark::State& state) {
 static
 void
 literal_with_args_and_attributes_and_two_wrappers(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
 
     wrapper_t wrapper1{root, {
         {"key#0", {500}},
@@ -259,7 +325,7 @@ literal_with_args_and_attributes_and_two_wrappers(::benchmark::State& state) {
 static
 void
 literal_with_args_and_attributes_and_three_wrappers(::benchmark::State& state) {
-    root_logger_t root({});
+    root_logger_t root(null_handlers());
 
     wrapper_t wrapper1{root, {
         {"key#0", {500}},
@@ -296,6 +362,10 @@ NBENCHMARK("log.string", string);
 
 NBENCHMARK("log.lit", literal);
 NBENCHMARK("log.lit[reject]", literal_reject);
+NBENCHMARK("log.lit[stripped]", literal_stripped);
+NBENCHMARK("log.lit[clock: precise]", literal_with_precise_clock);
+NBENCHMARK("log.lit[clock: coarse]", literal_with_coarse_clock);
+NBENCHMARK("log.lit[clock: tsc]", literal_with_tsc_clock);
 NBENCHMARK("log.lit[args: 1]", literal_with_arg);
 NBENCHMARK("log.lit[args: 1 (lazy)]", literal_with_lazy_arg);
 NBENCHMARK("log.lit[args: 6]", literal_with_args);
@@ -320,7 +390,7 @@ protected:
     logger_facade<root_logger_t> logger;
 
 public:
-    threaded_t(): root({}), logger(root) {}
+    threaded_t(): root(null_handlers()), logger(root) {}
 };
 
 BENCHMARK_DEFINE_F(threaded_t, facade)(::benchmark::State& state) {
@@ -338,8 +408,39 @@ BENCHMARK_DEFINE_F(threaded_t, facade)(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+BENCHMARK_DEFINE_F(threaded_t, literal)(::benchmark::State& state) {
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
 BENCHMARK_REGISTER_F(threaded_t, facade)
     ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
 
+BENCHMARK_REGISTER_F(threaded_t, literal)
+    ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
+
+class threaded_reject_t: public threaded_t {
+public:
+    threaded_reject_t() {
+        root.filter([](const record_t&) -> bool {
+            return false;
+        }, 1);
+    }
+};
+
+BENCHMARK_DEFINE_F(threaded_reject_t, literal)(::benchmark::State& state) {
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(threaded_reject_t, literal)
+    ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
+
 }  // namespace benchmark
 }  // namespace blackhole
@@ -1,3 +1,44 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 #include <benchmark/benchmark.h>
 
+#include "mod.hpp"
+
+namespace {
+
+/// Counts heap allocations made by the whole benchmark binary.
+std::atomic<std::size_t> counter(0);
+
+}  // namespace
+
+namespace blackhole {
+namespace benchmark {
+
+auto allocations() noexcept -> std::size_t {
+    return counter.load(std::memory_order_relaxed);
+}
+
+}  // namespace benchmark
+}  // namespace blackhole
+
+auto operator new(std::size_t size) -> void* {
+    counter.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto ptr = std::malloc(size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* ptr) noexcept -> void {
+    std::free(ptr);
+}
+
+auto operator delete(void* ptr, std::size_t) noexcept -> void {
+    std::free(ptr);
+}
+
 BENCHMARK_MAIN();
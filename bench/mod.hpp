@@ -1,7 +1,18 @@
 #pragma once
 
+#include <cstddef>
+
 // Some private magic, but it's okay, since I manage the library version myself.
 #define NBENCHMARK(name, n) \
     BENCHMARK_PRIVATE_DECLARE(n) =                               \
         (::benchmark::internal::RegisterBenchmarkInternal(       \
             new ::benchmark::internal::FunctionBenchmark(name, n)))
+
+namespace blackhole {
+namespace benchmark {
+
+/// Returns the number of heap allocations made by the whole benchmark binary so far.
+auto allocations() noexcept -> std::size_t;
+
+}  // namespace benchmark
+}  // namespace blackhole
@@ -1,29 +1,124 @@
+#include <cstdint>
+#include <string>
+
 #include <benchmark/benchmark.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/extensions/writer.hpp>
 #include <blackhole/record.hpp>
 #include <src/recordbuf.hpp>
 
 #include "mod.hpp"
 
+namespace {
+
+struct endpoint_t {
+    std::string host;
+    std::uint16_t port;
+};
+
+}  // namespace
+
+namespace blackhole {
+inline namespace v1 {
+
+template<>
+struct display_traits<endpoint_t> {
+    static auto apply(const endpoint_t& endpoint, writer_t& wr) -> void {
+        wr.write("{}:{}", endpoint.host, endpoint.port);
+    }
+};
+
+}  // namespace v1
+}  // namespace blackhole
+
 namespace blackhole {
 namespace benchmark {
 
-static void record(::benchmark::State& state) {
+static
+void
+into_owned(::benchmark::State& state, const record_t& record) {
+    const auto before = allocations();
+
+    while (state.KeepRunning()) {
+        recordbuf_t owned(record);
+        ::benchmark::DoNotOptimize(owned);
+    }
+
+    const auto count = allocations() - before;
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel("allocations per record: " +
+        std::to_string(static_cast<double>(count) / static_cast<double>(state.iterations())));
+}
+
+static
+void
+record(::benchmark::State& state) {
     const string_view message("GET /porn.png HTTP/1.1");
     const attribute_list attributes{{"key#1", "value#1"}};
     const attribute_pack pack{attributes};
 
     record_t record(42, message, pack);
 
+    into_owned(state, record);
+}
+
+static
+void
+record_with_attributes(::benchmark::State& state) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const string_view formatted("GET /porn.png HTTP/1.1 - SUCCESS");
+    const std::string path("/porn.png");
+    const endpoint_t endpoint{"127.0.0.1", 8080};
+
+    const attribute_list attributes{
+        {"key#1", "value#1"},
+        {"key#2", 42},
+        {"key#3", 3.1415},
+        {"key#4", path},
+    };
+
+    const attribute_list scoped{
+        {"trace", "0ae4c9ab1cf3"},
+        {"endpoint", endpoint},
+    };
+
+    const attribute_pack pack{attributes, scoped};
+
+    record_t record(42, message, pack);
+    record.activate(formatted);
+
+    into_owned(state, record);
+}
+
+static
+void
+assign(::benchmark::State& state) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key#1", "value#1"}};
+    const attribute_pack pack{attributes};
+
+    record_t record(42, message, pack);
+    recordbuf_t owned(record);
+
+    const auto before = allocations();
+
     while (state.KeepRunning()) {
-        detail::recordbuf_t owned(record);
+        owned.assign(record);
+        ::benchmark::DoNotOptimize(owned);
     }
 
+    const auto count = allocations() - before;
+
     state.SetItemsProcessed(state.iterations());
+    state.SetLabel("allocations per record: " +
+        std::to_string(static_cast<double>(count) / static_cast<double>(state.iterations())));
 }
 
 NBENCHMARK("record[into_owned]", record);
+NBENCHMARK("record[assign]", assign);
+NBENCHMARK("record[into_owned + attr: 6]", record_with_attributes);
 
 }  // namespace benchmark
 }  // namespace blackhole
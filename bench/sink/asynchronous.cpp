@@ -0,0 +1,258 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/sink/asynchronous.hpp>
+
+#include <src/sink/asynchronous.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+
+namespace {
+
+/// Counts emitted records and does nothing else.
+class counting_sink_t : public sink_t {
+public:
+    std::atomic<std::uint64_t>& counter;
+
+    explicit counting_sink_t(std::atomic<std::uint64_t>& counter) :
+        counter(counter)
+    {}
+
+    auto emit(const record_t&, const string_view&) -> void override {
+        counter.fetch_add(1, std::memory_order_release);
+    }
+};
+
+/// Emulates a sink waiting for a network round trip on each record, like a remote collector.
+class slow_sink_t : public sink_t {
+public:
+    std::atomic<std::uint64_t>& counter;
+
+    explicit slow_sink_t(std::atomic<std::uint64_t>& counter) :
+        counter(counter)
+    {}
+
+    auto emit(const record_t&, const string_view&) -> void override {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        counter.fetch_add(1, std::memory_order_release);
+    }
+};
+
+auto underflow(const char* name) -> std::unique_ptr<sink::underflow_policy_t> {
+    return sink::underflow_policy_factory_t().create(name);
+}
+
+auto overflow(const char* name) -> std::unique_ptr<sink::overflow_policy_t> {
+    return sink::overflow_policy_factory_t().create(name);
+}
+
+}  // namespace
+
+static
+void
+throughput(::benchmark::State& state, const char* policy) {
+    std::atomic<std::uint64_t> counter(0);
+    std::unique_ptr<sink_t> wrapped(new counting_sink_t(counter));
+    sink::asynchronous_t sink(std::move(wrapped), 10, overflow("wait"), underflow(policy));
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key#1", "value#1"}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    while (state.KeepRunning()) {
+        sink.emit(record, message);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// Measures the time from emitting a record into an idle sink until the consumer handles it.
+static
+void
+latency(::benchmark::State& state, const char* policy) {
+    std::atomic<std::uint64_t> counter(0);
+    std::unique_ptr<sink_t> wrapped(new counting_sink_t(counter));
+    sink::asynchronous_t sink(std::move(wrapped), 10, overflow("wait"), underflow(policy));
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    std::uint64_t expected = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        // Let the consumer become idle.
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        state.ResumeTiming();
+
+        sink.emit(record, message);
+
+        ++expected;
+        while (counter.load(std::memory_order_acquire) != expected) {
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+throughput_park(::benchmark::State& state) {
+    throughput(state, "park");
+}
+
+static
+void
+throughput_spin(::benchmark::State& state) {
+    throughput(state, "spin");
+}
+
+static
+void
+latency_park(::benchmark::State& state) {
+    latency(state, "park");
+}
+
+static
+void
+latency_spin(::benchmark::State& state) {
+    latency(state, "spin");
+}
+
+/// Compares the slotted queue against the byte ring of the same footprint order.
+static
+void
+throughput_queue(::benchmark::State& state, std::unique_ptr<sink::asynchronous::queue_t> queue) {
+    std::atomic<std::uint64_t> counter(0);
+    std::unique_ptr<sink_t> wrapped(new counting_sink_t(counter));
+    sink::asynchronous_t sink(std::move(wrapped), std::move(queue),
+        sink::exception_policy_factory_t().create("ignore"), overflow("wait"), underflow("park"));
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key#1", "value#1"}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    while (state.KeepRunning()) {
+        sink.emit(record, message);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+throughput_shared(::benchmark::State& state) {
+    throughput_queue(state, sink::asynchronous::queue_factory_t().create("shared", 10));
+}
+
+static
+void
+throughput_bytes(::benchmark::State& state) {
+    throughput_queue(state, sink::asynchronous::queue_factory_t().bytes(256 * 1024));
+}
+
+NBENCHMARK("sink.async[underflow: park]", throughput_park);
+NBENCHMARK("sink.async[underflow: spin]", throughput_spin);
+NBENCHMARK("sink.async[underflow: park, idle]", latency_park);
+NBENCHMARK("sink.async[underflow: spin, idle]", latency_spin);
+NBENCHMARK("sink.async[queue: shared]", throughput_shared);
+NBENCHMARK("sink.async[queue: bytes]", throughput_bytes);
+
+/// Measures how fast records with different keys are drained through a slow sink by the given
+/// number of workers.
+static
+void
+slow(::benchmark::State& state, std::size_t workers) {
+    std::atomic<std::uint64_t> counter(0);
+
+    const string_view message("GET /porn.png HTTP/1.1");
+
+    std::uint64_t expected = 0;
+    while (state.KeepRunning()) {
+        {
+            auto sink = builder<sink::asynchronous_t>(
+                std::unique_ptr<sink_t>(new slow_sink_t(counter)))
+                .factor(10)
+                .workers(workers)
+                .key("key")
+                .build();
+
+            for (std::int64_t i = 0; i < 256; ++i) {
+                const attribute_list attributes{{"key", i % 16}};
+                const attribute_pack pack{attributes};
+                record_t record(0, message, pack);
+
+                sink->emit(record, message);
+            }
+        }
+
+        expected += 256;
+    }
+
+    if (counter.load() != expected) {
+        state.SkipWithError("lost records");
+    }
+
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+
+static
+void
+slow_1(::benchmark::State& state) {
+    slow(state, 1);
+}
+
+static
+void
+slow_4(::benchmark::State& state) {
+    slow(state, 4);
+}
+
+NBENCHMARK("sink.async[slow sink, workers: 1]", slow_1)->UseRealTime();
+NBENCHMARK("sink.async[slow sink, workers: 4]", slow_4)->UseRealTime();
+
+/// Many producers contending for a tiny queue, so most of them are blocked by the wait overflow
+/// policy most of the time.
+class contended_t : public ::benchmark::Fixture {
+protected:
+    std::atomic<std::uint64_t> counter;
+    sink::asynchronous_t sink;
+
+public:
+    contended_t() :
+        counter(0),
+        sink(std::unique_ptr<sink_t>(new counting_sink_t(counter)), 2, overflow("wait"),
+            underflow("park"))
+    {}
+};
+
+BENCHMARK_DEFINE_F(contended_t, wait)(::benchmark::State& state) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key#1", "value#1"}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    while (state.KeepRunning()) {
+        sink.emit(record, message);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(contended_t, wait)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+}  // namespace benchmark
+}  // namespace blackhole
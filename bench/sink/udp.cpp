@@ -0,0 +1,80 @@
+#include <vector>
+
+#include <boost/asio/ip/udp.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/sink/socket/udp.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+
+namespace {
+
+/// Local UDP receiver, that is never read, so datagrams are dropped by the kernel once its buffer
+/// is full.
+class receiver_t {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket;
+
+public:
+    receiver_t() :
+        socket(io_service, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0))
+    {}
+
+    auto endpoint() const -> boost::asio::ip::udp::endpoint {
+        return socket.local_endpoint();
+    }
+};
+
+}  // namespace
+
+static
+void
+emit(::benchmark::State& state) {
+    receiver_t receiver;
+    sink::socket::udp_t sink("127.0.0.1", receiver.endpoint().port());
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    while (state.KeepRunning()) {
+        sink.emit(record, message);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+emit_batch(::benchmark::State& state) {
+    receiver_t receiver;
+    sink::socket::udp_t sink("127.0.0.1", receiver.endpoint().port());
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    std::vector<sink_t::entry_t> entries;
+    for (int i = 0; i < 64; ++i) {
+        entries.push_back({record, message});
+    }
+
+    while (state.KeepRunning()) {
+        sink.emit_batch(sink_t::batch_t(entries.data(), entries.size()));
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(entries.size()));
+}
+
+NBENCHMARK("sink.udp[emit]", emit);
+NBENCHMARK("sink.udp[emit_batch: 64]", emit_batch);
+
+}  // namespace benchmark
+}  // namespace blackhole
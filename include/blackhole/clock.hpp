@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "blackhole/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Represents a source of timestamps for log records.
+///
+/// The root logger asks its clock source for the current time once for each record that passed
+/// filtering, so implementations must be thread-safe and should be as cheap as possible.
+class clock_source_t {
+public:
+    typedef record_t::time_point time_point;
+
+public:
+    virtual ~clock_source_t() = default;
+
+    /// Returns the current wall-clock time.
+    virtual auto now() const noexcept -> time_point = 0;
+};
+
+namespace clock_source {
+
+/// Returns a precise realtime clock source, backed by `std::chrono::system_clock`.
+///
+/// This is the default clock source.
+auto precise() -> std::shared_ptr<clock_source_t>;
+
+/// Returns a coarse realtime clock source, backed by `CLOCK_REALTIME_COARSE` on Linux.
+///
+/// It is several times cheaper than the precise one, but has the resolution of a scheduler tick,
+/// usually 1-4 ms. Falls back to the precise clock source on other platforms.
+auto coarse() -> std::shared_ptr<clock_source_t>;
+
+/// Returns a clock source that reads the CPU timestamp counter and converts its value to the wall
+/// clock time using the calibration, periodically resynchronized with the realtime clock on a
+/// background thread.
+///
+/// Precise to nanoseconds and nearly as cheap as reading a register. Small drifts from the realtime
+/// clock are corrected by slewing the rate, so timestamps never step back unless the realtime
+/// clock itself is set. Falls back to the precise clock source on non-x86 platforms and on CPUs
+/// without an invariant TSC. All callers share the same instance, the background thread stops
+/// when the last reference is gone.
+auto tsc() -> std::shared_ptr<clock_source_t>;
+
+/// Returns a clock source by its name, which may be "precise", "coarse" or "tsc".
+///
+/// \throw std::invalid_argument if the name is unknown.
+auto create(const std::string& name) -> std::shared_ptr<clock_source_t>;
+
+}  // namespace clock_source
+}  // namespace v1
+}  // namespace blackhole
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <climits>
 #include <functional>
 
 #if (__GNUC__ >= 6 || defined(__clang__)) && defined(__cpp_constexpr) && __cpp_constexpr >= 201304
@@ -8,17 +9,49 @@
 
 #include "blackhole/extensions/facade.inl.hpp"
 
+/// Compile-time severity threshold used by default for all logging facades.
+///
+/// Define it before including this header (or pass via compiler flags) to strip all logging calls
+/// with lower severity levels made using `BLACKHOLE_LOG` macro from the resulting binary.
+#ifndef BLACKHOLE_SEVERITY_THRESHOLD
+#   define BLACKHOLE_SEVERITY_THRESHOLD INT_MIN
+#endif
+
+/// Logs a message through the given facade unless its severity is either stripped at compile time
+/// or disabled at runtime.
+///
+/// Unlike plain `log` method calls neither the message arguments nor the attribute list are
+/// evaluated when the event is rejected. Provided the severity is a constant expression less than
+/// the facade's compile-time threshold, the whole statement compiles to no code.
+///
+/// \note the logger expression is evaluated multiple times.
+#define BLACKHOLE_LOG(logger, severity, ...)                                                       \
+    do {                                                                                           \
+        if ((logger).compiled(severity) && (logger).enabled(severity)) {                           \
+            (logger).log((severity), __VA_ARGS__);                                                 \
+        }                                                                                          \
+    } while (false)
+
 namespace blackhole {
 inline namespace v1 {
 
 /// Logging facade wraps the underlying logger and provides convenient formatting methods.
 ///
+/// Each logging method asks the underlying logger whether the given severity is enabled before
+/// constructing attribute packs or formatting arguments. Use `BLACKHOLE_LOG` macro to avoid
+/// evaluating the arguments themselves.
+///
 /// \tparam Logger must meet the requirements of `Logger`.
-template<typename Logger>
+/// \tparam Threshold compile-time severity threshold, events with lower severity are dropped
+///     without consulting the underlying logger.
+template<typename Logger, int Threshold = BLACKHOLE_SEVERITY_THRESHOLD>
 class logger_facade {
 public:
     typedef Logger wrapped_type;
 
+    /// Compile-time severity threshold.
+    static constexpr int threshold = Threshold;
+
 private:
     std::reference_wrapper<wrapped_type> wrapped;
 
@@ -43,6 +76,20 @@ public:
         return wrapped.get();
     }
 
+    /// Checks whether events with the given severity level are compiled in.
+    ///
+    /// Being a constant expression for constant arguments this allows the compiler to eliminate
+    /// stripped logging statements entirely.
+    static constexpr auto compiled(int severity) noexcept -> bool {
+        return severity >= Threshold;
+    }
+
+    /// Checks whether events with the given severity level are both compiled in and enabled in the
+    /// underlying logger.
+    auto enabled(int severity) const noexcept -> bool {
+        return compiled(severity) && inner().enabled(severity);
+    }
+
     /// Log a message with the given severity level.
     auto log(int severity, const string_view& pattern) -> void;
 
@@ -91,36 +138,52 @@ private:
         typename std::enable_if<detail::with_attributes<Args...>::value>::type;
 };
 
-template<typename Logger>
+template<typename Logger, int Threshold>
 inline
 auto
-logger_facade<Logger>::log(int severity, const string_view& pattern) -> void {
+logger_facade<Logger, Threshold>::log(int severity, const string_view& pattern) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     inner().log(severity, pattern);
 }
 
-template<typename Logger>
+template<typename Logger, int Threshold>
 template<typename T, typename... Args>
 inline
 auto
-logger_facade<Logger>::log(int severity, const string_view& pattern, const T& arg, const Args&... args) -> void {
+logger_facade<Logger, Threshold>::log(int severity, const string_view& pattern, const T& arg, const Args&... args) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     select(severity, pattern, arg, args...);
 }
 
-template<typename Logger>
+template<typename Logger, int Threshold>
 inline
 auto
-logger_facade<Logger>::log(int severity, const string_view& pattern, const attribute_list& attributes) -> void {
+logger_facade<Logger, Threshold>::log(int severity, const string_view& pattern, const attribute_list& attributes) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     attribute_pack pack{attributes};
     inner().log(severity, pattern, pack);
 }
 
 #if (__GNUC__ >= 6 || defined(__clang__)) && defined(__cpp_constexpr) && __cpp_constexpr >= 201304
 
-template<typename Logger>
+template<typename Logger, int Threshold>
 template<std::size_t N, typename T, typename... Args>
 inline
 auto
-logger_facade<Logger>::log(int severity, const detail::formatter<N>& pattern, const T& arg, const Args&... args) -> void {
+logger_facade<Logger, Threshold>::log(int severity, const detail::formatter<N>& pattern, const T& arg, const Args&... args) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     fmt::MemoryWriter wr;
     const auto fn = [&]() -> string_view {
         pattern.format(wr, arg, args...);
@@ -134,11 +197,11 @@ logger_facade<Logger>::log(int severity, const detail::formatter<N>& pattern, co
 
 #endif
 
-template<typename Logger>
+template<typename Logger, int Threshold>
 template<typename... Args>
 inline
 auto
-logger_facade<Logger>::select(int severity, const string_view& pattern, const Args&... args) ->
+logger_facade<Logger, Threshold>::select(int severity, const string_view& pattern, const Args&... args) ->
     typename std::enable_if<!detail::with_attributes<Args...>::value>::type
 {
     fmt::MemoryWriter wr;
@@ -148,15 +211,18 @@ logger_facade<Logger>::select(int severity, const string_view& pattern, const Ar
     inner().log(severity, {pattern, std::cref(fn)}, pack);
 }
 
-template<typename Logger>
+template<typename Logger, int Threshold>
 template<typename... Args>
 inline
 auto
-logger_facade<Logger>::select(int severity, const string_view& pattern, const Args&... args) ->
+logger_facade<Logger, Threshold>::select(int severity, const string_view& pattern, const Args&... args) ->
     typename std::enable_if<detail::with_attributes<Args...>::value>::type
 {
     detail::without_tail<detail::select_t, Args...>::type::apply(inner(), severity, pattern, args...);
 }
 
+template<typename Logger, int Threshold>
+constexpr int logger_facade<Logger, Threshold>::threshold;
+
 } // namespace v1
 } // namespace blackhole
@@ -22,5 +22,18 @@ public:
     virtual auto from(const config::node_t& config) const -> std::unique_ptr<T> = 0;
 };
 
+template<>
+class factory<handler_t> : public factory_t {
+public:
+    virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> = 0;
+
+    /// Constructs a handler, resolving its formatter, sinks and filters through the given registry
+    /// instead of the one this factory was created with.
+    ///
+    /// The default implementation ignores the registry.
+    virtual auto from(const config::node_t& config, const registry_t& registry) const ->
+        std::unique_ptr<handler_t>;
+};
+
 } // namespace v1
 } // namespace blackhole
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <limits>
 #include <memory>
 
+#include "blackhole/severity.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 
@@ -24,6 +27,17 @@ public:
 public:
     virtual ~filter_t() = default;
     virtual auto filter(const record_t& record) -> action_t = 0;
+
+    /// Returns the minimum severity level this filter may not deny.
+    ///
+    /// Records with lower severity are guaranteed to be denied, which allows handlers to report
+    /// their thresholds, so loggers reject such records early. The value must not change during the
+    /// filter lifetime.
+    ///
+    /// The default implementation reports the lowest possible severity, i.e. no guarantees.
+    virtual auto threshold() const noexcept -> severity_t {
+        return std::numeric_limits<int>::min();
+    }
 };
 
 }  // namespace v1
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 
+#include "blackhole/severity.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 
@@ -19,6 +22,23 @@ public:
     ///
     /// \warning must be thread-safe.
     virtual auto handle(const record_t& record) -> void = 0;
+
+    /// Returns the minimum severity level this handler may be interested in.
+    ///
+    /// Records with lower severity are guaranteed to be dropped by the handler, which allows
+    /// loggers to reject them early. The value must not change during the handler lifetime.
+    ///
+    /// The default implementation is interested in everything.
+    virtual auto threshold() const noexcept -> severity_t;
+
+    /// Blocks until records handled before this call are emitted and the sinks are flushed, or the
+    /// given timeout expires.
+    ///
+    /// The default implementation does nothing, which suits handlers that neither queue records nor
+    /// own sinks.
+    ///
+    /// \returns false on timeout.
+    virtual auto flush(std::chrono::milliseconds timeout) -> bool;
 };
 
 }  // namespace v1
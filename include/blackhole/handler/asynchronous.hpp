@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+
+#include "../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+
+/// The asynchronous handler captures records into a queue and performs both formatting and
+/// emitting to its sinks on a separate thread, so the caller pays only for the record copy.
+///
+/// Records are drained in batches, formatted one by one and then emitted to each sink as a single
+/// batch.
+///
+/// \note exceptions thrown by filters, the formatter or sinks are hidden from the application, the
+///     record that caused them is dropped. A throwing filter denies the record for its sink.
+///
+/// # Parameters
+///
+/// Besides the formatter and sinks with optional per-sink filters, the same as for the blocking
+/// handler, the handler accepts the queue capacity factor and overflow and underflow policies,
+/// which have the same meaning as for the asynchronous sink. Filters are evaluated on the
+/// background thread. The queue type may be set by name with the `"queue"` option, "shared" by
+/// default.
+///
+/// Records dropped on queue overflow are counted by severity and reported through the sinks once
+/// the queue has been drained, like "dropped 42 records (2: 40, 3: 2)". The `"deadline"` option in
+/// milliseconds limits the queue drain time on destruction, the same as for the asynchronous sink.
+class asynchronous_t;
+
+}  // namespace handler
+
+template<>
+class builder<handler::asynchronous_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    builder();
+
+    auto set(std::unique_ptr<formatter_t> formatter) & -> builder&;
+    auto set(std::unique_ptr<formatter_t> formatter) && -> builder&&;
+    auto add(std::unique_ptr<sink_t> sink) & -> builder&;
+    auto add(std::unique_ptr<sink_t> sink) && -> builder&&;
+
+    /// Adds the sink, which receives only records passed by the given filter. Records denied by
+    /// the filters of all sinks are not formatted at all.
+    auto add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) & -> builder&;
+    auto add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) && -> builder&&;
+
+    /// Sets the queue capacity to exp2(value).
+    auto factor(std::size_t value) & -> builder&;
+    auto factor(std::size_t value) && -> builder&&;
+
+    /// Drops records on queue overflow.
+    auto drop() & -> builder&;
+    auto drop() && -> builder&&;
+
+    /// Blocks the caller on queue overflow. This is the default behavior.
+    auto wait() & -> builder&;
+    auto wait() && -> builder&&;
+
+    /// Limits the time the handler drains its queue on destruction. Records left after the
+    /// deadline are abandoned and their number is reported through the sinks. Zero, the default,
+    /// means no limit.
+    auto deadline(std::chrono::milliseconds timeout) & -> builder&;
+    auto deadline(std::chrono::milliseconds timeout) && -> builder&&;
+
+    auto build() && -> std::unique_ptr<handler_t>;
+};
+
+template<>
+class factory<handler::asynchronous_t> : public factory<handler_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    virtual auto type() const noexcept -> const char* override;
+    virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> override;
+    virtual auto from(const config::node_t& config, const registry_t& registry) const ->
+        std::unique_ptr<handler_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -23,6 +23,11 @@ public:
     auto add(std::unique_ptr<sink_t> sink) & -> builder&;
     auto add(std::unique_ptr<sink_t> sink) && -> builder&&;
 
+    /// Adds the sink, which receives only records passed by the given filter. Records denied by
+    /// the filters of all sinks are not formatted at all.
+    auto add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) & -> builder&;
+    auto add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) && -> builder&&;
+
     auto build() && -> std::unique_ptr<handler_t>;
 };
 
@@ -37,6 +42,8 @@ public:
 
     virtual auto type() const noexcept -> const char* override;
     virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> override;
+    virtual auto from(const config::node_t& config, const registry_t& registry) const ->
+        std::unique_ptr<handler_t> override;
 };
 
 }  // namespace v1
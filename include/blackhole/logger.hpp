@@ -51,6 +51,13 @@ public:
     /// the specified severity and including the attributes pack provided.
     virtual auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void = 0;
 
+    /// Checks whether a logging event with the specified severity level can pass filtering.
+    ///
+    /// This is a cheap conservative hint, that allows to reject events before constructing their
+    /// attributes and messages: `false` means that the event will definitely be dropped, while
+    /// `true` means nothing. The default implementation accepts everything.
+    virtual auto enabled(severity_t severity) const noexcept -> bool;
+
     /// Returns a scoped attributes manager reference.
     ///
     /// Returned manager allows the external tools to attach scoped attributes to the current logger
@@ -49,6 +49,12 @@ public:
     auto lwp() const noexcept -> std::uint64_t;
     auto tid() const noexcept -> std::thread::native_handle_type;
 
+    /// Returns the name of the thread, that has created the record, or nullptr if it is unknown.
+    ///
+    /// Thread identity is captured at construction time from a per-thread cache, so neither this
+    /// method nor `pid` and `lwp` perform system calls.
+    auto thread_name() const noexcept -> const char*;
+
     auto formatted() const noexcept -> const string_view&;
     auto attributes() const noexcept -> const attribute_pack&;
 
@@ -63,6 +69,12 @@ public:
     /// setting the current time point.
     auto activate(const string_view& formatted = string_view()) noexcept -> void;
 
+    /// Activate the record by setting the given formatted message and timestamp, obtained from some
+    /// external clock source.
+    ///
+    /// \overload
+    auto activate(const string_view& formatted, time_point timestamp) noexcept -> void;
+
 private:
     auto inner() noexcept -> inner_t&;
     auto inner() const noexcept -> const inner_t&;
@@ -18,10 +18,15 @@ public:
 
     auto configurator() noexcept -> config::factory_t&;
 
+    /// Builds the logger with the given name from the configuration.
+    ///
+    /// Handlers configured with identical formatters share a single formatter instance, which
+    /// formats each record once for all of them.
     auto build(const std::string& name) -> root_logger_t;
 
 private:
-    auto handler(const config::node_t& config) const -> std::unique_ptr<handler_t>;
+    auto handler(const config::node_t& config, const registry_t& context) const ->
+        std::unique_ptr<handler_t>;
 };
 
 class registry_t {
@@ -43,6 +48,13 @@ public:
     /// Returns the handler factory with the given type if registered, throws otherwise.
     virtual auto handler(const std::string& type) const -> handler_factory = 0;
 
+    /// Returns the handler factory with the given type if registered, throws otherwise. Handlers
+    /// it creates resolve their formatters, sinks and filters through the given registry.
+    ///
+    /// The default implementation ignores the given registry.
+    virtual auto handler(const std::string& type, const registry_t& context) const ->
+        handler_factory;
+
     /// Returns the formatter factory with the given type if registered, throws otherwise.
     virtual auto formatter(const std::string& type) const -> formatter_factory = 0;
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -10,6 +12,7 @@
 namespace blackhole {
 inline namespace v1 {
 
+class clock_source_t;
 class handler_t;
 class record_t;
 
@@ -24,12 +27,14 @@ public:
     typedef std::function<auto(const record_t&) -> bool> filter_t;
 
 private:
+    struct inner_t;
+
+    /// Minimum severity level that can pass both the filter and at least one handler.
+    std::atomic<int> threshold;
+
     struct sync_t;
     std::unique_ptr<sync_t> sync;
 
-    struct inner_t;
-    std::shared_ptr<inner_t> inner;
-
 public:
     /// Constructs a root level logger with the given handlers.
     ///
@@ -45,12 +50,19 @@ public:
     root_logger_t(const root_logger_t& other) = delete;
 
     /// Constructs a root level logger by consuming another existing logger.
-    root_logger_t(root_logger_t&& other) noexcept;
+    ///
+    /// \throw std::bad_alloc if the configuration snapshot can not be allocated.
+    root_logger_t(root_logger_t&& other);
 
     ~root_logger_t();
 
     auto operator=(const root_logger_t& other) -> root_logger_t& = delete;
-    auto operator=(root_logger_t&& other) noexcept -> root_logger_t&;
+    /// Atomically replaces the configuration of this logger with the one of the other logger, while
+    /// other threads may still log through it.
+    ///
+    /// \throw std::bad_alloc if the configuration snapshot can not be allocated, this logger is left
+    ///     unchanged then.
+    auto operator=(root_logger_t&& other) -> root_logger_t&;
 
     /// Replaces the current logger filter function with the given one.
     ///
@@ -59,6 +71,37 @@ public:
     /// \warning the function must be thread-safe.
     auto filter(filter_t fn) -> void;
 
+    /// Replaces the current logger filter function with the given one, additionally declaring that
+    /// it rejects all events with severity level less than the specified threshold.
+    ///
+    /// This allows to reject such events via `enabled` without constructing records at all.
+    ///
+    /// \overload
+    /// \warning the function must be thread-safe.
+    auto filter(filter_t fn, severity_t threshold) -> void;
+
+    /// Replaces the clock source used to timestamp records that passed filtering.
+    ///
+    /// The default one is the precise realtime clock, see `clock_source` namespace for more.
+    auto clock(std::shared_ptr<clock_source_t> source) -> void;
+
+    /// Blocks until records logged before this call are emitted by all handlers and their sinks are
+    /// flushed, or the given timeout expires.
+    ///
+    /// Intended to be called before the process exits abnormally, for example on a termination
+    /// signal or before `abort()`, when loggers are not destroyed and asynchronous sinks would lose
+    /// their queued records.
+    ///
+    /// \returns false on timeout.
+    auto flush(std::chrono::milliseconds timeout) -> bool;
+
+    /// Checks whether an event with the given severity level can pass both the filter and at least
+    /// one of handlers.
+    ///
+    /// Costs a single relaxed atomic load, so it is cheap enough to be called on every logging
+    /// attempt before constructing attributes and formatting arguments.
+    auto enabled(severity_t severity) const noexcept -> bool final;
+
     auto log(severity_t severity, const message_t& message) -> void;
     auto log(severity_t severity, const message_t& message, attribute_pack& pack) -> void;
     auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
@@ -70,6 +113,10 @@ private:
     auto consume(severity_t severity, const string_view& pattern, attribute_pack& pack, const F& fn) -> void;
 };
 
+inline auto root_logger_t::enabled(severity_t severity) const noexcept -> bool {
+    return severity >= threshold.load(std::memory_order_relaxed);
+}
+
 template<>
 class builder<root_logger_t> {
 public:
@@ -85,6 +132,10 @@ public:
     auto add(std::unique_ptr<handler_t> handler) & -> builder&;
     auto add(std::unique_ptr<handler_t> handler) && -> builder&&;
 
+    /// Sets the clock source used to timestamp records.
+    auto clock(std::shared_ptr<clock_source_t> source) & -> builder&;
+    auto clock(std::shared_ptr<clock_source_t> source) && -> builder&&;
+
     auto build() && -> std::unique_ptr<result_type>;
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "blackhole/attribute.hpp"
 #include "blackhole/attributes.hpp"
 
 namespace blackhole {
@@ -31,6 +32,16 @@ class watcher_t {
     std::reference_wrapper<manager_t> manager;
     watcher_t* prev;
 
+    /// Flattened view of this and all previous scoped attribute lists.
+    ///
+    /// Built lazily on first collection and never invalidated, because previous watchers are
+    /// guaranteed to outlive this one. Accessed only from the owning thread.
+    ///
+    /// \note the cache is part of the class layout since SOVERSION 2, so derived classes built
+    ///     against 1.x must be rebuilt.
+    mutable attribute_pack chain;
+    mutable bool cached;
+
 public:
     /// Constructs a scoped attributes watch which will be associated with the specified logger.
     explicit watcher_t(logger_t& logger);
@@ -50,7 +61,10 @@ public:
     auto operator=(const watcher_t& other) -> watcher_t& = delete;
     auto operator=(watcher_t&& other) -> watcher_t& = delete;
 
-    /// Recursively collects all scoped attributes into the given attributes pack.
+    /// Collects all scoped attributes into the given attributes pack.
+    ///
+    /// The chain of scoped attribute lists is flattened once per watcher, so subsequent calls
+    /// append the pre-built range without walking the linked list.
     auto collect(attribute_pack& pack) const -> void;
 
     /// Recursively rebind all scoped attributes with the new logger manager.
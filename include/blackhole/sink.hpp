@@ -1,23 +1,56 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <string>
 
+#include "blackhole/stdext/string_view.hpp"
+
 namespace blackhole {
 inline namespace v1 {
-namespace stdext {
 
-template<typename Char, typename Traits>
-class basic_string_view;
+class record_t;
 
-typedef basic_string_view<char, std::char_traits<char>> string_view;
+class sink_t {
+public:
+    /// Record accompanied with its formatted message, the unit of batched emission.
+    struct entry_t {
+        const record_t& record;
+        string_view message;
+    };
 
-}  // namespace stdext
+    /// Non-owning view of a contiguous range of entries.
+    class batch_t {
+        const entry_t* data;
+        std::size_t size_;
 
-using stdext::string_view;
+    public:
+        constexpr batch_t(const entry_t* data, std::size_t size) noexcept :
+            data(data),
+            size_(size)
+        {}
 
-class record_t;
+        constexpr auto begin() const noexcept -> const entry_t* {
+            return data;
+        }
+
+        constexpr auto end() const noexcept -> const entry_t* {
+            return data + size_;
+        }
+
+        constexpr auto size() const noexcept -> std::size_t {
+            return size_;
+        }
+
+        constexpr auto empty() const noexcept -> bool {
+            return size_ == 0;
+        }
+
+        constexpr auto operator[](std::size_t idx) const noexcept -> const entry_t& {
+            return data[idx];
+        }
+    };
 
-class sink_t {
 public:
     sink_t() = default;
     sink_t(const sink_t& other) = default;
@@ -29,6 +62,35 @@ public:
     auto operator=(sink_t&& other) -> sink_t& = default;
 
     virtual auto emit(const record_t& record, const string_view& message) -> void = 0;
+
+    /// Emits several records at once, preserving their order.
+    ///
+    /// The default implementation emits them one by one. Sinks, that are able to write multiple
+    /// messages using a single lock acquisition or system call, should override it.
+    ///
+    /// If an exception is thrown some of the records may remain unemitted.
+    virtual auto emit_batch(const batch_t& batch) -> void {
+        for (const auto& entry : batch) {
+            emit(entry.record, entry.message);
+        }
+    }
+
+    /// Flushes messages buffered by this sink to the underlying device, blocking until done.
+    ///
+    /// The default implementation does nothing, which suits sinks that do not buffer.
+    virtual auto flush() -> void {}
+
+    /// Flushes messages buffered by this sink to the underlying device, blocking until done or the
+    /// given timeout expires.
+    ///
+    /// The default implementation calls `flush()` ignoring the timeout, which suits sinks that
+    /// write synchronously.
+    ///
+    /// \returns false on timeout.
+    virtual auto flush(std::chrono::milliseconds timeout) -> bool {
+        flush();
+        return true;
+    }
 };
 
 }  // namespace v1
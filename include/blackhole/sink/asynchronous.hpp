@@ -1,6 +1,15 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "blackhole/factory.hpp"
+#include "blackhole/severity.hpp"
+#include "blackhole/sink.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -12,23 +21,164 @@ namespace sink {
 /// Depending on the underlying overflow policies and queues the implementation may preallocate the
 /// space required to keep all item structs in the memory.
 ///
-/// \note exceptions while writing to those sink will be hidden from the application.
+/// \note exceptions while writing to those sink will be hidden from the application, instead they
+///     are handled by the exception policy.
 ///
 /// # Parameters
 ///
 /// The factor value maps directly into the queue capacity and equals exp2(factor). The value must
 /// fit in [0; 20] range (1048576 items).
 ///
-/// Overflow policy decides what action is taken when the queue is overflowed. There are currently
-/// only two available policies: drop and wait. The first one will silently (or not) drop all log
-/// events that weren't enqueued. The second one will block the caller thread until the queue is
-/// full.
+/// Overflow policy decides what action is taken when the queue is overflowed. There are four
+/// available policies: drop, wait, watermark and spill. The first one will silently (or not) drop
+/// all log events that weren't enqueued. The second one will block the caller thread until the
+/// consumer frees some queue slot. Optionally it may wait no longer than the given timeout in
+/// milliseconds, dropping the event after that. The drop and wait policies are configured either by
+/// their name or by an object, like `{"type": "wait", "timeout": 100}`, the other two only by an
+/// object.
+///
+/// The "watermark" policy sheds low severity events before the queue is full, keeping room for
+/// more important ones. Each watermark defines the queue occupancy level in percents, starting from
+/// which events of its severity and higher, up to the next watermark, are dropped. Events with
+/// severity below all watermarks are admitted until the queue is full. On full queue events with
+/// severity of at least "block" wait for a free slot, others are dropped. For example:
+/// `{"type": "watermark", "watermarks": [{"severity": 0, "level": 50},
+/// {"severity": 3, "level": 100}], "block": 4}`.
+///
+/// The "spill" policy neither blocks nor drops events while the queue is full, appending them to a
+/// memory-mapped file instead, like `{"type": "spill", "path": "/var/spool/app.spill", "size":
+/// "256MiB"}`. Spilled events are emitted once the queue has been drained, so they may follow
+/// newer events. The file size is fixed on creation, events that do not fit in it are dropped.
+/// Events left in the file when the process stops or crashes are emitted by the next sink opening
+/// it. The path is required. Each file is locked by a single sink, so sinks must not share paths,
+/// workers of a pool append their index to it, like "app.spill.0".
+///
+/// Dropped events are counted by severity. Once the queue has been drained, the sink emits a
+/// synthetic record through the wrapped sink, like "dropped 42 records (2: 40, 3: 2)", listing how
+/// many events of each severity have been lost since the previous such report. The counters are
+/// also available via `asynchronous::handle_t::dropped`.
+///
+/// Underflow policy decides what the consumer thread does while the queue is empty. The default
+/// "park" policy spins for a short while and then parks the thread until some record arrives,
+/// producers wake it up only if it is actually parked. The "spin" policy busy polls the queue,
+/// occupying a processor core for the lowest possible latency.
+///
+/// Exception policy decides what the consumer thread does when the wrapped sink throws while
+/// emitting a batch of events. The default "ignore" policy gives the batch up, counting its events
+/// as failed. The "retry" policy emits the batch again after a backoff, doubling on each failure,
+/// up to the given number of attempts, for example `{"type": "retry", "attempts": 5, "backoff":
+/// 10}`. The consumer thread sleeps during the backoff, so this policy is rejected for sinks in a
+/// consumer group, where it would stall all other sinks of the group.
+/// The "fallback" policy emits failed batches to another sink, like
+/// `{"type": "fallback", "sink": {"type": "console"}}`.
+///
+/// By default all producer threads share a single queue. Under heavy contention from many threads
+/// a sharded queue may be used instead, where each thread gets its own ring, registered lazily on
+/// its first record. The factor then defines the capacity of each ring. The consumer merges rings
+/// either by record timestamps or in a round-robin manner, see `merge_t`. Configured either by the
+/// queue type name, "shared" or "sharded", or by an object, like
+/// `{"type": "sharded", "merge": "relaxed"}`.
+///
+/// With a fixed number of slots the memory used by the queue scales with the number of events
+/// rather than their size. The "bytes" queue is a contiguous byte ring with variable-length
+/// entries, which capacity is defined in bytes instead, like `{"type": "bytes", "capacity":
+/// "64MiB"}`. The factor is ignored then, and watermark levels refer to the bytes taken. Events
+/// larger than half of the ring are dropped.
+///
+/// A single consumer thread may not keep up with a slow wrapped sink, like a network one waiting
+/// for round trips. The sink may run several workers, each with its own queue and consumer thread,
+/// emitting to the same wrapped sink, which therefore must be thread-safe. Records are routed to
+/// workers by a key, so records with the same key are emitted in order, while records with
+/// different keys are emitted in parallel. The key is either the producer thread, which is the
+/// default, or the value of some attribute, for example the one that defines the destination file
+/// path. Configured like `"workers": 4, "key": {"type": "attribute", "name": "source"}`. The
+/// queue and policies are created for each worker.
+///
+/// The consumer thread may be placed with the `"thread"` option, like `{"name": "log-io",
+/// "affinity": [2, 3], "nice": 10, "scheduler": "batch"}`, keeping it off the processors of
+/// latency-critical threads. The "scheduler" is one of "other", "batch", "idle", "fifo" or "rr",
+/// the latter two with the static "priority". Unset options are inherited from the thread creating
+/// the sink. Sinks with the same `"group"` in their thread options share a single consumer thread,
+/// which emits a batch of each sink in turn, so a process with many sinks does not spawn a thread
+/// for each of them. The thread options and underflow policy of the sink that starts the shared
+/// thread apply then.
+///
+/// On destruction the sink drains its queue and flushes the wrapped sink. With many records queued
+/// and a slow wrapped sink this may take long, so the drain time may be limited by the
+/// `"deadline"` option in milliseconds. Records left after the deadline are abandoned, and their
+/// number is reported through the wrapped sink.
 ///
 /// \throw std::invalid_argument on construction if the factor is greater than 20.
-/// \throw std::invalid_argument on construction if the overflow policy value differs from "drop" or
-///     "wait".
+/// \throw std::invalid_argument on construction if the overflow policy is none of "drop", "wait",
+///     "watermark" or "spill", or if the spill policy has no "path".
+/// \throw std::invalid_argument on construction if the underflow policy value differs from "park"
+///     or "spin".
 class asynchronous_t;
 
+namespace asynchronous {
+
+/// Snapshot of dropped records counters.
+struct drops_t {
+    /// Number of distinct severity levels tracked. Negative severities are accounted as zero,
+    /// severities above the range as the last one.
+    static constexpr std::size_t severities = 16;
+
+    /// Number of dropped records by severity.
+    std::array<std::uint64_t, severities> counts;
+
+    drops_t() : counts() {}
+
+    /// Returns the total number of dropped records.
+    auto total() const noexcept -> std::uint64_t;
+
+    /// Returns the number of dropped records with the given severity.
+    auto at(severity_t severity) const noexcept -> std::uint64_t;
+
+    /// Returns counts accumulated since the given earlier snapshot.
+    auto since(const drops_t& other) const noexcept -> drops_t;
+
+    /// Maps severity to its bucket index.
+    static auto bucket(severity_t severity) noexcept -> std::size_t;
+};
+
+/// Public handle of sinks created by the asynchronous sink builder or factory, exposing their
+/// counters for metrics. Sinks created via config are reachable with `dynamic_cast`.
+class handle_t : public sink_t {
+public:
+    /// Returns the number of records dropped on queue overflow so far, summed over all workers.
+    ///
+    /// May be called from any thread.
+    virtual auto dropped() const -> drops_t = 0;
+
+    /// Returns the number of records given up because the wrapped sink has thrown, as decided by
+    /// the exception policy, summed over all workers.
+    ///
+    /// May be called from any thread.
+    virtual auto failed() const noexcept -> std::uint64_t = 0;
+};
+
+}  // namespace asynchronous
+
+/// Describes how the consumer merges records from different producer threads, when each of them
+/// has its own queue.
+enum class merge_t {
+    /// Records are emitted in the order of their timestamps, approximating the arrival order.
+    timestamp,
+    /// Only the order of records from the same thread is preserved, which is the cheapest option.
+    relaxed
+};
+
+/// Scheduling policy of the consumer thread, see `sched(7)`.
+enum class scheduler_t {
+    other,
+    /// Linux only.
+    batch,
+    /// Linux only.
+    idle,
+    fifo,
+    rr
+};
+
 }  // namespace sink
 
 template<>
@@ -57,9 +207,112 @@ public:
     auto wait() & -> builder&;
     auto wait() && -> builder&&;
 
+    /// Sets the wait overflow policy, which drops a record if no queue slot has been freed during
+    /// the given timeout.
+    auto wait(std::chrono::milliseconds timeout) & -> builder&;
+    auto wait(std::chrono::milliseconds timeout) && -> builder&&;
+
+    /// Sets the spill overflow policy, which appends records that do not fit in the queue to the
+    /// memory-mapped file at the given path, limited by the given size in bytes. They are emitted
+    /// once the queue has been drained, or after a restart if the process stops before. Each worker
+    /// of a pool gets its own file, with its index appended to the path, like "app.spill.0".
+    ///
+    /// \throw std::system_error on build if the file can not be opened or is used by another sink.
+    auto spill(std::string path, std::size_t size) & -> builder&;
+    auto spill(std::string path, std::size_t size) && -> builder&&;
+
+    /// Sets the single queue shared by all producer threads, which is the default one.
+    auto shared() & -> builder&;
+    auto shared() && -> builder&&;
+
+    /// Sets the sharded queue with a ring for each producer thread.
+    auto sharded(sink::merge_t merge = sink::merge_t::timestamp) & -> builder&;
+    auto sharded(sink::merge_t merge = sink::merge_t::timestamp) && -> builder&&;
+
+    /// Sets the byte ring queue with the given capacity in bytes, which keeps records serialized,
+    /// so its memory footprint does not depend on the number of records. The factor is ignored
+    /// then.
+    ///
+    /// \throw std::invalid_argument on build if the capacity does not fit in [1KiB; 4GiB) range.
+    auto bytes(std::size_t capacity) & -> builder&;
+    auto bytes(std::size_t capacity) && -> builder&&;
+
+    /// Sets the spin-then-park underflow policy, which is the default one.
+    auto park() & -> builder&;
+    auto park() && -> builder&&;
+
+    /// Sets the busy polling underflow policy.
+    auto spin() & -> builder&;
+    auto spin() && -> builder&&;
+
+    /// Sets the exception policy, which gives up batches the wrapped sink throws on. This is the
+    /// default one.
+    auto ignore() & -> builder&;
+    auto ignore() && -> builder&&;
+
+    /// Sets the exception policy, which emits a failed batch again up to the given number of
+    /// attempts, sleeping between them starting with the given backoff and doubling it each time.
+    ///
+    /// \throw std::invalid_argument if the number of attempts is zero, or on build if the sink
+    ///     shares the consumer thread with a group.
+    auto retry(std::size_t attempts, std::chrono::milliseconds backoff) & -> builder&;
+    auto retry(std::size_t attempts, std::chrono::milliseconds backoff) && -> builder&&;
+
+    /// Sets the exception policy, which emits batches the wrapped sink throws on to the given sink.
+    auto fallback(std::unique_ptr<sink_t> sink) & -> builder&;
+    auto fallback(std::unique_ptr<sink_t> sink) && -> builder&&;
+
+    /// Sets the number of worker threads, each with its own queue. By default records are routed
+    /// to workers by their producer thread.
+    auto workers(std::size_t count) & -> builder&;
+    auto workers(std::size_t count) && -> builder&&;
+
+    /// Routes records to workers by the value of the given attribute.
+    auto key(std::string attribute) & -> builder&;
+    auto key(std::string attribute) && -> builder&&;
+
+    /// Limits the time the sink drains its queue on destruction. Records left after the deadline
+    /// are abandoned, and their number is reported through the wrapped sink. Zero, which is the
+    /// default, means no limit.
+    auto deadline(std::chrono::milliseconds timeout) & -> builder&;
+    auto deadline(std::chrono::milliseconds timeout) && -> builder&&;
+
+    /// Sets the consumer thread name, at most 15 characters, shown by tools like `top`.
+    ///
+    /// \throw std::invalid_argument on build if the name is too long.
+    auto name(std::string value) & -> builder&;
+    auto name(std::string value) && -> builder&&;
+
+    /// Restricts the consumer thread to the given processors. Linux only.
+    ///
+    /// \throw std::system_error on build if the mask can not be applied.
+    auto affinity(std::vector<std::size_t> cpus) & -> builder&;
+    auto affinity(std::vector<std::size_t> cpus) && -> builder&&;
+
+    /// Sets the nice value of the consumer thread. Linux only.
+    ///
+    /// \throw std::system_error on build if the value can not be applied, for example lowering it
+    ///     requires privileges.
+    auto nice(int value) & -> builder&;
+    auto nice(int value) && -> builder&&;
+
+    /// Sets the scheduling policy of the consumer thread, with the given static priority for the
+    /// real-time ones.
+    ///
+    /// \throw std::system_error on build if the policy can not be applied.
+    auto scheduler(sink::scheduler_t policy, int priority = 0) & -> builder&;
+    auto scheduler(sink::scheduler_t policy, int priority = 0) && -> builder&&;
+
+    /// Shares the consumer thread with all other asynchronous sinks of the given group within the
+    /// process. The thread options and underflow policy of the sink that starts the thread apply.
+    ///
+    /// \throw std::invalid_argument on build if the retry exception policy is set.
+    auto group(std::string name) & -> builder&;
+    auto group(std::string name) && -> builder&&;
+
     /// Consumes this builder yielding a newly created asynchronous sink with the options
     /// configured.
-    auto build() && -> std::unique_ptr<sink_t>;
+    auto build() && -> std::unique_ptr<sink::asynchronous::handle_t>;
 };
 
 /// Represents asynchronous sink factory.
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+
+namespace blackhole {
+inline namespace v1 {
+namespace this_thread {
+
+/// Sets the name of the calling thread, shown by tools like `top`, and updates the name captured
+/// into records it logs.
+///
+/// Records capture the thread name cached per thread, so renames performed by other means, like
+/// `pthread_setname_np` or `prctl(PR_SET_NAME)`, are not noticed until `refresh` is called.
+///
+/// \throw std::system_error if the name is longer than 15 characters or the system fails to set
+///     it.
+auto set_name(const std::string& name) -> void;
+
+/// Discards the thread name cached for the calling thread, so the next record obtains it again.
+auto refresh() noexcept -> void;
+
+}  // namespace this_thread
+}  // namespace v1
+}  // namespace blackhole
@@ -23,6 +23,8 @@ public:
     auto log(severity_t severity, const message_t& message, attribute_pack& pack) -> void;
     auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
 
+    auto enabled(severity_t severity) const noexcept -> bool;
+
     auto manager() -> scope::manager_t&;
 };
 
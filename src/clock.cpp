@@ -0,0 +1,300 @@
+#include "blackhole/clock.hpp"
+
+#include <time.h>
+
+#if defined(__x86_64__)
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace blackhole {
+inline namespace v1 {
+namespace clock_source {
+namespace {
+
+class precise_t : public clock_source_t {
+public:
+    auto now() const noexcept -> time_point override {
+        return record_t::clock_type::now();
+    }
+};
+
+#if defined(__linux__)
+class coarse_t : public clock_source_t {
+public:
+    auto now() const noexcept -> time_point override {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+
+        return time_point(std::chrono::duration_cast<time_point::duration>(
+            std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+    }
+};
+#endif
+
+#if defined(__x86_64__)
+/// Checks whether the timestamp counter ticks at a constant rate regardless of frequency scaling
+/// and sleep states, which is required to convert it to the wall clock time.
+auto invariant_tsc() noexcept -> bool {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+        return false;
+    }
+
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1u << 8)) != 0;
+}
+
+/// Returns `(a * b) >> 32` without overflowing, provided that the result fits in 64 bits.
+constexpr auto mulshift(std::uint64_t a, std::uint64_t b) noexcept -> std::uint64_t {
+    return ((a >> 32) * (b >> 32) << 32) +
+        (a >> 32) * (b & 0xffffffff) +
+        (a & 0xffffffff) * (b >> 32) +
+        ((a & 0xffffffff) * (b & 0xffffffff) >> 32);
+}
+
+/// Converts TSC readings into the wall clock time.
+///
+/// The conversion parameters are published using a sequence lock, so readers never block and
+/// never write into shared memory. The only writer is the background thread, which periodically
+/// samples both clocks and adjusts the rate so that the converted time converges to the realtime
+/// clock by the next resync, without ever stepping back.
+class tsc_t : public clock_source_t {
+    struct sample_t {
+        std::uint64_t tsc;
+        std::uint64_t ns;
+    };
+
+    /// Offsets from the realtime clock larger than this mean that it has been set, so the clock
+    /// follows it immediately, like the precise one does.
+    static constexpr std::int64_t step_threshold = 1000000000;
+
+    /// Maximum slew, relative to the measured rate, the same as `adjtime` uses.
+    static constexpr double max_slew = 0.0005;
+
+    std::atomic<std::uint64_t> sequence;
+
+    /// Time point at which the conversion parameters were calculated.
+    std::atomic<std::uint64_t> base_tsc;
+    std::atomic<std::uint64_t> base_ns;
+    /// Nanoseconds per tick in 32.32 fixed point.
+    std::atomic<std::uint64_t> rate;
+
+    sample_t prev;
+    /// Nanoseconds per tick measured over the last interval.
+    double measured;
+
+    bool stopped;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+public:
+    tsc_t() :
+        sequence(0),
+        base_tsc(0),
+        base_ns(0),
+        rate(0),
+        measured(0.0),
+        stopped(false)
+    {
+        prev = sample();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        const auto next = sample();
+        measured = measure(prev, next);
+        publish(next.tsc, next.ns, measured);
+        prev = next;
+
+        thread = std::thread(&tsc_t::run, this);
+    }
+
+    ~tsc_t() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+
+        cv.notify_one();
+        thread.join();
+    }
+
+    auto now() const noexcept -> time_point override {
+        return time_point(std::chrono::duration_cast<time_point::duration>(
+            std::chrono::nanoseconds(convert(__rdtsc()))));
+    }
+
+private:
+    /// Converts the given TSC reading to nanoseconds since epoch.
+    auto convert(std::uint64_t current) const noexcept -> std::uint64_t {
+        std::uint64_t seq;
+        std::uint64_t tsc;
+        std::uint64_t ns;
+        std::uint64_t rate;
+
+        do {
+            seq = sequence.load(std::memory_order_acquire);
+            tsc = base_tsc.load(std::memory_order_relaxed);
+            ns = base_ns.load(std::memory_order_relaxed);
+            rate = this->rate.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != sequence.load(std::memory_order_relaxed));
+
+        // Counters of different cores may be slightly out of sync, never go before the base.
+        const auto delta = current > tsc ? current - tsc : 0;
+        return ns + mulshift(delta, rate);
+    }
+
+    static auto realtime() noexcept -> std::uint64_t {
+        struct timespec ts;
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 +
+            static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    /// Reads both clocks as close to each other as possible, taking the best of several attempts
+    /// to filter out preemptions.
+    static auto sample() noexcept -> sample_t {
+        sample_t result{0, 0};
+        auto window = ~std::uint64_t(0);
+
+        for (int i = 0; i < 8; ++i) {
+            const auto before = __rdtsc();
+            const auto ns = realtime();
+            const auto after = __rdtsc();
+
+            if (after - before < window) {
+                window = after - before;
+                result = {before + (after - before) / 2, ns};
+            }
+        }
+
+        return result;
+    }
+
+    /// Returns nanoseconds per tick between the given samples.
+    static auto measure(const sample_t& prev, const sample_t& next) noexcept -> double {
+        return static_cast<double>(next.ns - prev.ns) / static_cast<double>(next.tsc - prev.tsc);
+    }
+
+    auto publish(std::uint64_t tsc, std::uint64_t ns, double rate) noexcept -> void {
+        const auto seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        base_tsc.store(tsc, std::memory_order_relaxed);
+        base_ns.store(ns, std::memory_order_relaxed);
+        this->rate.store(static_cast<std::uint64_t>(std::ldexp(rate, 32)),
+            std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    auto resync() noexcept -> void {
+        const auto next = sample();
+        if (next.tsc <= prev.tsc) {
+            return;
+        }
+
+        // Converted time at the sample point, which becomes the new base, so the clock stays
+        // continuous.
+        const auto current = convert(next.tsc);
+        const auto offset = static_cast<std::int64_t>(next.ns - current);
+
+        if (offset > step_threshold || offset < -step_threshold) {
+            publish(next.tsc, next.ns, measured);
+            prev = next;
+            return;
+        }
+
+        if (next.ns > prev.ns) {
+            measured = measure(prev, next);
+        }
+
+        // Catch up with the realtime clock over the next interval, which is expected to be as
+        // long as the last one.
+        const auto interval = static_cast<double>(next.tsc - prev.tsc);
+        const auto limit = measured * max_slew;
+        const auto slew = std::max(-limit, std::min(limit, static_cast<double>(offset) / interval));
+
+        publish(next.tsc, current, measured + slew);
+        prev = next;
+    }
+
+    auto run() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!cv.wait_for(lock, std::chrono::seconds(1), [&] { return stopped; })) {
+            resync();
+        }
+    }
+};
+
+constexpr std::int64_t tsc_t::step_threshold;
+constexpr double tsc_t::max_slew;
+#endif
+
+}  // namespace
+
+auto precise() -> std::shared_ptr<clock_source_t> {
+    static const std::shared_ptr<clock_source_t> instance = std::make_shared<precise_t>();
+    return instance;
+}
+
+auto coarse() -> std::shared_ptr<clock_source_t> {
+#if defined(__linux__)
+    static const std::shared_ptr<clock_source_t> instance = std::make_shared<coarse_t>();
+    return instance;
+#else
+    return precise();
+#endif
+}
+
+auto tsc() -> std::shared_ptr<clock_source_t> {
+#if defined(__x86_64__)
+    static const bool supported = invariant_tsc();
+    if (!supported) {
+        return precise();
+    }
+
+    static std::mutex mutex;
+    static std::weak_ptr<clock_source_t> instance;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (auto result = instance.lock()) {
+        return result;
+    }
+
+    std::shared_ptr<clock_source_t> result = std::make_shared<tsc_t>();
+    instance = result;
+    return result;
+#else
+    return precise();
+#endif
+}
+
+auto create(const std::string& name) -> std::shared_ptr<clock_source_t> {
+    if (name == "precise") {
+        return precise();
+    } else if (name == "coarse") {
+        return coarse();
+    } else if (name == "tsc") {
+        return tsc();
+    }
+
+    throw std::invalid_argument("no clock source with name \"" + name + "\" found");
+}
+
+}  // namespace clock_source
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,76 @@
+#include "epoch.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace epoch {
+namespace {
+
+struct domain_t {
+    std::atomic<std::uint64_t> epoch;
+    std::atomic<participant_t*> head;
+
+    domain_t() noexcept :
+        epoch(1),
+        head(nullptr)
+    {}
+};
+
+// Intentionally leaked to outlive thread-local participant holders of detached threads, which may
+// be destroyed after static objects.
+auto domain() -> domain_t& {
+    static domain_t* instance = new domain_t;
+    return *instance;
+}
+
+}  // namespace
+
+auto global() noexcept -> std::atomic<std::uint64_t>& {
+    return domain().epoch;
+}
+
+auto acquire() -> participant_t* {
+    auto& domain = epoch::domain();
+
+    for (auto it = domain.head.load(std::memory_order_acquire); it; it = it->next) {
+        bool expected = false;
+        if (it->acquired.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return it;
+        }
+    }
+
+    auto participant = new participant_t;
+    participant->epoch.store(0, std::memory_order_relaxed);
+    participant->acquired.store(true, std::memory_order_relaxed);
+    participant->next = domain.head.load(std::memory_order_relaxed);
+
+    while (!domain.head.compare_exchange_weak(participant->next, participant,
+        std::memory_order_release, std::memory_order_relaxed))
+    {}
+
+    return participant;
+}
+
+auto release(participant_t* participant) noexcept -> void {
+    participant->epoch.store(0, std::memory_order_release);
+    participant->acquired.store(false, std::memory_order_release);
+}
+
+auto advance() noexcept -> std::uint64_t {
+    return global().fetch_add(1, std::memory_order_seq_cst) + 1;
+}
+
+auto synchronized(std::uint64_t epoch) noexcept -> bool {
+    for (auto it = domain().head.load(std::memory_order_acquire); it; it = it->next) {
+        const auto observed = it->epoch.load(std::memory_order_seq_cst);
+
+        if (observed != 0 && observed < epoch) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace epoch
+}  // namespace v1
+}  // namespace blackhole
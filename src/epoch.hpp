@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace epoch {
+
+/// Represents a reader slot in the epoch-based reclamation domain.
+///
+/// Each thread that has ever entered a read-side critical section exclusively owns one participant
+/// until its exit. The only value written on the read path is the participant's epoch, which lives
+/// on its own cache line, so readers never write to the memory shared with other readers.
+struct participant_t {
+    char head[64];
+
+    /// Epoch observed when entering the outermost read-side critical section, zero if quiescent.
+    std::atomic<std::uint64_t> epoch;
+    std::atomic<bool> acquired;
+    participant_t* next;
+
+    char tail[64];
+};
+
+/// Returns a global epoch counter.
+///
+/// The counter starts from one, because zero is reserved to mark quiescent participants.
+auto global() noexcept -> std::atomic<std::uint64_t>&;
+
+/// Acquires a free participant or registers a new one.
+///
+/// Participants are never deallocated, they are returned to the pool on thread exit instead.
+auto acquire() -> participant_t*;
+
+/// Returns the given participant back to the pool.
+auto release(participant_t* participant) noexcept -> void;
+
+/// Advances the global epoch, returning its new value.
+///
+/// Any object unlinked before this call can be safely reclaimed after `synchronized` returns true
+/// for the returned epoch.
+auto advance() noexcept -> std::uint64_t;
+
+/// Checks whether there are no readers left, that entered their critical sections before the given
+/// epoch has been published.
+auto synchronized(std::uint64_t epoch) noexcept -> bool;
+
+namespace detail {
+
+class local_t {
+public:
+    participant_t* participant;
+    std::size_t nesting;
+
+    constexpr local_t() noexcept :
+        participant(nullptr),
+        nesting(0)
+    {}
+
+    ~local_t() {
+        if (participant) {
+            release(participant);
+        }
+    }
+};
+
+inline auto local() noexcept -> local_t& {
+    static thread_local local_t value;
+    return value;
+}
+
+}  // namespace detail
+
+/// RAII read-side critical section guard.
+///
+/// While at least one guard is alive on the current thread no object, that was reachable at the
+/// moment of the outermost guard construction, will be reclaimed. Guards may be nested, for
+/// example when a handler logs through another logger.
+class guard_t {
+    detail::local_t& local;
+
+public:
+    guard_t() :
+        local(detail::local())
+    {
+        if (local.nesting++ == 0) {
+            if (local.participant == nullptr) {
+                local.participant = acquire();
+            }
+
+            // Sequentially consistent store is required here to order the published epoch before
+            // any further load of the protected pointer.
+            local.participant->epoch.store(global().load(std::memory_order_acquire),
+                std::memory_order_seq_cst);
+        }
+    }
+
+    guard_t(const guard_t& other) = delete;
+    guard_t(guard_t&& other) = delete;
+
+    ~guard_t() {
+        if (--local.nesting == 0) {
+            local.participant->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    auto operator=(const guard_t& other) -> guard_t& = delete;
+    auto operator=(guard_t&& other) -> guard_t& = delete;
+};
+
+}  // namespace epoch
+}  // namespace v1
+}  // namespace blackhole
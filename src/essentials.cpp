@@ -4,6 +4,7 @@
 #include "blackhole/formatter/json.hpp"
 #include "blackhole/formatter/string.hpp"
 #include "blackhole/formatter/tskv.hpp"
+#include "blackhole/handler/asynchronous.hpp"
 #include "blackhole/handler/blocking.hpp"
 #include "blackhole/handler/dev.hpp"
 #include "blackhole/registry.hpp"
@@ -33,6 +34,7 @@ auto essentials(registry_t& registry) -> void {
     registry.add<sink::socket::udp_t>(registry);
     registry.add<sink::syslog_t>(registry);
 
+    registry.add<handler::asynchronous_t>(registry);
     registry.add<handler::blocking_t>(registry);
     // registry.add<handler::dev_t>(registry);
 }
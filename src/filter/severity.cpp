@@ -1,5 +1,8 @@
 #include "blackhole/filter/severity.hpp"
 
+#include <cstdint>
+#include <limits>
+
 #include <boost/optional/optional.hpp>
 
 #include "blackhole/config/node.hpp"
@@ -14,18 +17,30 @@ inline namespace v1 {
 namespace filter {
 
 class severity_t : public filter_t {
-    std::int64_t threshold;
+    std::int64_t value;
 
 public:
-    severity_t(std::int64_t threshold) noexcept : threshold(threshold) {}
+    severity_t(std::int64_t threshold) noexcept : value(threshold) {}
 
     auto filter(const record_t& record) -> filter_t::action_t override {
-        if (record.severity() >= threshold) {
+        if (record.severity() >= value) {
             return filter_t::action_t::neutral;
         } else {
             return filter_t::action_t::deny;
         }
     }
+
+    auto threshold() const noexcept -> blackhole::severity_t override {
+        if (value < std::numeric_limits<int>::min()) {
+            return std::numeric_limits<int>::min();
+        }
+
+        if (value > std::numeric_limits<int>::max()) {
+            return std::numeric_limits<int>::max();
+        }
+
+        return static_cast<int>(value);
+    }
 };
 
 }  // namespace filter
@@ -0,0 +1,126 @@
+#include "shared.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include "blackhole/extensions/writer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+/// Cached outputs larger than this are released when overwritten, so a single huge record does not
+/// pin its memory for the thread lifetime.
+constexpr std::size_t shrink_threshold = 64 * 1024;
+
+/// Output of a shared formatter for some record.
+struct entry_t {
+    const formatter_t* formatter;
+    /// Dispatch scope the output belongs to, zero means none.
+    std::uint64_t id;
+    /// Set while the formatter writes into the entry, so nested scopes do not reuse it.
+    bool busy;
+    writer_t writer;
+};
+
+/// Per-thread state of dispatch scopes.
+struct cache_t {
+    /// Record of the innermost scope, null outside of any scope.
+    const record_t* record = nullptr;
+    std::uint64_t id = 0;
+    /// Source of scope ids, unique per thread.
+    std::uint64_t counter = 0;
+    /// Entries keep their buffers between records.
+    std::vector<std::unique_ptr<entry_t>> entries;
+};
+
+auto cache() -> cache_t& {
+    static thread_local cache_t value;
+    return value;
+}
+
+auto append(writer_t& writer, const writer_t& output) -> void {
+    const auto result = output.result();
+    writer.inner << fmt::StringRef(result.data(), result.size());
+}
+
+}  // namespace
+
+shared_t::shared_t(std::shared_ptr<formatter_t> inner) noexcept :
+    inner(std::move(inner))
+{}
+
+auto shared_t::format(const record_t& record, writer_t& writer) -> void {
+    auto& cache = formatter::cache();
+
+    // The reference count is fixed once the logger has been built.
+    if (cache.record != &record || inner.use_count() == 1) {
+        inner->format(record, writer);
+        return;
+    }
+
+    const auto id = cache.id;
+
+    entry_t* slot = nullptr;
+    for (auto& entry : cache.entries) {
+        if (entry->formatter != inner.get() || entry->busy) {
+            continue;
+        }
+
+        if (entry->id == id) {
+            append(writer, entry->writer);
+            return;
+        }
+
+        slot = entry.get();
+    }
+
+    if (slot == nullptr) {
+        std::unique_ptr<entry_t> entry(new entry_t);
+        entry->formatter = inner.get();
+        entry->busy = false;
+        slot = entry.get();
+        cache.entries.push_back(std::move(entry));
+    }
+
+    if (slot->writer.inner.size() > shrink_threshold) {
+        slot->writer.inner = fmt::MemoryWriter();
+    } else {
+        slot->writer.inner.clear();
+    }
+
+    slot->id = 0;
+    slot->busy = true;
+    try {
+        inner->format(record, slot->writer);
+    } catch (...) {
+        slot->busy = false;
+        throw;
+    }
+
+    slot->busy = false;
+    slot->id = id;
+    append(writer, slot->writer);
+}
+
+dispatch_t::dispatch_t(const record_t& record) noexcept {
+    auto& cache = formatter::cache();
+
+    this->record = cache.record;
+    this->id = cache.id;
+
+    cache.record = &record;
+    cache.id = ++cache.counter;
+}
+
+dispatch_t::~dispatch_t() {
+    auto& cache = formatter::cache();
+
+    cache.record = record;
+    cache.id = id;
+}
+
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
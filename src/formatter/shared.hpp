@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "blackhole/formatter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// Formatter instance shared by several handlers configured with identical formatters.
+///
+/// While a record is being dispatched within a `dispatch_t` scope the wrapped formatter is invoked
+/// at most once for it, other handlers receive a copy of its output. Outside of such scope, for
+/// example on background threads of asynchronous handlers, or when the instance is not actually
+/// shared, it formats directly into the given writer.
+class shared_t : public formatter_t {
+    std::shared_ptr<formatter_t> inner;
+
+public:
+    explicit shared_t(std::shared_ptr<formatter_t> inner) noexcept;
+
+    auto format(const record_t& record, writer_t& writer) -> void override;
+};
+
+/// Scope of dispatching a single record to handlers on the calling thread.
+///
+/// Outputs of shared formatters computed for the record are cached until the scope ends. Scopes may
+/// nest, for example when a sink logs itself, each one caches only its own record.
+class dispatch_t {
+    const record_t* record;
+    std::uint64_t id;
+
+public:
+    explicit dispatch_t(const record_t& record) noexcept;
+
+    dispatch_t(const dispatch_t& other) = delete;
+    auto operator=(const dispatch_t& other) -> dispatch_t& = delete;
+
+    ~dispatch_t();
+};
+
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -1,7 +1,5 @@
 #include "blackhole/formatter/string.hpp"
 
-#include <array>
-
 #include <boost/type_traits/remove_cv.hpp>
 #include <boost/variant/apply_visitor.hpp>
 #include <boost/variant/get.hpp>
@@ -206,11 +204,8 @@ public:
     }
 
     auto operator()(const ph::thread<name>& token) const -> void {
-        std::array<char, 16> buffer;
-        const auto rc = ::pthread_getname_np(record.tid(), buffer.data(), buffer.size());
-
-        if (rc == 0) {
-            writer.write(token.spec, buffer.data());
+        if (const auto name = record.thread_name()) {
+            writer.write(token.spec, name);
         } else {
             writer.write(token.spec, "<unnamed>");
         }
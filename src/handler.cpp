@@ -1,9 +1,27 @@
 #include "blackhole/handler.hpp"
 
+#include <limits>
+
+#include "blackhole/factory.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 
 handler_t::~handler_t() = default;
 
+auto handler_t::threshold() const noexcept -> severity_t {
+    return std::numeric_limits<int>::min();
+}
+
+auto handler_t::flush(std::chrono::milliseconds) -> bool {
+    return true;
+}
+
+auto factory<handler_t>::from(const config::node_t& config, const registry_t&) const ->
+    std::unique_ptr<handler_t>
+{
+    return from(config);
+}
+
 }  // namespace v1
 }  // namespace blackhole
@@ -0,0 +1,572 @@
+#include "blackhole/handler/asynchronous.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/filter.hpp"
+#include "blackhole/formatter.hpp"
+#include "blackhole/registry.hpp"
+#include "blackhole/sink.hpp"
+
+#include "../memory.hpp"
+#include "../sink/asynchronous.hpp"
+#include "../util/deleter.hpp"
+#include "asynchronous.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+/// A throwing filter denies the record, there is nobody to report to on the worker thread.
+auto accepts(const asynchronous_t::target_t& target, const record_t& record) noexcept -> bool {
+    if (target.filter == nullptr) {
+        return true;
+    }
+
+    filter_t::action_t action;
+
+    try {
+        action = target.filter->filter(record);
+    } catch (...) {
+        return false;
+    }
+
+    switch (action) {
+    case filter_t::action_t::neutral:
+    case filter_t::action_t::accept:
+        return true;
+    case filter_t::action_t::deny:
+        return false;
+    }
+
+    return true;
+}
+
+auto into_targets(std::vector<std::unique_ptr<sink_t>> sinks) ->
+    std::vector<asynchronous_t::target_t>
+{
+    std::vector<asynchronous_t::target_t> targets;
+    targets.reserve(sinks.size());
+    for (auto& sink : sinks) {
+        targets.push_back({std::move(sink), nullptr});
+    }
+
+    return targets;
+}
+
+}  // namespace
+
+constexpr std::size_t asynchronous_t::batch_limit;
+
+asynchronous_t::asynchronous_t(std::unique_ptr<formatter_t> formatter,
+                               std::vector<std::unique_ptr<sink_t>> sinks,
+                               std::unique_ptr<sink::asynchronous::queue_t> queue,
+                               std::unique_ptr<sink::overflow_policy_t> overflow_policy,
+                               std::unique_ptr<sink::underflow_policy_t> underflow_policy) :
+    asynchronous_t(std::move(formatter), into_targets(std::move(sinks)), std::move(queue),
+        std::move(overflow_policy), std::move(underflow_policy))
+{}
+
+asynchronous_t::asynchronous_t(std::unique_ptr<formatter_t> formatter,
+                               std::vector<target_t> targets,
+                               std::unique_ptr<sink::asynchronous::queue_t> queue,
+                               std::unique_ptr<sink::overflow_policy_t> overflow_policy,
+                               std::unique_ptr<sink::underflow_policy_t> underflow_policy,
+                               std::chrono::milliseconds deadline) :
+    formatter(std::move(formatter)),
+    targets(std::move(targets)),
+    queue(std::move(queue)),
+    overflow_policy(std::move(overflow_policy)),
+    underflow_policy(std::move(underflow_policy)),
+    stopped(false),
+    deadline(deadline),
+    requested(0),
+    completed(0)
+{
+    if (this->overflow_policy->observes()) {
+        this->queue->track();
+    }
+
+    thread = std::thread(std::bind(&asynchronous_t::run, this));
+}
+
+asynchronous_t::~asynchronous_t() {
+    // Published to the worker by the stop flag.
+    until = std::chrono::steady_clock::now() + deadline;
+    stopped.store(true);
+    underflow_policy->wakeup();
+    thread.join();
+}
+
+auto asynchronous_t::handle(const record_t& record) -> void {
+    while (true) {
+        if (!overflow_policy->admit(record, *queue)) {
+            drops.add(record.severity());
+            return;
+        }
+
+        bool enqueued;
+
+        try {
+            enqueued = queue->push(record, string_view());
+        } catch (const std::length_error&) {
+            // The record would never fit in the queue.
+            drops.add(record.severity());
+            return;
+        }
+
+        if (enqueued) {
+            underflow_policy->wakeup();
+            return;
+        }
+
+        const auto action = overflow_policy->overflow(record, string_view(), [&]() -> bool {
+            return queue->empty();
+        });
+
+        switch (action) {
+        case sink::overflow_policy_t::action_t::retry:
+            continue;
+        case sink::overflow_policy_t::action_t::drop:
+            drops.add(record.severity());
+            return;
+        case sink::overflow_policy_t::action_t::done:
+            underflow_policy->wakeup();
+            return;
+        }
+    }
+}
+
+auto asynchronous_t::threshold() const noexcept -> severity_t {
+    auto result = std::numeric_limits<int>::max();
+    for (const auto& target : targets) {
+        result = std::min<int>(result, target.threshold());
+    }
+
+    return result;
+}
+
+auto asynchronous_t::flush(std::chrono::milliseconds timeout) -> bool {
+    std::uint64_t ticket;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ticket = requested.load(std::memory_order_relaxed) + 1;
+        requests.push_back({ticket, queue->mark()});
+
+        // Published last, so the worker finds the request once it notices a new ticket.
+        requested.store(ticket, std::memory_order_release);
+    }
+
+    underflow_policy->wakeup();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    return cv.wait_for(lock, timeout, [&]() -> bool {
+        return completed.load(std::memory_order_acquire) >= ticket;
+    });
+}
+
+auto asynchronous_t::settle() -> bool {
+    if (requested.load(std::memory_order_acquire) == completed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    std::uint64_t ticket = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& request : requests) {
+            if (!queue->passed(request.mark)) {
+                break;
+            }
+
+            ticket = request.ticket;
+        }
+    }
+
+    if (ticket == 0) {
+        return false;
+    }
+
+    for (auto& target : targets) {
+        try {
+            target.sink->flush();
+        } catch (...) {
+            // Flush failures are of no interest to anyone waiting, the next flush will try again.
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.store(ticket, std::memory_order_release);
+
+        auto it = requests.begin();
+        while (it != requests.end() && it->ticket <= ticket) {
+            ++it;
+        }
+        requests.erase(requests.begin(), it);
+    }
+
+    cv.notify_all();
+    return true;
+}
+
+auto asynchronous_t::run() -> void {
+    // Formatted messages are stored in the slots themselves, which retain their storage across
+    // records, so the steady state formatting does not allocate.
+    std::vector<sink::asynchronous::slot_t> pending(std::min(queue->capacity(), batch_limit));
+    std::vector<record_t> records;
+    std::vector<sink_t::entry_t> entries;
+    records.reserve(pending.size());
+    entries.reserve(pending.size());
+
+    // Filter decisions of each emitted entry for each target, and entries of a single target.
+    std::vector<char> decisions;
+    std::vector<sink_t::entry_t> selected;
+    decisions.reserve(pending.size() * targets.size());
+    selected.reserve(pending.size());
+
+    writer_t writer;
+    sink::asynchronous::drops_t reported;
+
+    while (true) {
+        if (deadline.count() > 0 && stopped && std::chrono::steady_clock::now() >= until) {
+            abandon();
+            return;
+        }
+
+        std::size_t count = 0;
+        while (count < pending.size()) {
+            if (!queue->pop(pending[count])) {
+                break;
+            }
+
+            ++count;
+            overflow_policy->wakeup();
+        }
+
+        if (count == 0) {
+            while (count < pending.size() && overflow_policy->replay(pending[count])) {
+                ++count;
+            }
+        }
+
+        if (count == 0) {
+            // The queue has recovered, so it is time to tell how many records have been lost.
+            report(reported);
+
+            if (settle()) {
+                continue;
+            }
+
+            if (stopped) {
+                return;
+            }
+
+            underflow_policy->underflow([&]() -> bool {
+                return stopped.load() || !queue->empty() ||
+                    requested.load(std::memory_order_acquire) !=
+                        completed.load(std::memory_order_relaxed);
+            });
+
+            continue;
+        }
+
+        records.clear();
+        entries.clear();
+        decisions.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            auto& slot = pending[i];
+
+            if (!slot.valid) {
+                continue;
+            }
+
+            records.push_back(slot.record.into_view());
+
+            bool wanted = false;
+            for (const auto& target : targets) {
+                const bool accepted = accepts(target, records.back());
+                decisions.push_back(accepted);
+                wanted = wanted || accepted;
+            }
+
+            writer.inner.clear();
+
+            try {
+                if (wanted) {
+                    formatter->format(records.back(), writer);
+                }
+            } catch (...) {
+                // There is nobody to report to, the record is dropped.
+                wanted = false;
+            }
+
+            if (!wanted) {
+                records.pop_back();
+                decisions.resize(decisions.size() - targets.size());
+                continue;
+            }
+
+            slot.message.assign(writer.inner.data(), writer.inner.size());
+            entries.push_back({records.back(), slot.message});
+        }
+
+        for (std::size_t t = 0; t < targets.size() && !entries.empty(); ++t) {
+            selected.clear();
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (decisions[i * targets.size() + t]) {
+                    selected.push_back(entries[i]);
+                }
+            }
+
+            if (selected.empty()) {
+                continue;
+            }
+
+            try {
+                targets[t].sink->emit_batch(sink_t::batch_t(selected.data(), selected.size()));
+            } catch (...) {
+                // Other sinks must not suffer from the failure of this one.
+            }
+        }
+
+        settle();
+    }
+}
+
+auto asynchronous_t::abandon() -> void {
+    std::uint64_t count = 0;
+    severity_t severity = 0;
+
+    sink::asynchronous::slot_t slot;
+    while (queue->pop(slot)) {
+        overflow_policy->wakeup();
+
+        if (slot.valid) {
+            ++count;
+            severity = std::max<int>(severity, slot.record.into_view().severity());
+        }
+    }
+
+    if (count > 0) {
+        writer_t writer;
+        writer.write("abandoned {} records on shutdown", count);
+        announce(severity, writer.result());
+    }
+
+    // Nobody can wait for flush requests while the handler is being destroyed, but the worker must
+    // not leave any behind.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.store(requested.load(std::memory_order_relaxed), std::memory_order_release);
+        requests.clear();
+    }
+
+    cv.notify_all();
+}
+
+auto asynchronous_t::announce(severity_t severity, const string_view& message) -> void {
+    const attribute_pack pack;
+    record_t record(severity, message, pack);
+    record.activate(message);
+
+    writer_t writer;
+
+    try {
+        formatter->format(record, writer);
+    } catch (...) {
+        // Synthetic records are best effort.
+        return;
+    }
+
+    for (auto& target : targets) {
+        if (!accepts(target, record)) {
+            continue;
+        }
+
+        try {
+            target.sink->emit(record, writer.result());
+        } catch (...) {
+            // Synthetic records are best effort.
+        }
+    }
+}
+
+auto asynchronous_t::report(sink::asynchronous::drops_t& reported) -> void {
+    if (!drops.reset()) {
+        return;
+    }
+
+    const auto snapshot = drops.snapshot();
+    const auto delta = snapshot.since(reported);
+    reported = snapshot;
+
+    if (delta.total() == 0) {
+        return;
+    }
+
+    writer_t writer;
+    const auto severity = sink::asynchronous::describe(delta, writer);
+
+    announce(severity, writer.result());
+}
+
+}  // namespace handler
+
+using handler::asynchronous_t;
+
+class builder<asynchronous_t>::inner_t {
+public:
+    std::unique_ptr<formatter_t> formatter;
+    std::vector<asynchronous_t::target_t> targets;
+    std::size_t factor;
+    std::unique_ptr<sink::overflow_policy_t> overflow_policy;
+    std::chrono::milliseconds deadline;
+};
+
+builder<asynchronous_t>::builder() :
+    d(new inner_t{nullptr, {}, 10, sink::overflow_policy_factory_t().create("wait"),
+        std::chrono::milliseconds::zero()})
+{}
+
+auto builder<asynchronous_t>::set(std::unique_ptr<formatter_t> formatter) & -> builder& {
+    d->formatter = std::move(formatter);
+    return *this;
+}
+
+auto builder<asynchronous_t>::set(std::unique_ptr<formatter_t> formatter) && -> builder&& {
+    return std::move(set(std::move(formatter)));
+}
+
+auto builder<asynchronous_t>::add(std::unique_ptr<sink_t> sink) & -> builder& {
+    return add(std::move(sink), nullptr);
+}
+
+auto builder<asynchronous_t>::add(std::unique_ptr<sink_t> sink) && -> builder&& {
+    return std::move(add(std::move(sink)));
+}
+
+auto builder<asynchronous_t>::add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) &
+    -> builder&
+{
+    d->targets.push_back({std::move(sink), std::move(filter)});
+    return *this;
+}
+
+auto builder<asynchronous_t>::add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) &&
+    -> builder&&
+{
+    return std::move(add(std::move(sink), std::move(filter)));
+}
+
+auto builder<asynchronous_t>::factor(std::size_t value) & -> builder& {
+    d->factor = value;
+    return *this;
+}
+
+auto builder<asynchronous_t>::factor(std::size_t value) && -> builder&& {
+    return std::move(factor(value));
+}
+
+auto builder<asynchronous_t>::drop() & -> builder& {
+    d->overflow_policy = sink::overflow_policy_factory_t().create("drop");
+    return *this;
+}
+
+auto builder<asynchronous_t>::drop() && -> builder&& {
+    return std::move(drop());
+}
+
+auto builder<asynchronous_t>::wait() & -> builder& {
+    d->overflow_policy = sink::overflow_policy_factory_t().create("wait");
+    return *this;
+}
+
+auto builder<asynchronous_t>::wait() && -> builder&& {
+    return std::move(wait());
+}
+
+auto builder<asynchronous_t>::deadline(std::chrono::milliseconds timeout) & -> builder& {
+    d->deadline = timeout;
+    return *this;
+}
+
+auto builder<asynchronous_t>::deadline(std::chrono::milliseconds timeout) && -> builder&& {
+    return std::move(deadline(timeout));
+}
+
+auto builder<asynchronous_t>::build() && -> std::unique_ptr<handler_t> {
+    return blackhole::make_unique<asynchronous_t>(std::move(d->formatter), std::move(d->targets),
+        sink::asynchronous::queue_factory_t().create("shared", d->factor),
+        std::move(d->overflow_policy), sink::underflow_policy_factory_t().create("park"),
+        d->deadline);
+}
+
+auto factory<asynchronous_t>::type() const noexcept -> const char* {
+    return "asynchronous";
+}
+
+auto factory<asynchronous_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<handler_t>
+{
+    return from(config, registry);
+}
+
+auto factory<asynchronous_t>::from(const config::node_t& config,
+    const registry_t& registry) const -> std::unique_ptr<handler_t>
+{
+    std::unique_ptr<formatter_t> formatter;
+
+    if (auto type = config["formatter"]["type"].to_string()) {
+        formatter = registry.formatter(type.get())(*config["formatter"].unwrap());
+    } else {
+        throw std::invalid_argument("each handler must have a formatter with type");
+    }
+
+    std::vector<asynchronous_t::target_t> targets;
+
+    config["sinks"].each([&](const config::node_t& config) {
+        auto type = config["type"].to_string();
+
+        if (!type) {
+            throw std::invalid_argument("each sink must have a type");
+        }
+
+        std::unique_ptr<filter_t> filter;
+        if (auto filter_type = config["filter"]["type"].to_string()) {
+            filter = registry.filter(filter_type.get())(*config["filter"].unwrap());
+        } else if (config["filter"].unwrap()) {
+            throw std::invalid_argument("each sink filter must have a type");
+        }
+
+        targets.push_back({registry.sink(type.get())(config), std::move(filter)});
+    });
+
+    const auto factor = config["factor"].to_uint64().get_value_or(10);
+    const auto queue = config["queue"].to_string().get_value_or("shared");
+    const auto overflow = config["overflow"].to_string().get_value_or("wait");
+    const auto underflow = config["underflow"].to_string().get_value_or("park");
+    const auto deadline = std::chrono::milliseconds(config["deadline"].to_uint64().get_value_or(0));
+
+    return blackhole::make_unique<asynchronous_t>(std::move(formatter), std::move(targets),
+        sink::asynchronous::queue_factory_t().create(queue, factor),
+        sink::overflow_policy_factory_t().create(overflow),
+        sink::underflow_policy_factory_t().create(underflow), deadline);
+}
+
+template auto deleter_t::operator()(builder<handler::asynchronous_t>::inner_t*) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "blackhole/handler.hpp"
+#include "blackhole/forward.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/severity.hpp"
+
+#include "../sink/asynchronous/drops.hpp"
+#include "blocking.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+class overflow_policy_t;
+class underflow_policy_t;
+
+namespace asynchronous {
+
+class queue_t;
+
+typedef std::vector<std::uint64_t> mark_t;
+
+}  // namespace asynchronous
+}  // namespace sink
+
+namespace handler {
+
+class asynchronous_t : public handler_t {
+public:
+    /// Sink along with the filter deciding which records it receives, the same as for the blocking
+    /// handler.
+    typedef blocking_t::target_t target_t;
+
+private:
+    /// Maximum number of records the worker thread drains from the queue at once.
+    static constexpr std::size_t batch_limit = 64;
+
+    std::unique_ptr<formatter_t> formatter;
+    std::vector<target_t> targets;
+
+    std::unique_ptr<sink::asynchronous::queue_t> queue;
+    std::unique_ptr<sink::overflow_policy_t> overflow_policy;
+    std::unique_ptr<sink::underflow_policy_t> underflow_policy;
+
+    std::atomic<bool> stopped;
+
+    sink::asynchronous::drop_counter_t drops;
+
+    /// Maximum time to drain the queue on destruction, zero means no limit.
+    const std::chrono::milliseconds deadline;
+    std::chrono::steady_clock::time_point until;
+
+    /// Flush request with the queue position at the moment it was made.
+    struct request_t {
+        std::uint64_t ticket;
+        sink::asynchronous::mark_t mark;
+    };
+
+    /// Flush requests are numbered, the worker completes them in order once it has emitted all
+    /// records enqueued before them.
+    std::atomic<std::uint64_t> requested;
+    std::atomic<std::uint64_t> completed;
+    /// Outstanding requests, guarded by the mutex.
+    std::vector<request_t> requests;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    std::thread thread;
+
+public:
+    asynchronous_t(std::unique_ptr<formatter_t> formatter,
+                   std::vector<std::unique_ptr<sink_t>> sinks,
+                   std::unique_ptr<sink::asynchronous::queue_t> queue,
+                   std::unique_ptr<sink::overflow_policy_t> overflow_policy,
+                   std::unique_ptr<sink::underflow_policy_t> underflow_policy);
+
+    /// Filters are evaluated on the worker thread, records denied by the filters of all targets are
+    /// not formatted at all.
+    asynchronous_t(std::unique_ptr<formatter_t> formatter,
+                   std::vector<target_t> targets,
+                   std::unique_ptr<sink::asynchronous::queue_t> queue,
+                   std::unique_ptr<sink::overflow_policy_t> overflow_policy,
+                   std::unique_ptr<sink::underflow_policy_t> underflow_policy,
+                   std::chrono::milliseconds deadline = std::chrono::milliseconds::zero());
+
+    /// Blocks until all queued records are formatted and emitted.
+    ///
+    /// If the drain deadline is set, records that have not been emitted by then are abandoned and
+    /// their number is reported through the sinks.
+    ~asynchronous_t();
+
+    /// Copies the given record into the queue. Records rejected by the overflow policy are counted
+    /// as dropped and reported through the sinks once the queue has been drained.
+    virtual auto handle(const record_t& record) -> void override;
+
+    /// Returns the minimum threshold over all targets, so records no target may receive are not
+    /// even queued.
+    virtual auto threshold() const noexcept -> severity_t override;
+
+    /// Blocks until all records handled before this call are emitted and the sinks are flushed, or
+    /// the given timeout expires.
+    virtual auto flush(std::chrono::milliseconds timeout) -> bool override;
+
+private:
+    auto run() -> void;
+
+    /// Completes flush requests whose records have all been emitted, flushing the sinks.
+    ///
+    /// Called by the worker thread.
+    ///
+    /// \returns false if there were none.
+    auto settle() -> bool;
+
+    /// Discards all queued records on the deadline, reporting their number.
+    auto abandon() -> void;
+
+    /// Formats and emits a synthetic record to the sinks whose filters pass it.
+    auto announce(severity_t severity, const string_view& message) -> void;
+
+    /// Emits a synthetic record about records dropped since the previous report, if any.
+    auto report(sink::asynchronous::drops_t& reported) -> void;
+};
+
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
@@ -1,10 +1,17 @@
 #include "blackhole/handler/blocking.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+
 #include <boost/optional/optional.hpp>
 
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
 #include "blackhole/extensions/writer.hpp"
+#include "blackhole/filter.hpp"
 #include "blackhole/formatter.hpp"
 #include "blackhole/registry.hpp"
 #include "blackhole/sink.hpp"
@@ -16,24 +23,151 @@
 namespace blackhole {
 inline namespace v1 {
 namespace handler {
+namespace {
+
+/// Formatting buffers grown beyond this are released after the record has been emitted, so a
+/// single huge record does not pin its memory for the thread lifetime.
+constexpr std::size_t shrink_threshold = 64 * 1024;
+
+/// Per-thread formatting buffer, which keeps its capacity between records.
+struct scratch_t {
+    writer_t writer;
+    /// Set while some handler formats into the buffer on this thread.
+    bool busy = false;
+};
+
+auto scratch() -> scratch_t& {
+    static thread_local scratch_t value;
+    return value;
+}
+
+/// Lends the calling thread's formatting buffer, cleared. A nested handler call on the same thread,
+/// for example from a sink that logs itself, gets a temporary buffer instead.
+class lease_t {
+    scratch_t& scratch;
+    bool owned;
+    writer_t fallback;
+
+public:
+    lease_t() :
+        scratch(handler::scratch()),
+        owned(!scratch.busy)
+    {
+        scratch.busy = true;
+    }
+
+    lease_t(const lease_t& other) = delete;
+    auto operator=(const lease_t& other) -> lease_t& = delete;
+
+    ~lease_t() {
+        if (!owned) {
+            return;
+        }
+
+        if (scratch.writer.inner.size() > shrink_threshold) {
+            scratch.writer.inner = fmt::MemoryWriter();
+        } else {
+            scratch.writer.inner.clear();
+        }
+
+        scratch.busy = false;
+    }
+
+    auto writer() noexcept -> writer_t& {
+        return owned ? scratch.writer : fallback;
+    }
+};
+
+auto accepts(const blocking_t::target_t& target, const record_t& record) -> bool {
+    if (target.filter == nullptr) {
+        return true;
+    }
+
+    switch (target.filter->filter(record)) {
+    case filter_t::action_t::neutral:
+    case filter_t::action_t::accept:
+        return true;
+    case filter_t::action_t::deny:
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace
+
+auto blocking_t::target_t::threshold() const noexcept -> severity_t {
+    if (filter == nullptr) {
+        return std::numeric_limits<int>::min();
+    }
+
+    return filter->threshold();
+}
 
 blocking_t::blocking_t(std::unique_ptr<formatter_t> formatter,
                        std::vector<std::unique_ptr<sink_t>> sinks) :
+    formatter(std::move(formatter))
+{
+    targets.reserve(sinks.size());
+    for (auto& sink : sinks) {
+        targets.push_back({std::move(sink), nullptr});
+    }
+}
+
+blocking_t::blocking_t(std::unique_ptr<formatter_t> formatter, std::vector<target_t> targets) :
     formatter(std::move(formatter)),
-    sinks(std::move(sinks))
+    targets(std::move(targets))
 {}
 
 auto blocking_t::handle(const record_t& record) -> void {
-    writer_t writer;
+    // Each filter is evaluated exactly once. Formatting is deferred until some target accepts the
+    // record, so records nobody wants cost only the filter checks.
+    auto it = std::begin(targets);
+    while (it != std::end(targets) && !accepts(*it, record)) {
+        ++it;
+    }
+
+    if (it == std::end(targets)) {
+        return;
+    }
+
+    lease_t lease;
+    auto& writer = lease.writer();
 
     formatter->format(record, writer);
 
-    for (const auto& sink : sinks) {
-        // TODO: Check for filter.
-        sink->emit(record, writer.result());
+    it->sink->emit(record, writer.result());
+    for (++it; it != std::end(targets); ++it) {
+        if (accepts(*it, record)) {
+            it->sink->emit(record, writer.result());
+        }
     }
 }
 
+auto blocking_t::threshold() const noexcept -> severity_t {
+    auto result = std::numeric_limits<int>::max();
+    for (const auto& target : targets) {
+        result = std::min<int>(result, target.threshold());
+    }
+
+    return result;
+}
+
+auto blocking_t::flush(std::chrono::milliseconds timeout) -> bool {
+    const auto until = std::chrono::steady_clock::now() + timeout;
+
+    for (auto& target : targets) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            until - std::chrono::steady_clock::now());
+
+        if (!target.sink->flush(std::max(remaining, std::chrono::milliseconds::zero()))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 }  // namespace handler
 
 using handler::blocking_t;
@@ -41,7 +175,7 @@ using handler::blocking_t;
 class builder<blocking_t>::inner_t {
 public:
     std::unique_ptr<formatter_t> formatter;
-    std::vector<std::unique_ptr<sink_t>> sinks;
+    std::vector<blocking_t::target_t> targets;
 };
 
 // TODO: TEST!
@@ -59,16 +193,28 @@ auto builder<blocking_t>::set(std::unique_ptr<formatter_t> formatter) && -> buil
 }
 
 auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink) & -> builder& {
-    d->sinks.emplace_back(std::move(sink));
-    return *this;
+    return add(std::move(sink), nullptr);
 }
 
 auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink) && -> builder&& {
     return std::move(add(std::move(sink)));
 }
 
+auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) & ->
+    builder&
+{
+    d->targets.push_back({std::move(sink), std::move(filter)});
+    return *this;
+}
+
+auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) && ->
+    builder&&
+{
+    return std::move(add(std::move(sink), std::move(filter)));
+}
+
 auto builder<blocking_t>::build() && -> std::unique_ptr<handler_t> {
-    return blackhole::make_unique<blocking_t>(std::move(d->formatter), std::move(d->sinks));
+    return blackhole::make_unique<blocking_t>(std::move(d->formatter), std::move(d->targets));
 }
 
 auto factory<blocking_t>::type() const noexcept -> const char* {
@@ -76,6 +222,12 @@ auto factory<blocking_t>::type() const noexcept -> const char* {
 }
 
 auto factory<blocking_t>::from(const config::node_t& config) const -> std::unique_ptr<handler_t> {
+    return from(config, registry);
+}
+
+auto factory<blocking_t>::from(const config::node_t& config, const registry_t& registry) const ->
+    std::unique_ptr<handler_t>
+{
     builder<blocking_t> builder;
 
     // TODO: Unsafe! Test and wrap with result.
@@ -86,11 +238,20 @@ auto factory<blocking_t>::from(const config::node_t& config) const -> std::uniqu
     }
 
     config["sinks"].each([&](const config::node_t& config) {
-        if (auto type = config["type"].to_string()) {
-            builder.add(registry.sink(type.get())(config));
-        } else {
+        auto type = config["type"].to_string();
+
+        if (!type) {
             throw std::invalid_argument("each sink must have a type");
         }
+
+        std::unique_ptr<filter_t> filter;
+        if (auto filter_type = config["filter"]["type"].to_string()) {
+            filter = registry.filter(filter_type.get())(*config["filter"].unwrap());
+        } else if (config["filter"].unwrap()) {
+            throw std::invalid_argument("each sink filter must have a type");
+        }
+
+        builder.add(registry.sink(type.get())(config), std::move(filter));
     });
 
     return std::move(builder).build();
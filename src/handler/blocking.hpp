@@ -11,13 +11,34 @@ inline namespace v1 {
 namespace handler {
 
 class blocking_t : public handler_t {
+public:
+    /// Sink along with the filter deciding which records it receives.
+    struct target_t {
+        std::unique_ptr<sink_t> sink;
+        /// Null means the sink receives all records.
+        std::unique_ptr<filter_t> filter;
+
+        /// Returns the minimum severity level the target may receive.
+        auto threshold() const noexcept -> severity_t;
+    };
+
+private:
     std::unique_ptr<formatter_t> formatter;
-    std::vector<std::unique_ptr<sink_t>> sinks;
+    std::vector<target_t> targets;
 
 public:
     blocking_t(std::unique_ptr<formatter_t> formatter, std::vector<std::unique_ptr<sink_t>> sinks);
 
+    /// Records denied by the filters of all targets are not formatted at all.
+    blocking_t(std::unique_ptr<formatter_t> formatter, std::vector<target_t> targets);
+
     virtual auto handle(const record_t& record) -> void override;
+
+    /// Returns the minimum threshold over all targets.
+    virtual auto threshold() const noexcept -> severity_t override;
+
+    /// Flushes sinks of all targets, sharing the given timeout between them.
+    virtual auto flush(std::chrono::milliseconds timeout) -> bool override;
 };
 
 }  // namespace handler
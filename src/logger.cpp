@@ -7,5 +7,9 @@ inline namespace v1 {
 
 logger_t::~logger_t() = default;
 
+auto logger_t::enabled(severity_t) const noexcept -> bool {
+    return true;
+}
+
 }  // namespace v1
 }  // namespace blackhole
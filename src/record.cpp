@@ -1,16 +1,11 @@
 #include "blackhole/record.hpp"
 
-#if defined(__linux__)
-    #include <sys/syscall.h>
-    #include <sys/types.h>
-    #include <unistd.h>
-#endif
-
 #include <thread>
 
 #include "blackhole/attribute.hpp"
 
 #include "record.hpp"
+#include "thread.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -28,7 +23,11 @@ record_t::record_t(severity_t severity,
     inner.severity = severity;
     inner.timestamp = time_point();
 
+    const auto info = this_thread::info();
+    inner.pid = static_cast<std::uint32_t>(info.pid);
+    inner.lwp = info.lwp;
     inner.tid = ::pthread_self();
+    inner.thread = info.name;
 
     inner.attributes = attributes;
 }
@@ -50,21 +49,21 @@ auto record_t::timestamp() const noexcept -> time_point {
 }
 
 auto record_t::pid() const noexcept -> std::uint64_t {
-    return static_cast<std::uint64_t>(::getpid());
+    return inner().pid;
 }
 
 auto record_t::lwp() const noexcept -> std::uint64_t {
-#if defined(__linux__)
-    return ::syscall(SYS_gettid);
-#else
-    return 0;
-#endif
+    return inner().lwp;
 }
 
 auto record_t::tid() const noexcept -> std::thread::native_handle_type {
     return inner().tid;
 }
 
+auto record_t::thread_name() const noexcept -> const char* {
+    return inner().thread;
+}
+
 auto record_t::formatted() const noexcept -> const string_view& {
     return inner().formatted;
 }
@@ -78,12 +77,15 @@ auto record_t::is_active() const noexcept -> bool {
 }
 
 auto record_t::activate(const string_view& formatted) noexcept -> void {
+    activate(formatted, clock_type::now());
+}
+
+auto record_t::activate(const string_view& formatted, time_point timestamp) noexcept -> void {
     if (formatted.data() != nullptr) {
         inner().formatted = formatted;
     }
 
-    // TODO: I can use coarse clock in linux.
-    inner().timestamp = clock_type::now();
+    inner().timestamp = timestamp;
 }
 
 auto record_t::inner() noexcept -> inner_t& {
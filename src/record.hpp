@@ -10,11 +10,12 @@ struct record_t::inner_t {
     std::reference_wrapper<const string_view> formatted;
 
     severity_t severity;
+    std::uint32_t pid;
     time_point timestamp;
 
     std::uint64_t lwp;
     std::thread::native_handle_type tid;
-    char __pad[8];
+    const char* thread;
 
     std::reference_wrapper<const attribute_pack> attributes;
 };
@@ -0,0 +1,224 @@
+#include "recordbuf.hpp"
+
+#include <cstring>
+
+#include <boost/variant/get.hpp>
+
+#include "blackhole/extensions/writer.hpp"
+
+#include "attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+#ifdef BLACKHOLE_HAVE_SMALL_VECTOR
+typedef boost::container::small_vector<std::size_t, 16> bounds_type;
+#else
+typedef std::vector<std::size_t> bounds_type;
+#endif
+
+/// Blocks larger than this are released when reused for much smaller records.
+constexpr std::size_t shrink_threshold = 16 * 1024;
+
+/// Sequentially fills a preallocated block, returning views of copied data.
+class cursor_t {
+    char* it;
+
+public:
+    explicit cursor_t(char* it) noexcept : it(it) {}
+
+    auto copy(const char* data, std::size_t size) noexcept -> string_view {
+        if (size == 0) {
+            return string_view("", 0);
+        }
+
+        std::memcpy(it, data, size);
+        const string_view result(it, size);
+        it += size;
+        return result;
+    }
+
+    auto copy(const string_view& value) noexcept -> string_view {
+        return copy(value.data(), value.size());
+    }
+};
+
+}  // namespace
+
+recordbuf_t::recordbuf_t() :
+    capacity(0),
+    message("", 0),
+    formatted("", 0),
+    pack{std::cref(attributes)}
+{
+    auto& inner = this->inner();
+    inner.severity = 0;
+    inner.pid = 0;
+    inner.timestamp = record_t::time_point();
+    inner.lwp = 0;
+    inner.tid = {};
+    inner.thread = nullptr;
+
+    rebind();
+}
+
+recordbuf_t::recordbuf_t(const record_t& record) :
+    recordbuf_t()
+{
+    assign(record);
+}
+
+auto recordbuf_t::assign(const record_t& record) -> void {
+    using attribute::view_t;
+
+    const auto& message = record.message();
+    const auto& formatted = record.formatted();
+
+    // Unformatted records share the same data for both messages.
+    const auto shared = message.data() == formatted.data() && message.size() == formatted.size();
+
+    // The first pass calculates the block size, rendering lazy attribute values into a writer,
+    // which has an inline buffer, to avoid calling them twice. Their boundaries are remembered to
+    // split the rendered text back later.
+    writer_t rendered;
+    bounds_type bounds;
+    std::size_t size = message.size() + (shared ? 0 : formatted.size());
+    std::size_t count = 0;
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            size += kv.first.size();
+            count += 1;
+
+            const auto& value = kv.second.inner().value;
+            if (const auto string = boost::get<view_t::string_type>(&value)) {
+                size += string->size();
+            } else if (const auto fn = boost::get<view_t::function_type>(&value)) {
+                (*fn)(rendered);
+                bounds.push_back(rendered.inner.size());
+            }
+        }
+    }
+
+    size += rendered.inner.size();
+
+    // Nothing is modified until all allocations succeed.
+    std::unique_ptr<char[]> block;
+    if (size > capacity || (capacity > shrink_threshold && size < capacity / 4)) {
+        block.reset(new char[size]);
+    }
+
+    attributes.reserve(count);
+    attributes.clear();
+
+    // The second pass copies everything into the block.
+    cursor_t cursor(block ? block.get() : data.get());
+    this->message = cursor.copy(message);
+    this->formatted = shared ? this->message : cursor.copy(formatted);
+
+    const auto lazy = cursor.copy(rendered.result());
+    std::size_t offset = 0;
+    auto bound = std::begin(bounds);
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            const auto key = cursor.copy(kv.first);
+
+            const auto& value = kv.second.inner().value;
+            if (const auto string = boost::get<view_t::string_type>(&value)) {
+                attributes.emplace_back(key, view_t(cursor.copy(*string)));
+            } else if (boost::get<view_t::function_type>(&value)) {
+                attributes.emplace_back(key, view_t(lazy.substr(offset, *bound - offset)));
+                offset = *bound++;
+            } else {
+                attributes.emplace_back(key, kv.second);
+            }
+        }
+    }
+
+    if (block) {
+        data = std::move(block);
+        capacity = size;
+    }
+
+    auto& inner = this->inner();
+    inner.severity = record.severity();
+    inner.pid = static_cast<std::uint32_t>(record.pid());
+    inner.timestamp = record.timestamp();
+    inner.lwp = record.lwp();
+    inner.tid = record.tid();
+    inner.thread = nullptr;
+
+    if (const auto name = record.thread_name()) {
+        std::strncpy(thread.data(), name, thread.size() - 1);
+        thread.back() = '\0';
+        inner.thread = thread.data();
+    }
+
+    rebind();
+}
+
+recordbuf_t::recordbuf_t(recordbuf_t&& other) noexcept :
+    data(std::move(other.data)),
+    capacity(other.capacity),
+    message(other.message),
+    formatted(other.formatted),
+    attributes(std::move(other.attributes)),
+    pack{std::cref(attributes)},
+    thread(other.thread),
+    storage(other.storage)
+{
+    rebind();
+    other.reset();
+}
+
+auto recordbuf_t::operator=(recordbuf_t&& other) noexcept -> recordbuf_t& {
+    if (this != &other) {
+        data = std::move(other.data);
+        capacity = other.capacity;
+        message = other.message;
+        formatted = other.formatted;
+        attributes = std::move(other.attributes);
+        thread = other.thread;
+        storage = other.storage;
+
+        rebind();
+        other.reset();
+    }
+
+    return *this;
+}
+
+auto recordbuf_t::into_view() const noexcept -> record_t {
+    return {inner()};
+}
+
+auto recordbuf_t::rebind() noexcept -> void {
+    auto& inner = this->inner();
+    inner.message = message;
+    inner.formatted = formatted;
+    inner.attributes = pack;
+
+    if (inner.thread) {
+        inner.thread = thread.data();
+    }
+}
+
+auto recordbuf_t::reset() noexcept -> void {
+    capacity = 0;
+    message = string_view("", 0);
+    formatted = string_view("", 0);
+    attributes.clear();
+}
+
+auto recordbuf_t::inner() noexcept -> record_t::inner_t& {
+    return reinterpret_cast<record_t::inner_t&>(storage);
+}
+
+auto recordbuf_t::inner() const noexcept -> const record_t::inner_t& {
+    return reinterpret_cast<const record_t::inner_t&>(storage);
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -1,7 +1,11 @@
 #include "blackhole/registry.hpp"
 
+#include <map>
+#include <string>
+
 #include <boost/optional/optional.hpp>
 
+#include "blackhole/clock.hpp"
 #include "blackhole/config/factory.hpp"
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
@@ -14,6 +18,7 @@
 #include "blackhole/sink.hpp"
 
 #include "essentials.hpp"
+#include "formatter/shared.hpp"
 #include "memory.hpp"
 
 namespace blackhole {
@@ -49,8 +54,128 @@ auto get(const std::map<std::string, V>* map, const std::string& key) -> result<
     }
 }
 
+auto quote(const std::string& value, fmt::MemoryWriter& writer) -> void {
+    writer << '"';
+    for (auto ch : value) {
+        if (ch == '"' || ch == '\\') {
+            writer << '\\';
+        }
+        writer << ch;
+    }
+    writer << '"';
+}
+
+/// Writes a canonical representation of the given config node, which is the same for identical
+/// configs regardless of their members order.
+auto fingerprint(const config::node_t& node, fmt::MemoryWriter& writer) -> void {
+    if (node.is_bool()) {
+        writer << (node.to_bool() ? "true" : "false");
+    } else if (node.is_sint64()) {
+        writer << node.to_sint64();
+    } else if (node.is_uint64()) {
+        writer << node.to_uint64();
+    } else if (node.is_double()) {
+        writer.write("{:.17g}", node.to_double());
+    } else if (node.is_string()) {
+        quote(node.to_string(), writer);
+    } else if (node.is_vector()) {
+        writer << '[';
+        node.each([&](const config::node_t& node) {
+            fingerprint(node, writer);
+            writer << ',';
+        });
+        writer << ']';
+    } else if (node.is_object()) {
+        std::map<std::string, std::string> members;
+        node.each_map([&](const std::string& key, const config::node_t& node) {
+            fmt::MemoryWriter member;
+            fingerprint(node, member);
+            members[key] = member.str();
+        });
+
+        writer << '{';
+        for (const auto& member : members) {
+            quote(member.first, writer);
+            writer << ':' << member.second << ',';
+        }
+        writer << '}';
+    } else {
+        writer << "null";
+    }
+}
+
+/// Registry used while building a single logger, forwarding lookups to the underlying registry.
+///
+/// Handlers with identical formatter configs get the same formatter instance, so that each record
+/// is formatted once for all of them, see `formatter::shared_t`. The pool of such formatters lives
+/// as long as the context, so separate or nested builds never share it.
+class context_t : public registry_t {
+    const registry_t& registry;
+    mutable std::map<std::string, std::shared_ptr<formatter_t>> formatters;
+
+public:
+    explicit context_t(const registry_t& registry) : registry(registry) {}
+
+    context_t(const context_t& other) = delete;
+    auto operator=(const context_t& other) -> context_t& = delete;
+
+    auto sink(const std::string& type) const -> sink_factory override {
+        return registry.sink(type);
+    }
+
+    auto filter(const std::string& type) const -> filter_factory override {
+        return registry.filter(type);
+    }
+
+    auto handler(const std::string& type) const -> handler_factory override {
+        return registry.handler(type);
+    }
+
+    auto handler(const std::string& type, const registry_t& context) const ->
+        handler_factory override
+    {
+        return registry.handler(type, context);
+    }
+
+    auto formatter(const std::string& type) const -> formatter_factory override {
+        auto factory = registry.formatter(type);
+
+        return [this, factory](const config::node_t& config) -> std::unique_ptr<formatter_t> {
+            fmt::MemoryWriter key;
+            fingerprint(config, key);
+
+            auto& formatter = formatters[key.str()];
+            if (formatter == nullptr) {
+                formatter = factory(config);
+            }
+
+            return blackhole::make_unique<formatter::shared_t>(formatter);
+        };
+    }
+
+    auto add(std::shared_ptr<factory<sink_t>>) -> void override {
+        throw std::logic_error("registry can not be modified while building a logger");
+    }
+
+    auto add(std::shared_ptr<factory<filter_t>>) -> void override {
+        throw std::logic_error("registry can not be modified while building a logger");
+    }
+
+    auto add(std::shared_ptr<factory<handler_t>>) -> void override {
+        throw std::logic_error("registry can not be modified while building a logger");
+    }
+
+    auto add(std::shared_ptr<factory<formatter_t>>) -> void override {
+        throw std::logic_error("registry can not be modified while building a logger");
+    }
+};
+
 }  // namespace
 
+auto registry_t::handler(const std::string& type, const registry_t&) const -> handler_factory {
+    return handler(type);
+}
+
 builder_t::builder_t(const registry_t& registry, std::unique_ptr<config::factory_t> factory) :
     registry(registry),
     factory(factory.release())
@@ -63,21 +188,43 @@ auto builder_t::configurator() noexcept -> config::factory_t& {
 auto builder_t::build(const std::string& name) -> root_logger_t {
     const auto& config = factory->config();
 
+    const context_t context(registry);
     std::vector<std::unique_ptr<handler_t>> handlers;
 
+    const auto fn = [&](const config::node_t& config) {
+        handlers.emplace_back(handler(config, context));
+    };
+
     // TODO: Check `config.contains(name)`.
-    config[name].each([&](const config::node_t& config) {
-        handlers.emplace_back(handler(config));
-    });
+    // The logger is configured either by an array of handlers or by an object with "handlers"
+    // array and additional logger options.
+    const auto root = config[name];
+    const auto node = root.unwrap();
+
+    if (node && node->is_object()) {
+        root["handlers"].each(fn);
+    } else {
+        root.each(fn);
+    }
+
+    root_logger_t logger(std::move(handlers));
 
-    return root_logger_t(std::move(handlers));
+    if (node && node->is_object()) {
+        if (auto clock = root["clock"].to_string()) {
+            logger.clock(clock_source::create(*clock));
+        }
+    }
+
+    return logger;
 }
 
-auto builder_t::handler(const config::node_t& config) const -> std::unique_ptr<handler_t> {
+auto builder_t::handler(const config::node_t& config, const registry_t& context) const ->
+    std::unique_ptr<handler_t>
+{
     const auto type = config["type"].to_string()
         .get_value_or("blocking");
 
-    return registry.handler(type)(config);
+    return registry.handler(type, context)(config);
 }
 
 class default_registry_t : public registry_t {
@@ -90,13 +237,15 @@ public:
 private:
     std::map<std::string, sink_factory> sinks;
     std::map<std::string, filter_factory> filters;
-    std::map<std::string, handler_factory> handlers;
+    std::map<std::string, std::shared_ptr<factory<handler_t>>> handlers;
     std::map<std::string, formatter_factory> formatters;
 
 public:
     auto sink(const std::string& type) const -> sink_factory override;
     auto filter(const std::string& type) const -> filter_factory override;
     auto handler(const std::string& type) const -> handler_factory override;
+    auto handler(const std::string& type, const registry_t& context) const ->
+        handler_factory override;
     auto formatter(const std::string& type) const -> formatter_factory override;
 
     auto add(std::shared_ptr<factory<sink_t>> factory) -> void override;
@@ -118,9 +267,7 @@ auto default_registry_t::add(std::shared_ptr<factory<filter_t>> factory) -> void
 }
 
 auto default_registry_t::add(std::shared_ptr<factory<handler_t>> factory) -> void {
-    handlers[factory->type()] = [=](const config::node_t& node) {
-        return factory->from(node);
-    };
+    handlers[factory->type()] = std::move(factory);
 }
 
 auto default_registry_t::add(std::shared_ptr<factory<formatter_t>> factory) -> void {
@@ -140,8 +287,23 @@ auto default_registry_t::filter(const std::string& type) const -> filter_factory
 }
 
 auto default_registry_t::handler(const std::string& type) const -> handler_factory {
-    return get(&handlers, type)
+    const auto factory = get(&handlers, type)
         .expect<std::out_of_range>(R"(handler with type "{}" is not registered)", type);
+
+    return [=](const config::node_t& node) {
+        return factory->from(node);
+    };
+}
+
+auto default_registry_t::handler(const std::string& type, const registry_t& context) const ->
+    handler_factory
+{
+    const auto factory = get(&handlers, type)
+        .expect<std::out_of_range>(R"(handler with type "{}" is not registered)", type);
+
+    return [=, &context](const config::node_t& node) {
+        return factory->from(node, context);
+    };
 }
 
 auto default_registry_t::formatter(const std::string& type) const -> formatter_factory {
@@ -1,18 +1,23 @@
 #include "blackhole/root.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <mutex>
-
-#include <boost/thread/tss.hpp>
+#include <vector>
 
 #include "blackhole/attribute.hpp"
+#include "blackhole/clock.hpp"
 #include "blackhole/handler.hpp"
 #include "blackhole/record.hpp"
 #include "blackhole/scope/manager.hpp"
 #include "blackhole/scope/watcher.hpp"
 
-#include "spinlock.hpp"
+#include "epoch.hpp"
+#include "formatter/shared.hpp"
+#include "memory.hpp"
 #include "util/deleter.hpp"
 
 namespace blackhole {
@@ -21,93 +26,217 @@ namespace {
 
 using scope::watcher_t;
 
+/// Pool of per-thread slot indices, one for each alive scope manager.
+///
+/// Indices are reused after their managers are destroyed, keeping per-thread slot tables compact.
+class index_pool_t {
+    std::mutex mutex;
+    std::size_t next;
+    std::vector<std::size_t> free;
+
+public:
+    index_pool_t() : next(0) {}
+
+    auto acquire() -> std::size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (free.empty()) {
+            return next++;
+        }
+
+        const auto index = free.back();
+        free.pop_back();
+        return index;
+    }
+
+    auto release(std::size_t index) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        free.push_back(index);
+    }
+
+    static auto instance() -> index_pool_t& {
+        // Intentionally leaked to outlive managers owned by static loggers.
+        static index_pool_t* pool = new index_pool_t;
+        return *pool;
+    }
+};
+
+/// Scope manager backed by native thread-local storage.
+///
+/// Each thread keeps a plain table of watcher pointers indexed by the manager's slot index, so both
+/// lookup and update cost a thread-local access and a bounds check. Slots are tagged with the
+/// unique manager id to ignore stale values left from a previous owner of the same index.
 class thread_manager_t : public scope::manager_t {
-    boost::thread_specific_ptr<watcher_t> inner;
+    struct slot_t {
+        std::uint64_t id;
+        watcher_t* watcher;
+    };
+
+    std::size_t index;
+    std::uint64_t id;
 
 public:
-    thread_manager_t() : inner([](watcher_t*) {}) {}
+    thread_manager_t() :
+        index(index_pool_t::instance().acquire()),
+        id(generate())
+    {}
+
+    ~thread_manager_t() {
+        index_pool_t::instance().release(index);
+    }
 
     auto get() const -> watcher_t* {
-        return inner.get();
+        const auto& slots = thread_manager_t::slots();
+
+        if (index < slots.size() && slots[index].id == id) {
+            return slots[index].watcher;
+        }
+
+        return nullptr;
     }
 
     auto reset(watcher_t* value) -> void {
-        inner.reset(value);
+        auto& slots = thread_manager_t::slots();
+
+        if (index >= slots.size()) {
+            slots.resize(index + 1, slot_t{0, nullptr});
+        }
+
+        slots[index] = slot_t{id, value};
+    }
+
+private:
+    static auto slots() -> std::vector<slot_t>& {
+        static thread_local std::vector<slot_t> value;
+        return value;
+    }
+
+    static auto generate() noexcept -> std::uint64_t {
+        static std::atomic<std::uint64_t> counter(0);
+        return ++counter;
     }
 };
 
 }  // namespace
 
-struct root_logger_t::sync_t {
-    // NOTE: Actually we need to check for `std::atomic_*_explicit` overloads for `std::shared_ptr`,
-    // but it seems there is no simple way to do this.
-    // The given solution works both on OS X with clang compiler and on linux with GCC and clang.
-    // Feel free to hack and send a PR with better solution.
-#ifndef __APPLE__
-    typedef spinlock_t mutex_type;
-    mutable mutex_type mutex;
-#endif
+struct root_logger_t::inner_t {
+    typedef std::vector<std::unique_ptr<handler_t>> handlers_type;
 
-    thread_manager_t manager;
+    const filter_t filter;
+    const severity_t severity;
+    const std::shared_ptr<const handlers_type> handlers;
+    const std::shared_ptr<clock_source_t> clock;
 
-    auto load(const std::shared_ptr<inner_t>& source) const noexcept -> std::shared_ptr<inner_t> {
-#ifdef __APPLE__
-        return std::atomic_load_explicit(&source, std::memory_order_acquire);
-#else
-        std::lock_guard<mutex_type> lock(mutex);
-        return source;
-#endif
-    }
+    inner_t(filter_t filter,
+            severity_t severity,
+            std::shared_ptr<const handlers_type> handlers,
+            std::shared_ptr<clock_source_t> clock):
+        filter(std::move(filter)),
+        severity(severity),
+        handlers(std::move(handlers)),
+        clock(std::move(clock))
+    {}
+
+    /// Returns the minimum severity level that can pass both the filter and at least one handler.
+    ///
+    /// Having no handlers at all means that every event is dropped.
+    auto threshold() const noexcept -> int {
+        auto result = std::numeric_limits<int>::max();
+        for (const auto& handler : *handlers) {
+            result = std::min<int>(result, handler->threshold());
+        }
 
-    auto store(std::shared_ptr<inner_t>& source, std::shared_ptr<inner_t> value) noexcept -> void {
-#ifdef __APPLE__
-        std::atomic_store_explicit(&source, std::move(value), std::memory_order_release);
-#else
-        std::lock_guard<mutex_type> lock(mutex);
-        source = std::move(value);
-#endif
+        return std::max<int>(result, severity);
     }
 };
 
-struct root_logger_t::inner_t {
-    typedef spinlock_t mutex_type;
+/// Publishes immutable configuration snapshots using epoch-based reclamation.
+///
+/// Readers pin the current snapshot with an `epoch::guard_t` and access it by raw pointer, so the
+/// hot path neither takes locks nor touches reference counters. Writers are serialized, replace the
+/// snapshot atomically and retire the previous one until all readers that could observe it leave
+/// their critical sections.
+struct root_logger_t::sync_t {
+    std::atomic<inner_t*> inner;
+    std::atomic<int>& threshold;
 
-    filter_t filter;
-    const std::vector<std::unique_ptr<handler_t>> handlers;
+    std::mutex mutex;
+    std::vector<std::pair<std::uint64_t, std::unique_ptr<inner_t>>> retired;
 
-    inner_t(std::vector<std::unique_ptr<handler_t>> handlers):
-        filter([](const record_t&) -> bool { return true; }),
-        handlers(std::move(handlers))
-    {}
+    thread_manager_t manager;
 
-    inner_t(filter_t filter, std::vector<std::unique_ptr<handler_t>> handlers):
-        filter(std::move(filter)),
-        handlers(std::move(handlers))
-    {}
+    sync_t(std::unique_ptr<inner_t> inner, std::atomic<int>& threshold) :
+        inner(inner.release()),
+        threshold(threshold)
+    {
+        this->threshold.store(this->inner.load()->threshold(), std::memory_order_relaxed);
+    }
+
+    ~sync_t() {
+        delete inner.load(std::memory_order_relaxed);
+    }
 
+    /// Returns the current snapshot.
+    ///
+    /// \warning the caller must be inside an epoch guard while using the returned pointer.
+    auto load() const noexcept -> const inner_t* {
+        return inner.load(std::memory_order_seq_cst);
+    }
+
+    /// Makes a private copy of the current snapshot.
+    auto clone() const -> std::unique_ptr<inner_t> {
+        const epoch::guard_t guard;
+        const auto inner = load();
+        return blackhole::make_unique<inner_t>(inner->filter, inner->severity, inner->handlers,
+            inner->clock);
+    }
+
+    /// Publishes the snapshot produced by the given function from the current one.
     template<typename F>
-    auto apply(F&& fn) -> decltype(fn(std::declval<inner_t&>())) {
-        std::lock_guard<mutex_type> lock(mutex);
-        return fn(*this);
+    auto update(F&& fn) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto value = fn(*inner.load(std::memory_order_relaxed));
+        // Nothing may throw once the snapshot has been published.
+        retired.reserve(retired.size() + 1);
+        threshold.store(value->threshold(), std::memory_order_relaxed);
+        std::unique_ptr<inner_t> prev(inner.exchange(value.release(), std::memory_order_seq_cst));
+
+        retired.emplace_back(epoch::advance(), std::move(prev));
+        reclaim();
+    }
+
+    auto store(std::unique_ptr<inner_t> value) -> void {
+        update([&](const inner_t&) -> std::unique_ptr<inner_t> {
+            return std::move(value);
+        });
     }
 
 private:
-    mutable mutex_type mutex;
+    auto reclaim() -> void {
+        const auto it = std::remove_if(std::begin(retired), std::end(retired),
+            [](const std::pair<std::uint64_t, std::unique_ptr<inner_t>>& item) -> bool {
+                return epoch::synchronized(item.first);
+            }
+        );
+
+        retired.erase(it, std::end(retired));
+    }
 };
 
 root_logger_t::root_logger_t(std::vector<std::unique_ptr<handler_t>> handlers):
-    sync(new sync_t),
-    inner(std::make_shared<inner_t>(std::move(handlers)))
+    root_logger_t([](const record_t&) -> bool { return true; }, std::move(handlers))
 {}
 
 root_logger_t::root_logger_t(filter_t filter, std::vector<std::unique_ptr<handler_t>> handlers):
-    sync(new sync_t),
-    inner(std::make_shared<inner_t>(std::move(filter), std::move(handlers)))
+    threshold(std::numeric_limits<int>::min()),
+    sync(new sync_t(blackhole::make_unique<inner_t>(std::move(filter), std::numeric_limits<int>::min(),
+        std::make_shared<inner_t::handlers_type>(std::move(handlers)), clock_source::precise()),
+        threshold))
 {}
 
-root_logger_t::root_logger_t(root_logger_t&& other) noexcept :
-    sync(new sync_t),
-    inner(other.sync->load(other.inner))
+root_logger_t::root_logger_t(root_logger_t&& other) :
+    threshold(std::numeric_limits<int>::min()),
+    sync(new sync_t(other.sync->clone(), threshold))
 {
     sync->manager.reset(other.sync->manager.get());
 
@@ -119,13 +248,12 @@ root_logger_t::root_logger_t(root_logger_t&& other) noexcept :
 root_logger_t::~root_logger_t() {}
 
 auto
-root_logger_t::operator=(root_logger_t&& other) noexcept -> root_logger_t& {
+root_logger_t::operator=(root_logger_t&& other) -> root_logger_t& {
     if (this == &other) {
         return *this;
     }
 
-    const auto inner = other.sync->load(other.inner);
-    sync->store(this->inner, std::move(inner));
+    sync->store(other.sync->clone());
 
     sync->manager.reset(other.sync->manager.get());
 
@@ -138,13 +266,46 @@ root_logger_t::operator=(root_logger_t&& other) noexcept -> root_logger_t& {
 
 auto
 root_logger_t::filter(filter_t fn) -> void {
-    auto inner = sync->load(this->inner);
+    filter(std::move(fn), std::numeric_limits<int>::min());
+}
 
-    inner->apply([&](inner_t& inner) {
-        inner.filter = std::move(fn);
+auto
+root_logger_t::filter(filter_t fn, severity_t threshold) -> void {
+    sync->update([&](const inner_t& inner) -> std::unique_ptr<inner_t> {
+        return blackhole::make_unique<inner_t>(std::move(fn), threshold, inner.handlers,
+            inner.clock);
+    });
+}
+
+auto
+root_logger_t::clock(std::shared_ptr<clock_source_t> source) -> void {
+    sync->update([&](const inner_t& inner) -> std::unique_ptr<inner_t> {
+        return blackhole::make_unique<inner_t>(inner.filter, inner.severity, inner.handlers,
+            std::move(source));
     });
+}
+
+auto
+root_logger_t::flush(std::chrono::milliseconds timeout) -> bool {
+    std::shared_ptr<const inner_t::handlers_type> handlers;
+
+    {
+        const epoch::guard_t guard;
+        handlers = sync->load()->handlers;
+    }
+
+    const auto until = std::chrono::steady_clock::now() + timeout;
+
+    for (const auto& handler : *handlers) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            until - std::chrono::steady_clock::now());
+
+        if (!handler->flush(std::max(remaining, std::chrono::milliseconds::zero()))) {
+            return false;
+        }
+    }
 
-    sync->store(this->inner, std::move(inner));
+    return true;
 }
 
 namespace {
@@ -174,21 +335,22 @@ auto root_logger_t::log(severity_t severity, const lazy_message_t& message, attr
 
 template<typename F>
 auto root_logger_t::consume(severity_t severity, const string_view& pattern, attribute_pack& pack, const F& supplier) -> void {
-    const auto inner = sync->load(this->inner);
-    const auto filter = inner->apply([&](inner_t& inner) -> filter_t {
-        return inner.filter;
-    });
+    const epoch::guard_t guard;
+    const auto inner = sync->load();
 
     if (sync->manager.get()) {
         sync->manager.get()->collect(pack);
     }
 
     record_t record(severity, pattern, pack);
-    if (filter(record)) {
+    if (inner->filter(record)) {
         const auto formatted = supplier.supplier();
 
-        record.activate(formatted);
-        for (auto& handler : inner->handlers) {
+        record.activate(formatted, inner->clock->now());
+
+        // Handlers sharing a formatter format the record once, on first demand.
+        const formatter::dispatch_t dispatch(record);
+        for (auto& handler : *inner->handlers) {
             try {
                 handler->handle(record);
             } catch (const std::exception& err) {
@@ -208,6 +370,7 @@ class builder<root_logger_t>::inner_t {
 public:
     root_logger_t::filter_t filter;
     std::vector<std::unique_ptr<handler_t>> handlers;
+    std::shared_ptr<clock_source_t> clock;
 };
 
 builder<root_logger_t>::builder() :
@@ -225,8 +388,22 @@ auto builder<root_logger_t>::add(std::unique_ptr<handler_t> handler) && -> build
     return std::move(add(std::move(handler)));
 }
 
+auto builder<root_logger_t>::clock(std::shared_ptr<clock_source_t> source) & -> builder& {
+    d->clock = std::move(source);
+    return *this;
+}
+
+auto builder<root_logger_t>::clock(std::shared_ptr<clock_source_t> source) && -> builder&& {
+    return std::move(clock(std::move(source)));
+}
+
 auto builder<root_logger_t>::build() && -> std::unique_ptr<result_type> {
     std::unique_ptr<root_logger_t> log(new root_logger_t(std::move(d->filter), std::move(d->handlers)));
+
+    if (d->clock) {
+        log->clock(std::move(d->clock));
+    }
+
     return log;
 }
 
@@ -12,7 +12,8 @@ namespace scope {
 
 watcher_t::watcher_t(logger_t& logger) :
     manager(logger.manager()),
-    prev(manager.get().get())
+    prev(manager.get().get()),
+    cached(false)
 {
     manager.get().reset(this);
 }
@@ -23,11 +24,17 @@ watcher_t::~watcher_t() {
 }
 
 auto watcher_t::collect(attribute_pack& pack) const -> void {
-    pack.emplace_back(attributes());
+    if (!cached) {
+        chain.emplace_back(attributes());
 
-    if (prev) {
-        prev->collect(pack);
+        if (prev) {
+            prev->collect(chain);
+        }
+
+        cached = true;
     }
+
+    pack.insert(std::end(pack), std::begin(chain), std::end(chain));
 }
 
 auto watcher_t::rebind(manager_t& manager) -> void {
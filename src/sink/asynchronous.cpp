@@ -1,5 +1,11 @@
 #include "blackhole/sink/asynchronous.hpp"
 
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <boost/optional/optional.hpp>
 
 #include "blackhole/config/node.hpp"
@@ -9,19 +15,356 @@
 #include "../memory.hpp"
 #include "../util/deleter.hpp"
 #include "asynchronous.hpp"
+#include "asynchronous/consumer.hpp"
+#include "asynchronous/pool.hpp"
+#include "file/flusher/bytecount.hpp"
 
 namespace blackhole {
 inline namespace v1 {
+namespace {
+
+/// Returns the suffix of files owned by the worker with the given index, so workers of a pool do
+/// not share them.
+auto suffix(std::size_t index, std::size_t workers) -> std::string {
+    return workers == 1 ? std::string() : "." + std::to_string(index);
+}
+
+/// Creates an overflow policy from either its name or an object with "type" and policy specific
+/// options. The given suffix is appended to the spill file path.
+auto overflow_policy(const config::option<config::node_t>& config, const std::string& suffix) ->
+    std::unique_ptr<sink::overflow_policy_t>
+{
+    const auto node = config.unwrap();
+
+    if (!node || !node->is_object()) {
+        return sink::overflow_policy_factory_t().create(config.to_string().get());
+    }
+
+    auto type = config["type"].to_string();
+
+    if (!type) {
+        throw std::invalid_argument("\"overflow\" field with \"type\" is required");
+    }
+
+    if (type.get() == "wait") {
+        if (auto timeout = config["timeout"].to_uint64()) {
+            return sink::overflow_policy_factory_t().wait(std::chrono::milliseconds(timeout.get()));
+        }
+    }
+
+    if (type.get() == "watermark") {
+        std::vector<sink::watermark_t> watermarks;
+
+        config["watermarks"].each([&](const config::node_t& config) {
+            auto severity = config["severity"].to_sint64();
+            auto level = config["level"].to_uint64();
+
+            if (!severity || !level) {
+                throw std::invalid_argument("each watermark must have \"severity\" and \"level\"");
+            }
+
+            watermarks.push_back({static_cast<severity_t>(severity.get()), level.get()});
+        });
+
+        const auto blocking = config["block"].to_sint64()
+            .get_value_or(std::numeric_limits<int>::max());
+
+        return sink::overflow_policy_factory_t().watermark(std::move(watermarks),
+            static_cast<severity_t>(blocking));
+    }
+
+    if (type.get() == "spill") {
+        auto path = config["path"].to_string();
+
+        if (!path) {
+            throw std::invalid_argument("\"overflow\" field with \"spill\" type requires \"path\"");
+        }
+
+        std::size_t size = 64 * 1024 * 1024;
+        if (const auto node = config["size"].unwrap()) {
+            size = node->is_string() ?
+                sink::file::flusher::parse_dunit(node->to_string()) :
+                node->to_uint64();
+        }
+
+        return sink::overflow_policy_factory_t().spill(path.get() + suffix, size);
+    }
+
+    return sink::overflow_policy_factory_t().create(type.get());
+}
+
+/// Creates a queue from either its name or an object with "type" and queue specific options.
+auto create_queue(const config::option<config::node_t>& config, std::size_t factor) ->
+    std::unique_ptr<sink::asynchronous::queue_t>
+{
+    const auto node = config.unwrap();
+
+    if (!node) {
+        return sink::asynchronous::queue_factory_t().create("shared", factor);
+    }
+
+    if (!node->is_object()) {
+        return sink::asynchronous::queue_factory_t().create(config.to_string().get(), factor);
+    }
+
+    auto type = config["type"].to_string();
+
+    if (!type) {
+        throw std::invalid_argument("\"queue\" field with \"type\" is required");
+    }
+
+    if (type.get() == "bytes") {
+        const auto capacity = config["capacity"].unwrap();
+
+        if (!capacity) {
+            throw std::invalid_argument(
+                "\"queue\" field with \"bytes\" type requires \"capacity\"");
+        }
+
+        if (capacity->is_string()) {
+            return sink::asynchronous::queue_factory_t().bytes(
+                sink::file::flusher::parse_dunit(capacity->to_string()));
+        }
+
+        return sink::asynchronous::queue_factory_t().bytes(capacity->to_uint64());
+    }
+
+    if (type.get() == "sharded") {
+        if (auto merge = config["merge"].to_string()) {
+            if (merge.get() == "timestamp") {
+                return sink::asynchronous::queue_factory_t().sharded(factor,
+                    sink::merge_t::timestamp);
+            } else if (merge.get() == "relaxed") {
+                return sink::asynchronous::queue_factory_t().sharded(factor,
+                    sink::merge_t::relaxed);
+            }
+
+            throw std::invalid_argument("no merge order with name \"" + merge.get() + "\" found");
+        }
+    }
+
+    return sink::asynchronous::queue_factory_t().create(type.get(), factor);
+}
+
+/// Creates a key from either its name or an object with "type" and key specific options.
+auto create_key(const config::option<config::node_t>& config) ->
+    std::unique_ptr<sink::asynchronous::key_t>
+{
+    const auto node = config.unwrap();
+
+    if (!node) {
+        return std::unique_ptr<sink::asynchronous::key_t>(new sink::asynchronous::thread_key_t);
+    }
+
+    auto type = node->is_object() ? config["type"].to_string() : config.to_string();
+
+    if (!type) {
+        throw std::invalid_argument("\"key\" field with \"type\" is required");
+    }
+
+    if (type.get() == "thread") {
+        return std::unique_ptr<sink::asynchronous::key_t>(new sink::asynchronous::thread_key_t);
+    } else if (type.get() == "attribute") {
+        if (auto name = config["name"].to_string()) {
+            return std::unique_ptr<sink::asynchronous::key_t>(
+                new sink::asynchronous::attribute_key_t(name.get()));
+        }
+
+        throw std::invalid_argument("\"key\" field with \"attribute\" type requires \"name\"");
+    }
+
+    throw std::invalid_argument("no key with name \"" + type.get() + "\" found");
+}
+
+typedef std::function<auto() -> std::unique_ptr<sink::exception_policy_t>> exception_factory;
+/// Takes the suffix of files owned by the worker.
+typedef std::function<auto(const std::string& suffix) ->
+    std::unique_ptr<sink::overflow_policy_t>> overflow_factory;
+typedef std::function<auto() -> std::unique_ptr<sink::underflow_policy_t>> underflow_factory;
+
+/// Creates an exception policy factory from either the policy name or an object with "type" and
+/// policy specific options. The fallback sink is created once and shared by all workers.
+auto exception_policy(const config::option<config::node_t>& config, const registry_t& registry) ->
+    exception_factory
+{
+    const auto node = config.unwrap();
+
+    if (!node) {
+        return [] {
+            return sink::exception_policy_factory_t().create("ignore");
+        };
+    }
+
+    auto type = node->is_object() ? config["type"].to_string() : config.to_string();
+
+    if (!type) {
+        throw std::invalid_argument("\"exception\" field with \"type\" is required");
+    }
+
+    if (type.get() == "retry" && node->is_object()) {
+        const auto attempts = config["attempts"].to_uint64().get_value_or(5);
+        const auto backoff = std::chrono::milliseconds(config["backoff"].to_uint64()
+            .get_value_or(10));
+
+        // Fail early on invalid options.
+        sink::exception_policy_factory_t().retry(attempts, backoff);
+
+        return [=] {
+            return sink::exception_policy_factory_t().retry(attempts, backoff);
+        };
+    }
+
+    if (type.get() == "fallback") {
+        auto sink_type = config["sink"]["type"].to_string();
+
+        if (!sink_type) {
+            throw std::invalid_argument("\"exception\" field with \"fallback\" type requires "
+                "\"sink\" with \"type\"");
+        }
+
+        std::shared_ptr<sink_t> sink(registry.sink(sink_type.get())(*config["sink"].unwrap()));
+
+        return [=] {
+            return sink::exception_policy_factory_t().fallback(sink);
+        };
+    }
+
+    const auto name = type.get();
+    sink::exception_policy_factory_t().create(name);
+
+    return [=] {
+        return sink::exception_policy_factory_t().create(name);
+    };
+}
+
+/// Consumer thread options along with the group sharing the thread, empty if the thread is private.
+struct placement_t {
+    sink::asynchronous::thread_options_t options;
+    std::string group;
+};
+
+auto scheduler(const std::string& name) -> sink::scheduler_t {
+    if (name == "other") {
+        return sink::scheduler_t::other;
+    } else if (name == "batch") {
+        return sink::scheduler_t::batch;
+    } else if (name == "idle") {
+        return sink::scheduler_t::idle;
+    } else if (name == "fifo") {
+        return sink::scheduler_t::fifo;
+    } else if (name == "rr") {
+        return sink::scheduler_t::rr;
+    }
+
+    throw std::invalid_argument("no scheduler with name \"" + name + "\" found");
+}
+
+/// Creates consumer thread options from an object with "name", "affinity", "nice", "scheduler",
+/// "priority" and "group", all optional.
+auto placement(const config::option<config::node_t>& config) -> placement_t {
+    placement_t result;
+
+    if (!config.unwrap()) {
+        return result;
+    }
+
+    result.options.name = config["name"].to_string().get_value_or("");
+
+    config["affinity"].each([&](const config::node_t& config) {
+        result.options.affinity.push_back(config.to_uint64());
+    });
+
+    if (auto nice = config["nice"].to_sint64()) {
+        result.options.nice = static_cast<int>(nice.get());
+    }
+
+    if (auto name = config["scheduler"].to_string()) {
+        result.options.scheduler = scheduler(name.get());
+    }
+
+    result.options.priority = static_cast<int>(config["priority"].to_sint64().get_value_or(0));
+    result.group = config["group"].to_string().get_value_or("");
+
+    return result;
+}
+
+/// Starts either a private consumer thread or joins the shared one of the group.
+auto create_consumer(const placement_t& placement, const underflow_factory& underflow) ->
+    std::shared_ptr<sink::asynchronous::consumer_t>
+{
+    if (placement.group.empty()) {
+        return std::make_shared<sink::asynchronous::consumer_t>(placement.options, underflow());
+    }
+
+    return sink::asynchronous::shared_consumer(placement.group, placement.options, underflow);
+}
+
+/// Creates the exception policy of a worker placed as given.
+///
+/// \throw std::invalid_argument if the policy blocks and the consumer thread is shared.
+auto create_exception_policy(const placement_t& placement, const exception_factory& factory) ->
+    std::unique_ptr<sink::exception_policy_t>
+{
+    auto policy = factory();
+
+    if (!placement.group.empty() && policy->blocking()) {
+        throw std::invalid_argument("blocking exception policy can not be used by sinks sharing a "
+            "consumer thread");
+    }
+
+    return policy;
+}
+
+auto overflow(std::string name) -> overflow_factory {
+    return [=](const std::string&) {
+        return sink::overflow_policy_factory_t().create(name);
+    };
+}
+
+auto underflow(std::string name) -> underflow_factory {
+    return [=] {
+        return sink::underflow_policy_factory_t().create(name);
+    };
+}
+
+}  // namespace
 
 class builder<sink::asynchronous_t>::inner_t {
 public:
     std::unique_ptr<sink_t> wrapped;
-    std::unique_ptr<sink::overflow_policy_t> overflow_policy;
+    /// Policies are created for each worker.
+    exception_factory exception_policy;
+    overflow_factory overflow_policy;
+    underflow_factory underflow_policy;
     std::size_t factor;
+    bool sharded;
+    sink::merge_t merge;
+    /// Byte ring capacity, zero means the queue capacity is defined by the factor.
+    std::size_t bytes;
+    std::size_t workers;
+    /// Empty means keying by thread.
+    std::string key;
+    std::chrono::milliseconds deadline;
+    placement_t thread;
 };
 
 builder<sink::asynchronous_t>::builder(std::unique_ptr<sink_t> wrapped) :
-    d(new inner_t{std::move(wrapped), sink::overflow_policy_factory_t().create("wait"), 10})
+    d(new inner_t{
+        std::move(wrapped),
+        [] {
+            return sink::exception_policy_factory_t().create("ignore");
+        },
+        overflow("wait"),
+        underflow("park"),
+        10,
+        false,
+        sink::merge_t::timestamp,
+        0,
+        1,
+        {},
+        std::chrono::milliseconds::zero(),
+        {}
+    })
 {}
 
 auto builder<sink::asynchronous_t>::factor(std::size_t value) & -> builder& {
@@ -34,16 +377,16 @@ auto builder<sink::asynchronous_t>::factor(std::size_t value) && -> builder&& {
 }
 
 auto builder<sink::asynchronous_t>::wait() & -> builder& {
-    d->overflow_policy = sink::overflow_policy_factory_t().create("wait");
+    d->overflow_policy = overflow("wait");
     return *this;
 }
 
 auto builder<sink::asynchronous_t>::drop() && -> builder&& {
-    return std::move(wait());
+    return std::move(drop());
 }
 
 auto builder<sink::asynchronous_t>::drop() & -> builder& {
-    d->overflow_policy = sink::overflow_policy_factory_t().create("drop");
+    d->overflow_policy = overflow("drop");
     return *this;
 }
 
@@ -51,8 +394,234 @@ auto builder<sink::asynchronous_t>::wait() && -> builder&& {
     return std::move(wait());
 }
 
-auto builder<sink::asynchronous_t>::build() && -> std::unique_ptr<sink_t> {
-    return blackhole::make_unique<sink::asynchronous_t>(std::move(d->wrapped), d->factor);
+auto builder<sink::asynchronous_t>::wait(std::chrono::milliseconds timeout) & -> builder& {
+    d->overflow_policy = [=](const std::string&) {
+        return sink::overflow_policy_factory_t().wait(timeout);
+    };
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::wait(std::chrono::milliseconds timeout) && -> builder&& {
+    return std::move(wait(timeout));
+}
+
+auto builder<sink::asynchronous_t>::spill(std::string path, std::size_t size) & -> builder& {
+    d->overflow_policy = [=](const std::string& suffix) {
+        return sink::overflow_policy_factory_t().spill(path + suffix, size);
+    };
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::spill(std::string path, std::size_t size) && -> builder&& {
+    return std::move(spill(std::move(path), size));
+}
+
+auto builder<sink::asynchronous_t>::shared() & -> builder& {
+    d->sharded = false;
+    d->bytes = 0;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::shared() && -> builder&& {
+    return std::move(shared());
+}
+
+auto builder<sink::asynchronous_t>::sharded(sink::merge_t merge) & -> builder& {
+    d->sharded = true;
+    d->merge = merge;
+    d->bytes = 0;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::sharded(sink::merge_t merge) && -> builder&& {
+    return std::move(sharded(merge));
+}
+
+auto builder<sink::asynchronous_t>::bytes(std::size_t capacity) & -> builder& {
+    d->sharded = false;
+    d->bytes = capacity;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::bytes(std::size_t capacity) && -> builder&& {
+    return std::move(bytes(capacity));
+}
+
+auto builder<sink::asynchronous_t>::park() & -> builder& {
+    d->underflow_policy = underflow("park");
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::park() && -> builder&& {
+    return std::move(park());
+}
+
+auto builder<sink::asynchronous_t>::spin() & -> builder& {
+    d->underflow_policy = underflow("spin");
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::spin() && -> builder&& {
+    return std::move(spin());
+}
+
+auto builder<sink::asynchronous_t>::ignore() & -> builder& {
+    d->exception_policy = [] {
+        return sink::exception_policy_factory_t().create("ignore");
+    };
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::ignore() && -> builder&& {
+    return std::move(ignore());
+}
+
+auto builder<sink::asynchronous_t>::retry(std::size_t attempts,
+                                          std::chrono::milliseconds backoff) & -> builder&
+{
+    // Fail early on invalid options.
+    sink::exception_policy_factory_t().retry(attempts, backoff);
+
+    d->exception_policy = [=] {
+        return sink::exception_policy_factory_t().retry(attempts, backoff);
+    };
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::retry(std::size_t attempts,
+                                          std::chrono::milliseconds backoff) && -> builder&&
+{
+    return std::move(retry(attempts, backoff));
+}
+
+auto builder<sink::asynchronous_t>::fallback(std::unique_ptr<sink_t> sink) & -> builder& {
+    std::shared_ptr<sink_t> fallback(std::move(sink));
+
+    d->exception_policy = [=] {
+        return sink::exception_policy_factory_t().fallback(fallback);
+    };
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::fallback(std::unique_ptr<sink_t> sink) && -> builder&& {
+    return std::move(fallback(std::move(sink)));
+}
+
+auto builder<sink::asynchronous_t>::workers(std::size_t count) & -> builder& {
+    d->workers = count;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::workers(std::size_t count) && -> builder&& {
+    return std::move(workers(count));
+}
+
+auto builder<sink::asynchronous_t>::key(std::string attribute) & -> builder& {
+    d->key = std::move(attribute);
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::key(std::string attribute) && -> builder&& {
+    return std::move(key(std::move(attribute)));
+}
+
+auto builder<sink::asynchronous_t>::deadline(std::chrono::milliseconds timeout) & -> builder& {
+    d->deadline = timeout;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::deadline(std::chrono::milliseconds timeout) && -> builder&& {
+    return std::move(deadline(timeout));
+}
+
+auto builder<sink::asynchronous_t>::name(std::string value) & -> builder& {
+    d->thread.options.name = std::move(value);
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::name(std::string value) && -> builder&& {
+    return std::move(name(std::move(value)));
+}
+
+auto builder<sink::asynchronous_t>::affinity(std::vector<std::size_t> cpus) & -> builder& {
+    d->thread.options.affinity = std::move(cpus);
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::affinity(std::vector<std::size_t> cpus) && -> builder&& {
+    return std::move(affinity(std::move(cpus)));
+}
+
+auto builder<sink::asynchronous_t>::nice(int value) & -> builder& {
+    d->thread.options.nice = value;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::nice(int value) && -> builder&& {
+    return std::move(nice(value));
+}
+
+auto builder<sink::asynchronous_t>::scheduler(sink::scheduler_t policy, int priority) & ->
+    builder&
+{
+    d->thread.options.scheduler = policy;
+    d->thread.options.priority = priority;
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::scheduler(sink::scheduler_t policy, int priority) && ->
+    builder&&
+{
+    return std::move(scheduler(policy, priority));
+}
+
+auto builder<sink::asynchronous_t>::group(std::string name) & -> builder& {
+    d->thread.group = std::move(name);
+    return *this;
+}
+
+auto builder<sink::asynchronous_t>::group(std::string name) && -> builder&& {
+    return std::move(group(std::move(name)));
+}
+
+auto builder<sink::asynchronous_t>::build() && ->
+    std::unique_ptr<sink::asynchronous::handle_t>
+{
+    const auto& d = *this->d;
+
+    auto worker = [&](std::unique_ptr<sink_t> wrapped, std::size_t index) ->
+        std::unique_ptr<sink::asynchronous_t>
+    {
+        std::unique_ptr<sink::asynchronous::queue_t> queue;
+        if (d.bytes > 0) {
+            queue = sink::asynchronous::queue_factory_t().bytes(d.bytes);
+        } else if (d.sharded) {
+            queue = sink::asynchronous::queue_factory_t().sharded(d.factor, d.merge);
+        } else {
+            queue = sink::asynchronous::queue_factory_t().create("shared", d.factor);
+        }
+
+        auto exception = create_exception_policy(d.thread, d.exception_policy);
+        auto consumer = create_consumer(d.thread, d.underflow_policy);
+
+        return blackhole::make_unique<sink::asynchronous_t>(std::move(wrapped), std::move(queue),
+            std::move(exception), d.overflow_policy(suffix(index, d.workers)),
+            std::move(consumer), d.deadline);
+    };
+
+    if (d.workers == 1) {
+        return worker(std::move(this->d->wrapped), 0);
+    }
+
+    std::unique_ptr<sink::asynchronous::key_t> key;
+    if (d.key.empty()) {
+        key.reset(new sink::asynchronous::thread_key_t);
+    } else {
+        key.reset(new sink::asynchronous::attribute_key_t(d.key));
+    }
+
+    return blackhole::make_unique<sink::asynchronous::pool_t>(std::move(this->d->wrapped),
+        std::move(key), d.workers, worker);
 }
 
 auto factory<sink::asynchronous_t>::type() const noexcept -> const char* {
@@ -71,13 +640,36 @@ auto factory<sink::asynchronous_t>::from(const config::node_t& config) const ->
     auto factory = registry.sink(type.get());
 
     auto factor = config["factor"].to_uint64().get();
-    auto overflow = sink::overflow_policy_factory_t().create(config["overflow"].to_string().get());
+    auto workers = config["workers"].to_uint64().get_value_or(1);
+    auto key = create_key(config["key"]);
+    auto deadline = std::chrono::milliseconds(config["deadline"].to_uint64().get_value_or(0));
+    auto exception = exception_policy(config["exception"], registry);
+    auto thread = placement(config["thread"]);
+
+    auto worker = [&](std::unique_ptr<sink_t> wrapped, std::size_t index) ->
+        std::unique_ptr<sink::asynchronous_t>
+    {
+        auto queue = create_queue(config["queue"], factor);
+        auto policy = create_exception_policy(thread, exception);
+        auto overflow = overflow_policy(config["overflow"], suffix(index, workers));
+        auto consumer = create_consumer(thread,
+            underflow(config["underflow"].to_string().get_value_or("park")));
+
+        return std::unique_ptr<sink::asynchronous_t>(new sink::asynchronous_t(std::move(wrapped),
+            std::move(queue), std::move(policy), std::move(overflow), std::move(consumer),
+            deadline));
+    };
 
     // It's safe to unwrap here, because we've already checked that there is "sink" child and it's
     // an object.
     auto sink = factory(*config["sink"].unwrap());
 
-    return std::unique_ptr<sink_t>(new sink::asynchronous_t(std::move(sink), factor, std::move(overflow)));
+    if (workers == 1) {
+        return worker(std::move(sink), 0);
+    }
+
+    return std::unique_ptr<sink_t>(new sink::asynchronous::pool_t(std::move(sink), std::move(key),
+        workers, worker));
 }
 
 template auto deleter_t::operator()(builder<sink::asynchronous_t>::inner_t* value) -> void;
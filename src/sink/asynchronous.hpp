@@ -1,11 +1,19 @@
 #include <atomic>
-#include <thread>
-
-#include <cds/container/vyukov_mpmc_cycle_queue.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
+#include "blackhole/record.hpp"
+#include "blackhole/severity.hpp"
 #include "blackhole/sink.hpp"
 
-#include "../recordbuf.hpp"
+#include "asynchronous/consumer.hpp"
+#include "asynchronous/drops.hpp"
+#include "asynchronous/queue.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -16,62 +24,372 @@ class overflow_policy_t {
 public:
     enum class action_t {
         retry,
-        drop
+        drop,
+        /// The record has been kept aside by the policy, see `replay`.
+        done
     };
 
+    typedef std::function<auto() -> bool> predicate_type;
+
 public:
     virtual ~overflow_policy_t() = default;
 
     /// Handles record queue overflow.
     ///
-    /// This method is called when the queue is unable to enqueue more items. It's okay to throw
-    /// exceptions from here, they will be propagated directly to the sink caller.
-    virtual auto overflow() -> action_t = 0;
+    /// This method is called when the queue is unable to enqueue more items with the record and its
+    /// formatted message, which must not be retained after returning. The given predicate returns
+    /// true if the queue certainly has free slots, i.e. it has been drained by the consumer.
+    /// Policies that block must check it after registering as a waiter, because slots freed before
+    /// that may not be notified about.
+    ///
+    /// It's okay to throw exceptions from here, they will be propagated directly to the sink
+    /// caller.
+    virtual auto overflow(const record_t& record, const string_view& message,
+                          const predicate_type& ready) -> action_t = 0;
 
+    /// Decides whether the given record may be enqueued at all.
+    ///
+    /// This method is called by producers before each enqueue, allowing to shed records before the
+    /// queue is actually full. Rejected records are accounted as dropped.
+    ///
+    /// The default implementation admits everything without looking at the queue.
+    virtual auto admit(const record_t&, const asynchronous::queue_t&) -> bool {
+        return true;
+    }
+
+    /// Returns true if `admit` looks at the queue occupancy, which the queue then has to track,
+    /// see `queue_t::track`.
+    ///
+    /// The default implementation does not look at the queue.
+    virtual auto observes() const noexcept -> bool {
+        return false;
+    }
+
+    /// Notifies about a freed queue slot.
+    ///
+    /// This method is called by the consumer thread after each dequeue, so it must be cheap when
+    /// there is nobody waiting.
     virtual auto wakeup() -> void = 0;
+
+    /// Moves the oldest record kept aside by this policy into the given slot.
+    ///
+    /// This method is called by the consumer thread once the queue has been drained, so it must be
+    /// cheap when there is nothing kept.
+    ///
+    /// The default implementation keeps nothing.
+    ///
+    /// \returns false if there are no records kept.
+    virtual auto replay(asynchronous::slot_t&) -> bool {
+        return false;
+    }
+
+    /// Returns the position after the last record kept aside, it never decreases.
+    ///
+    /// May be called from any thread. The default implementation keeps nothing.
+    virtual auto kept() const -> std::uint64_t {
+        return 0;
+    }
+
+    /// Returns the position after the last replayed record, it never decreases and reaches the
+    /// `kept` one once everything has been replayed.
+    ///
+    /// May be called from any thread. The default implementation keeps nothing.
+    virtual auto replayed() const -> std::uint64_t {
+        return 0;
+    }
+};
+
+/// Queue occupancy level, starting from which records of the given and higher severities are
+/// dropped, until the next watermark with higher severity.
+struct watermark_t {
+    severity_t severity;
+    /// In percents of the queue capacity.
+    std::size_t level;
 };
 
 class overflow_policy_factory_t {
 public:
+    /// Creates the "drop" or "wait" overflow policy by name. The "watermark" and "spill" ones
+    /// require options, see the methods below.
+    ///
+    /// \throw std::invalid_argument if the name is "spill", which requires a path, or unknown.
     auto create(const std::string& name) const -> std::unique_ptr<overflow_policy_t>;
+
+    /// Creates the wait overflow policy, which falls back to dropping a record if no queue slot
+    /// has been freed during the given timeout.
+    auto wait(std::chrono::milliseconds timeout) const -> std::unique_ptr<overflow_policy_t>;
+
+    /// Creates the watermark overflow policy, which drops records once the queue occupancy reaches
+    /// the watermark of their severity. Records with severity below any watermark are admitted
+    /// until the queue is full. On full queue records with severity of at least the given blocking
+    /// one wait for a free slot, others are dropped.
+    ///
+    /// \throw std::invalid_argument if some watermark level is greater than 100 percents.
+    auto watermark(std::vector<watermark_t> watermarks, severity_t blocking) const ->
+        std::unique_ptr<overflow_policy_t>;
+
+    /// Creates the spill overflow policy, which appends records that do not fit in the queue to
+    /// the memory-mapped file at the given path, of the given size in bytes. The consumer replays
+    /// them once the queue has been drained. Records that do not fit in the file are dropped.
+    /// Records left in the file when the process stops are replayed by the next policy opening it.
+    ///
+    /// \throw std::invalid_argument if the size does not fit in [64KiB; 4GiB) range or the existing
+    ///     file is not a spill file.
+    /// \throw std::system_error on I/O failure or if the file is used by another policy.
+    auto spill(const std::string& path, std::size_t size) const ->
+        std::unique_ptr<overflow_policy_t>;
 };
 
-class asynchronous_t : public sink_t {
-    struct value_type {
-        recordbuf_t record;
-        std::string message;
+/// Decides what the consumer thread does while the queue is empty.
+class underflow_policy_t {
+public:
+    typedef std::function<auto() -> bool> predicate_type;
+
+public:
+    virtual ~underflow_policy_t() = default;
+
+    /// Handles record queue underflow.
+    ///
+    /// This method is called by the consumer thread when there is nothing to dequeue. It may block
+    /// until the given predicate becomes true, which means that there are records to consume or the
+    /// sink is stopping, but is allowed to return earlier.
+    virtual auto underflow(const predicate_type& ready) -> void = 0;
+
+    /// Notifies the consumer about new records.
+    ///
+    /// This method is called by producers after each enqueue, so it must be cheap when the
+    /// consumer is not blocked.
+    virtual auto wakeup() -> void = 0;
+};
+
+class underflow_policy_factory_t {
+public:
+    auto create(const std::string& name) const -> std::unique_ptr<underflow_policy_t>;
+};
+
+/// Decides what the consumer thread does when the wrapped sink throws.
+class exception_policy_t {
+public:
+    enum class action_t {
+        /// Emit the batch again.
+        retry,
+        /// Give up the batch, its records are accounted as failed.
+        drop,
+        /// The batch has been taken care of, for example emitted elsewhere.
+        done
     };
 
-    typedef cds::container::VyukovMPSCCycleQueue<value_type> queue_type;
+public:
+    virtual ~exception_policy_t() = default;
+
+    /// Handles an exception thrown by the wrapped sink while emitting the given batch.
+    ///
+    /// This method is called by the consumer thread from within the catch block, so the exception
+    /// is available via `std::current_exception`. The attempt is the number of failed attempts to
+    /// emit this batch, starting from one. Note that the wrapped sink may have emitted some of the
+    /// batch records before throwing.
+    ///
+    /// Must not throw.
+    virtual auto handle(const sink_t::batch_t& batch, std::size_t attempt) -> action_t = 0;
+
+    /// Returns true if `handle` may block the consumer thread for a while. Such policies are not
+    /// allowed for sinks sharing a consumer thread, where one failing sink would stall all others.
+    ///
+    /// The default implementation never blocks.
+    virtual auto blocking() const noexcept -> bool {
+        return false;
+    }
+};
+
+class exception_policy_factory_t {
+public:
+    /// Creates either the "ignore" policy, which drops failed batches, or the "retry" policy with
+    /// 5 attempts and 10 ms initial backoff.
+    auto create(const std::string& name) const -> std::unique_ptr<exception_policy_t>;
 
-    queue_type queue;
+    /// Creates the retry policy, which emits a failed batch again until the given number of
+    /// attempts is exhausted, then drops it. The consumer sleeps between attempts, starting with
+    /// the given backoff and doubling it after each failure, up to a second, so the policy is
+    /// blocking.
+    ///
+    /// \throw std::invalid_argument if the number of attempts is zero.
+    auto retry(std::size_t attempts, std::chrono::milliseconds backoff) const ->
+        std::unique_ptr<exception_policy_t>;
+
+    /// Creates the fallback policy, which emits failed batches to the given sink instead. Batches
+    /// the fallback sink throws on are dropped.
+    ///
+    /// The fallback sink may be shared by several policies, therefore must be thread-safe then.
+    auto fallback(std::shared_ptr<sink_t> sink) const -> std::unique_ptr<exception_policy_t>;
+};
+
+class asynchronous_t : public asynchronous::handle_t {
+    friend class asynchronous::consumer_t;
+
+    /// Result of a single consumer step.
+    enum class state_t {
+        /// Some records or requests have been processed.
+        busy,
+        /// There is nothing to do.
+        idle,
+        /// The sink has been stopped and drained.
+        finished
+    };
+
+    /// Maximum number of records the consumer thread drains from the queue and hands over to the
+    /// wrapped sink as a single batch.
+    static constexpr std::size_t batch_limit = 64;
+
+    std::unique_ptr<asynchronous::queue_t> queue;
     std::atomic<bool> stopped;
     std::unique_ptr<sink_t> wrapped;
 
+    std::unique_ptr<exception_policy_t> exception_policy;
     std::unique_ptr<overflow_policy_t> overflow_policy;
 
-    std::thread thread;
+    asynchronous::drop_counter_t drops;
+    /// Number of records given up because the wrapped sink has thrown.
+    std::atomic<std::uint64_t> failures;
+
+    /// Maximum time to drain the queue on destruction, zero means no limit.
+    const std::chrono::milliseconds deadline;
+    std::chrono::steady_clock::time_point until;
+
+    /// Flush request with producer positions at the moment it was made.
+    struct request_t {
+        std::uint64_t ticket;
+        asynchronous::mark_t mark;
+        /// Position of the overflow policy, see `overflow_policy_t::kept`.
+        std::uint64_t kept;
+    };
+
+    /// Flush requests are numbered, the consumer completes them in order once it has popped past
+    /// their positions, regardless of records enqueued later.
+    std::atomic<std::uint64_t> requested;
+    std::atomic<std::uint64_t> completed;
+    /// Outstanding requests, guarded by the mutex.
+    std::vector<request_t> requests;
+    /// The highest overflow policy position of outstanding requests. Kept records are normally
+    /// replayed once the queue has been drained, but until this position they are replayed first,
+    /// otherwise requests would wait until the load stops.
+    std::atomic<std::uint64_t> replay_until;
+    std::mutex mutex;
+    std::condition_variable cv;
+    /// Set by the consumer once it no longer accesses this sink, guarded by the mutex.
+    bool finished;
+
+    /// Consumer thread state. Records are moved out of the queue into the pending buffer by
+    /// swapping, so both queue slots and batch elements keep their allocated storage.
+    std::vector<asynchronous::slot_t> pending;
+    std::vector<record_t> records;
+    std::vector<sink_t::entry_t> entries;
+    asynchronous::drops_t reported;
+
+    std::shared_ptr<asynchronous::consumer_t> consumer;
 
 public:
     asynchronous_t(std::unique_ptr<sink_t> wrapped, std::size_t factor = 10);
 
-    // TODO: Full customization.
     asynchronous_t(std::unique_ptr<sink_t> sink,
                    std::size_t factor,
-                //    std::unique_ptr<filter_t> filter,
-                //    std::unique_ptr<underflow_policy_t> underflow_policy,
-                //    std::unique_ptr<exception_policy_t> exception_policy,
                    std::unique_ptr<overflow_policy_t> overflow_policy);
 
+    asynchronous_t(std::unique_ptr<sink_t> sink,
+                   std::size_t factor,
+                   std::unique_ptr<overflow_policy_t> overflow_policy,
+                   std::unique_ptr<underflow_policy_t> underflow_policy);
+
+    // TODO: Full customization.
+    asynchronous_t(std::unique_ptr<sink_t> sink,
+                   std::unique_ptr<asynchronous::queue_t> queue,
+                //    std::unique_ptr<filter_t> filter,
+                   std::unique_ptr<exception_policy_t> exception_policy,
+                   std::unique_ptr<overflow_policy_t> overflow_policy,
+                   std::unique_ptr<underflow_policy_t> underflow_policy,
+                   std::chrono::milliseconds deadline = std::chrono::milliseconds::zero());
+
+    /// Constructs the sink consumed by the given, possibly shared, consumer thread.
+    asynchronous_t(std::unique_ptr<sink_t> sink,
+                   std::unique_ptr<asynchronous::queue_t> queue,
+                   std::unique_ptr<exception_policy_t> exception_policy,
+                   std::unique_ptr<overflow_policy_t> overflow_policy,
+                   std::shared_ptr<asynchronous::consumer_t> consumer,
+                   std::chrono::milliseconds deadline = std::chrono::milliseconds::zero());
+
+    /// Waits for the consumer thread to drain the queue, stopping it unless shared.
+    ///
+    /// If the drain deadline is set, records that have not been emitted by then are abandoned and
+    /// a synthetic record with their number is emitted instead.
     ~asynchronous_t();
 
     /// Returns the message queue capacity in number of events.
+    ///
+    /// For the sharded queue it is the capacity of each ring, for the byte queue it is in bytes.
     auto capacity() const -> std::size_t;
 
+    /// Returns the number of records dropped on queue overflow so far.
+    ///
+    /// May be called from any thread.
+    auto dropped() const -> asynchronous::drops_t override;
+
+    /// Returns the number of records given up because the wrapped sink has thrown, as decided by
+    /// the exception policy.
+    ///
+    /// May be called from any thread.
+    auto failed() const noexcept -> std::uint64_t override;
+
     auto emit(const record_t& record, const string_view& message) -> void;
 
+    /// Blocks until all records enqueued before this call are emitted and the wrapped sink is
+    /// flushed, or the given timeout expires.
+    ///
+    /// \returns false on timeout.
+    auto flush(std::chrono::milliseconds timeout) -> bool override;
+
+    /// Blocks until all records enqueued before this call are emitted and the wrapped sink is
+    /// flushed.
+    auto flush() -> void override;
+
 private:
-    auto run() -> void;
+    /// Emits a single batch of records or completes pending requests.
+    ///
+    /// Called by the consumer thread.
+    auto consume() -> state_t;
+
+    /// Returns true if there are records or requests to process.
+    ///
+    /// Called by the consumer thread.
+    auto ready() const -> bool;
+
+    /// Notifies the destructor that the consumer no longer accesses this sink.
+    auto release() -> void;
+
+    /// Emits the batch through the wrapped sink, handling its exceptions with the exception policy.
+    auto deliver(const sink_t::batch_t& batch) -> void;
+
+    /// Registers a new flush request, waking up the consumer.
+    ///
+    /// \returns its ticket.
+    auto request() -> std::uint64_t;
+
+    /// Completes flush requests whose records have all been popped.
+    ///
+    /// Called by the consumer thread.
+    ///
+    /// \returns false if there were none.
+    auto settle() -> bool;
+
+    /// Flushes the wrapped sink and marks flush requests up to the given one as completed.
+    auto complete(std::uint64_t ticket) -> void;
+
+    /// Discards all queued records, announcing their number.
+    auto abandon() -> void;
+
+    /// Emits a synthetic record with the given message through the wrapped sink.
+    auto announce(severity_t severity, const string_view& message) -> void;
+
+    /// Emits a synthetic record about records dropped since the previous report, if any.
+    auto report(asynchronous::drops_t& reported) -> void;
 };
 
 }  // namespace sink
@@ -1,20 +1,39 @@
 #include "asynchronous.hpp"
 
-#include <cmath>
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "asynchronous/spill.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 namespace sink {
 namespace {
 
-auto exp2(std::size_t factor) -> std::size_t {
-    if (factor < 2 || factor > 20) {
-        throw std::invalid_argument("factor should fit in [2; 20] range");
-    }
-
-    return static_cast<std::size_t>(std::exp2(factor));
+/// Hints the processor that the thread is spinning.
+inline auto relax() noexcept -> void {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
 }
 
 }  // namespace
@@ -24,7 +43,9 @@ class drop_overflow_policy_t : public overflow_policy_t {
 
 public:
     /// Drops on overlow.
-    virtual auto overflow() -> action_t {
+    virtual auto overflow(const record_t&, const string_view&, const predicate_type&) ->
+        action_t
+    {
         return action_t::drop;
     }
 
@@ -32,26 +53,224 @@ public:
     virtual auto wakeup() -> void {}
 };
 
+/// Blocks producers until the consumer frees some queue slot, optionally falling back to dropping
+/// records after the given timeout.
+///
+/// Waiting producers are counted, so the consumer pays for a single memory fence and a load per
+/// record unless someone is actually waiting.
 class wait_overflow_policy_t : public overflow_policy_t {
     typedef overflow_policy_t::action_t action_t;
 
-    mutable std::mutex mutex;
+    /// Zero means waiting without a time limit.
+    const std::chrono::milliseconds timeout;
+
+    /// Number of producers waiting or about to wait for a free slot.
+    std::atomic<int> waiters;
+    /// Incremented under the mutex on each notification, so producers can detect it without
+    /// missing one that happened before they started to wait.
+    std::atomic<std::uint64_t> epoch;
+
+    std::mutex mutex;
     std::condition_variable cv;
 
 public:
-    virtual auto overflow() -> action_t {
-        std::unique_lock<std::mutex> lock(mutex);
+    explicit wait_overflow_policy_t(std::chrono::milliseconds timeout = {}) :
+        timeout(timeout),
+        waiters(0),
+        epoch(0)
+    {}
 
-        // TODO: WTF? Replace with something more convenient and not filling my eyes with blood.
-        cv.wait_for(lock, std::chrono::milliseconds(1));
-        return action_t::retry;
+    virtual auto overflow(const record_t&, const string_view&, const predicate_type& ready) ->
+        action_t
+    {
+        const auto snapshot = epoch.load(std::memory_order_acquire);
+
+        // Register before the last check, pairs with the fence in `wakeup`, so either the consumer
+        // sees us waiting or we see the queue drained.
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+
+        auto notified = [&]() -> bool {
+            return epoch.load(std::memory_order_relaxed) != snapshot || ready();
+        };
+
+        bool woken;
+        if (notified()) {
+            woken = true;
+        } else {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if (timeout.count() == 0) {
+                cv.wait(lock, notified);
+                woken = true;
+            } else {
+                woken = cv.wait_for(lock, timeout, notified);
+            }
+        }
+
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        return woken ? action_t::retry : action_t::drop;
     }
 
     virtual auto wakeup() -> void {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            epoch.fetch_add(1, std::memory_order_release);
+        }
+
+        // A single slot has been freed, there is no point in waking up everyone.
         cv.notify_one();
     }
 };
 
+/// Sheds low severity records before the queue is full, keeping room for important ones.
+class watermark_overflow_policy_t : public overflow_policy_t {
+    typedef overflow_policy_t::action_t action_t;
+
+    /// Sorted by severity.
+    std::vector<watermark_t> watermarks;
+    severity_t blocking;
+
+    wait_overflow_policy_t wait;
+
+public:
+    watermark_overflow_policy_t(std::vector<watermark_t> watermarks, severity_t blocking) :
+        watermarks(std::move(watermarks)),
+        blocking(blocking)
+    {
+        for (const auto& watermark : this->watermarks) {
+            if (watermark.level > 100) {
+                throw std::invalid_argument("watermark level should fit in [0; 100] range");
+            }
+        }
+
+        std::stable_sort(std::begin(this->watermarks), std::end(this->watermarks),
+            [](const watermark_t& lhs, const watermark_t& rhs) -> bool {
+                return lhs.severity < rhs.severity;
+            });
+    }
+
+    auto admit(const record_t& record, const asynchronous::queue_t& queue) -> bool override {
+        const auto level = this->level(record.severity());
+
+        if (level >= 100) {
+            return true;
+        }
+
+        return queue.occupancy() * 100 < queue.capacity() * level;
+    }
+
+    auto observes() const noexcept -> bool override {
+        return true;
+    }
+
+    auto overflow(const record_t& record,
+                  const string_view& message,
+                  const predicate_type& ready) -> action_t override
+    {
+        if (record.severity() >= blocking) {
+            return wait.overflow(record, message, ready);
+        }
+
+        return action_t::drop;
+    }
+
+    auto wakeup() -> void override {
+        wait.wakeup();
+    }
+
+private:
+    auto level(severity_t severity) const noexcept -> std::size_t {
+        std::size_t result = 100;
+
+        for (const auto& watermark : watermarks) {
+            if (watermark.severity > severity) {
+                break;
+            }
+
+            result = watermark.level;
+        }
+
+        return result;
+    }
+};
+
+/// Keeps records that do not fit in the queue in a spill file, until the consumer replays them.
+class spill_overflow_policy_t : public overflow_policy_t {
+    typedef overflow_policy_t::action_t action_t;
+
+    /// Whether the file may have records, so the consumer does not lock the mutex otherwise.
+    std::atomic<bool> pending;
+    /// File positions, mirrored for readers that do not lock the mutex.
+    std::atomic<std::uint64_t> written;
+    std::atomic<std::uint64_t> read;
+
+    std::mutex mutex;
+    asynchronous::spill_t spill;
+
+public:
+    spill_overflow_policy_t(const std::string& path, std::size_t size) :
+        pending(false),
+        written(0),
+        read(0),
+        spill(path, size)
+    {
+        pending.store(!spill.empty(), std::memory_order_relaxed);
+        written.store(spill.written(), std::memory_order_relaxed);
+        read.store(spill.read(), std::memory_order_relaxed);
+    }
+
+    auto overflow(const record_t& record, const string_view& message, const predicate_type&) ->
+        action_t override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!spill.push(record, message)) {
+            return action_t::drop;
+        }
+
+        written.store(spill.written(), std::memory_order_release);
+        pending.store(true, std::memory_order_release);
+        return action_t::done;
+    }
+
+    auto wakeup() -> void override {}
+
+    auto replay(asynchronous::slot_t& slot) -> bool override {
+        if (!pending.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        bool popped = false;
+        try {
+            popped = spill.pop(slot);
+        } catch (const std::bad_alloc&) {
+            // The record is lost, the slot remains invalid.
+            popped = true;
+        }
+
+        read.store(spill.read(), std::memory_order_release);
+        pending.store(!spill.empty(), std::memory_order_release);
+        return popped;
+    }
+
+    auto kept() const -> std::uint64_t override {
+        return written.load(std::memory_order_acquire);
+    }
+
+    auto replayed() const -> std::uint64_t override {
+        return read.load(std::memory_order_acquire);
+    }
+};
+
 auto overflow_policy_factory_t::create(const std::string& name) const ->
     std::unique_ptr<overflow_policy_t>
 {
@@ -59,36 +278,336 @@ auto overflow_policy_factory_t::create(const std::string& name) const ->
         return std::unique_ptr<overflow_policy_t>(new drop_overflow_policy_t);
     } else if (name == "wait") {
         return std::unique_ptr<overflow_policy_t>(new wait_overflow_policy_t);
+    } else if (name == "spill") {
+        throw std::invalid_argument("spill overflow policy requires a path");
     }
 
     throw std::invalid_argument("no overflow policy with name \"" + name + "\" found");
 }
 
+auto overflow_policy_factory_t::spill(const std::string& path, std::size_t size) const ->
+    std::unique_ptr<overflow_policy_t>
+{
+    return std::unique_ptr<overflow_policy_t>(new spill_overflow_policy_t(path, size));
+}
+
+auto overflow_policy_factory_t::wait(std::chrono::milliseconds timeout) const ->
+    std::unique_ptr<overflow_policy_t>
+{
+    return std::unique_ptr<overflow_policy_t>(new wait_overflow_policy_t(timeout));
+}
+
+auto overflow_policy_factory_t::watermark(std::vector<watermark_t> watermarks,
+                                          severity_t blocking) const ->
+    std::unique_ptr<overflow_policy_t>
+{
+    return std::unique_ptr<overflow_policy_t>(
+        new watermark_overflow_policy_t(std::move(watermarks), blocking));
+}
+
+/// Spins for a while and then parks the consumer thread until some producer wakes it up.
+///
+/// Producers pay for a single memory fence and a load per record unless the consumer is parked, in
+/// which case they wake it up. On Linux parking is implemented directly on top of futex, elsewhere
+/// with a condition variable.
+class park_underflow_policy_t : public underflow_policy_t {
+    /// Number of spins with the processor hint before parking.
+    static constexpr int spins = 2048;
+
+    /// Non-zero while the consumer is parked or is about to park.
+    std::atomic<int> parked;
+
+#if !defined(__linux__)
+    std::mutex mutex;
+    std::condition_variable cv;
+#endif
+
+public:
+    park_underflow_policy_t() : parked(0) {}
+
+    auto underflow(const predicate_type& ready) -> void override {
+        for (int i = 0; i < spins; ++i) {
+            if (ready()) {
+                return;
+            }
+
+            relax();
+        }
+
+        // Announce parking before the last check, pairs with the fence in `wakeup`, so either the
+        // producer sees the flag or we see its record.
+        parked.store(1, std::memory_order_seq_cst);
+
+        if (ready()) {
+            parked.store(0, std::memory_order_relaxed);
+            return;
+        }
+
+        park();
+        parked.store(0, std::memory_order_relaxed);
+    }
+
+    auto wakeup() -> void override {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (parked.load(std::memory_order_relaxed) != 0) {
+            unpark();
+        }
+    }
+
+private:
+#if defined(__linux__)
+    auto park() -> void {
+        // Returns immediately if the flag has already been reset by some producer. Spurious
+        // wakeups are fine, the consumer just checks the queue once again.
+        ::syscall(SYS_futex, reinterpret_cast<int*>(&parked), FUTEX_WAIT_PRIVATE, 1, nullptr,
+            nullptr, 0);
+    }
+
+    auto unpark() -> void {
+        if (parked.exchange(0, std::memory_order_relaxed) != 0) {
+            ::syscall(SYS_futex, reinterpret_cast<int*>(&parked), FUTEX_WAKE_PRIVATE, 1, nullptr,
+                nullptr, 0);
+        }
+    }
+#else
+    auto park() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+            return parked.load(std::memory_order_relaxed) == 0;
+        });
+    }
+
+    auto unpark() -> void {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            parked.store(0, std::memory_order_relaxed);
+        }
+
+        cv.notify_one();
+    }
+#endif
+};
+
+/// Never blocks, busy polling the queue. Trades a whole processor core for the lowest latency.
+class spin_underflow_policy_t : public underflow_policy_t {
+public:
+    auto underflow(const predicate_type&) -> void override {
+        relax();
+    }
+
+    auto wakeup() -> void override {}
+};
+
+auto underflow_policy_factory_t::create(const std::string& name) const ->
+    std::unique_ptr<underflow_policy_t>
+{
+    if (name == "park") {
+        return std::unique_ptr<underflow_policy_t>(new park_underflow_policy_t);
+    } else if (name == "spin") {
+        return std::unique_ptr<underflow_policy_t>(new spin_underflow_policy_t);
+    }
+
+    throw std::invalid_argument("no underflow policy with name \"" + name + "\" found");
+}
+
+constexpr std::size_t asynchronous_t::batch_limit;
+
+/// Drops failed batches.
+class ignore_exception_policy_t : public exception_policy_t {
+public:
+    auto handle(const sink_t::batch_t&, std::size_t) -> action_t override {
+        return action_t::drop;
+    }
+};
+
+/// Emits failed batches again with exponential backoff, for example while the wrapped sink
+/// reconnects.
+class retry_exception_policy_t : public exception_policy_t {
+    const std::size_t attempts;
+    const std::chrono::milliseconds backoff;
+
+public:
+    retry_exception_policy_t(std::size_t attempts, std::chrono::milliseconds backoff) :
+        attempts(attempts),
+        backoff(backoff)
+    {
+        if (attempts == 0) {
+            throw std::invalid_argument("number of attempts should be positive");
+        }
+    }
+
+    auto handle(const sink_t::batch_t&, std::size_t attempt) -> action_t override {
+        if (attempt >= attempts) {
+            return action_t::drop;
+        }
+
+        const std::chrono::milliseconds limit(1000);
+
+        auto delay = backoff;
+        for (std::size_t i = 1; i < attempt && delay < limit; ++i) {
+            delay *= 2;
+        }
+
+        std::this_thread::sleep_for(std::min(delay, limit));
+        return action_t::retry;
+    }
+
+    auto blocking() const noexcept -> bool override {
+        return true;
+    }
+};
+
+/// Emits failed batches to another sink.
+class fallback_exception_policy_t : public exception_policy_t {
+    std::shared_ptr<sink_t> sink;
+
+public:
+    explicit fallback_exception_policy_t(std::shared_ptr<sink_t> sink) :
+        sink(std::move(sink))
+    {}
+
+    auto handle(const sink_t::batch_t& batch, std::size_t) -> action_t override {
+        try {
+            sink->emit_batch(batch);
+        } catch (...) {
+            return action_t::drop;
+        }
+
+        return action_t::done;
+    }
+};
+
+auto exception_policy_factory_t::create(const std::string& name) const ->
+    std::unique_ptr<exception_policy_t>
+{
+    if (name == "ignore") {
+        return std::unique_ptr<exception_policy_t>(new ignore_exception_policy_t);
+    } else if (name == "retry") {
+        return retry(5, std::chrono::milliseconds(10));
+    }
+
+    throw std::invalid_argument("no exception policy with name \"" + name + "\" found");
+}
+
+auto exception_policy_factory_t::retry(std::size_t attempts,
+                                       std::chrono::milliseconds backoff) const ->
+    std::unique_ptr<exception_policy_t>
+{
+    return std::unique_ptr<exception_policy_t>(new retry_exception_policy_t(attempts, backoff));
+}
+
+auto exception_policy_factory_t::fallback(std::shared_ptr<sink_t> sink) const ->
+    std::unique_ptr<exception_policy_t>
+{
+    return std::unique_ptr<exception_policy_t>(new fallback_exception_policy_t(std::move(sink)));
+}
+
 asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> wrapped, std::size_t factor) :
-    queue(exp2(factor)),
-    stopped(false),
-    wrapped(std::move(wrapped)),
-    overflow_policy(new wait_overflow_policy_t),
-    thread(std::bind(&asynchronous_t::run, this))
+    asynchronous_t(std::move(wrapped), factor,
+        std::unique_ptr<overflow_policy_t>(new wait_overflow_policy_t))
 {}
 
 asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
                                std::size_t factor,
                                std::unique_ptr<overflow_policy_t> overflow_policy) :
-    queue(exp2(factor)),
+    asynchronous_t(std::move(sink), factor, std::move(overflow_policy),
+        std::unique_ptr<underflow_policy_t>(new park_underflow_policy_t))
+{}
+
+asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
+                               std::size_t factor,
+                               std::unique_ptr<overflow_policy_t> overflow_policy,
+                               std::unique_ptr<underflow_policy_t> underflow_policy) :
+    asynchronous_t(std::move(sink), asynchronous::queue_factory_t().create("shared", factor),
+        exception_policy_factory_t().create("ignore"), std::move(overflow_policy),
+        std::move(underflow_policy))
+{}
+
+asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
+                               std::unique_ptr<asynchronous::queue_t> queue,
+                               std::unique_ptr<exception_policy_t> exception_policy,
+                               std::unique_ptr<overflow_policy_t> overflow_policy,
+                               std::unique_ptr<underflow_policy_t> underflow_policy,
+                               std::chrono::milliseconds deadline) :
+    asynchronous_t(std::move(sink), std::move(queue), std::move(exception_policy),
+        std::move(overflow_policy), std::make_shared<asynchronous::consumer_t>(
+            asynchronous::thread_options_t(), std::move(underflow_policy)), deadline)
+{}
+
+asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
+                               std::unique_ptr<asynchronous::queue_t> queue,
+                               std::unique_ptr<exception_policy_t> exception_policy,
+                               std::unique_ptr<overflow_policy_t> overflow_policy,
+                               std::shared_ptr<asynchronous::consumer_t> consumer,
+                               std::chrono::milliseconds deadline) :
+    queue(std::move(queue)),
     stopped(false),
     wrapped(std::move(sink)),
+    exception_policy(std::move(exception_policy)),
     overflow_policy(std::move(overflow_policy)),
-    thread(std::bind(&asynchronous_t::run, this))
-{}
+    failures(0),
+    deadline(deadline),
+    until(),
+    requested(0),
+    completed(0),
+    replay_until(0),
+    finished(false),
+    pending(std::min(this->queue->capacity(), batch_limit)),
+    consumer(std::move(consumer))
+{
+    records.reserve(pending.size());
+    entries.reserve(pending.size());
+
+    if (this->overflow_policy->observes()) {
+        this->queue->track();
+    }
+
+    this->consumer->attach(*this);
+}
 
 asynchronous_t::~asynchronous_t() {
+    // Published to the consumer by the stop flag.
+    until = std::chrono::steady_clock::now() + deadline;
     stopped.store(true);
-    thread.join();
+    consumer->wakeup();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] {
+        return finished;
+    });
 }
 
 auto asynchronous_t::capacity() const -> std::size_t {
-    return queue.capacity();
+    return queue->capacity();
+}
+
+auto asynchronous_t::dropped() const -> asynchronous::drops_t {
+    return drops.snapshot();
+}
+
+auto asynchronous_t::failed() const noexcept -> std::uint64_t {
+    return failures.load(std::memory_order_relaxed);
+}
+
+auto asynchronous_t::flush(std::chrono::milliseconds timeout) -> bool {
+    const auto ticket = request();
+
+    auto done = [&]() -> bool {
+        return completed.load(std::memory_order_acquire) >= ticket;
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    return cv.wait_for(lock, timeout, done);
+}
+
+auto asynchronous_t::flush() -> void {
+    const auto ticket = request();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() -> bool {
+        return completed.load(std::memory_order_acquire) >= ticket;
+    });
 }
 
 auto asynchronous_t::emit(const record_t& record, const string_view& message) -> void {
@@ -102,48 +621,262 @@ auto asynchronous_t::emit(const record_t& record, const string_view& message) ->
         //     return;
         // }
 
-        const auto enqueued = queue.enqueue_with([&](value_type& value) {
-            value = {recordbuf_t(record), message.to_string()};
-        });
+        if (!overflow_policy->admit(record, *queue)) {
+            drops.add(record.severity());
+            return;
+        }
+
+        bool enqueued;
+
+        try {
+            enqueued = queue->push(record, message);
+        } catch (const std::length_error&) {
+            // The record would never fit in the queue.
+            drops.add(record.severity());
+            return;
+        }
 
         if (enqueued) {
-            // TODO: underflow_policy->wakeup();
+            consumer->wakeup();
             return;
         } else {
-            switch (overflow_policy->overflow()) {
+            const auto action = overflow_policy->overflow(record, message, [&]() -> bool {
+                return queue->empty();
+            });
+
+            switch (action) {
             case overflow_policy_t::action_t::retry:
                 continue;
             case overflow_policy_t::action_t::drop:
+                drops.add(record.severity());
+                return;
+            case overflow_policy_t::action_t::done:
+                consumer->wakeup();
                 return;
             }
         }
     }
 }
 
-auto asynchronous_t::run() -> void {
-    while (true) {
-        value_type result;
-        const auto dequeued = queue.dequeue_with([&](value_type& value) {
-            result = std::move(value);
-        });
+auto asynchronous_t::consume() -> state_t {
+    if (deadline.count() > 0 && stopped && std::chrono::steady_clock::now() >= until) {
+        abandon();
+        complete(requested.load(std::memory_order_acquire));
+        return state_t::finished;
+    }
+
+    std::size_t count = 0;
+
+    // Kept records some flush request waits for go first.
+    const auto until = replay_until.load(std::memory_order_acquire);
+    while (count < pending.size() && overflow_policy->replayed() < until) {
+        if (!overflow_policy->replay(pending[count])) {
+            break;
+        }
+
+        ++count;
+    }
 
-        if (stopped && !dequeued) {
+    while (count < pending.size()) {
+        if (!queue->pop(pending[count])) {
+            break;
+        }
+
+        ++count;
+        overflow_policy->wakeup();
+    }
+
+    // Records kept aside on overflow are older than the ones enqueued after, but are emitted only
+    // once the queue has been drained, so producers are not blocked meanwhile.
+    if (count == 0) {
+        while (count < pending.size() && overflow_policy->replay(pending[count])) {
+            ++count;
+        }
+    }
+
+    if (count == 0) {
+        // The queue has recovered, so it is time to tell how many records have been lost.
+        report(reported);
+
+        if (stopped) {
+            complete(requested.load(std::memory_order_acquire));
+            return state_t::finished;
+        }
+
+        return settle() ? state_t::busy : state_t::idle;
+    }
+
+    records.clear();
+    entries.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (pending[i].valid) {
+            records.push_back(pending[i].record.into_view());
+            entries.push_back({records.back(), pending[i].message});
+        }
+    }
+
+    if (!entries.empty()) {
+        deliver(sink_t::batch_t(entries.data(), entries.size()));
+    }
+
+    settle();
+    return state_t::busy;
+}
+
+auto asynchronous_t::ready() const -> bool {
+    return stopped.load() || !queue->empty() ||
+        requested.load(std::memory_order_acquire) != completed.load(std::memory_order_relaxed);
+}
+
+auto asynchronous_t::release() -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+
+    // Under the lock, otherwise the destructor may return before we are done with the variable.
+    cv.notify_all();
+}
+
+auto asynchronous_t::deliver(const sink_t::batch_t& batch) -> void {
+    for (std::size_t attempt = 1; ; ++attempt) {
+        try {
+            wrapped->emit_batch(batch);
             return;
+        } catch (...) {
+            // Exceptions must not escape the consumer thread, which would terminate the process.
+            switch (exception_policy->handle(batch, attempt)) {
+            case exception_policy_t::action_t::retry:
+                break;
+            case exception_policy_t::action_t::drop:
+                failures.fetch_add(batch.size(), std::memory_order_relaxed);
+                return;
+            case exception_policy_t::action_t::done:
+                return;
+            }
+        }
+    }
+}
+
+auto asynchronous_t::request() -> std::uint64_t {
+    std::uint64_t ticket;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto kept = overflow_policy->kept();
+        ticket = requested.load(std::memory_order_relaxed) + 1;
+        requests.push_back({ticket, queue->mark(), kept});
+
+        if (kept > replay_until.load(std::memory_order_relaxed)) {
+            replay_until.store(kept, std::memory_order_release);
         }
 
-        if (dequeued) {
-            try {
-                wrapped->emit(result.record.into_view(), result.message);
-                overflow_policy->wakeup();
-            } catch (...) {
-                throw;
-                // TODO: exception_policy->process();
+        // Published last, so the consumer finds the request once it notices a new ticket.
+        requested.store(ticket, std::memory_order_release);
+    }
+
+    consumer->wakeup();
+    return ticket;
+}
+
+auto asynchronous_t::settle() -> bool {
+    if (requested.load(std::memory_order_acquire) == completed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    std::uint64_t ticket = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto replayed = overflow_policy->replayed();
+        for (const auto& request : requests) {
+            if (replayed < request.kept || !queue->passed(request.mark)) {
+                break;
             }
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            // TODO: underflow_policy->underflow(); [wait for enqueue, sleep].
+
+            ticket = request.ticket;
         }
     }
+
+    if (ticket == 0) {
+        return false;
+    }
+
+    complete(ticket);
+    return true;
+}
+
+auto asynchronous_t::complete(std::uint64_t ticket) -> void {
+    try {
+        wrapped->flush();
+    } catch (...) {
+        // Flush failures are of no interest to anyone waiting, the next flush will try again.
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.store(ticket, std::memory_order_release);
+
+        auto it = requests.begin();
+        while (it != requests.end() && it->ticket <= ticket) {
+            ++it;
+        }
+        requests.erase(requests.begin(), it);
+    }
+
+    cv.notify_all();
+}
+
+auto asynchronous_t::abandon() -> void {
+    std::uint64_t count = 0;
+    severity_t severity = 0;
+
+    asynchronous::slot_t slot;
+    while (queue->pop(slot)) {
+        overflow_policy->wakeup();
+
+        if (slot.valid) {
+            ++count;
+            severity = std::max<int>(severity, slot.record.into_view().severity());
+        }
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    writer_t writer;
+    writer.write("abandoned {} records on shutdown", count);
+    announce(severity, writer.result());
+}
+
+auto asynchronous_t::announce(severity_t severity, const string_view& message) -> void {
+    const attribute_pack pack;
+    record_t record(severity, message, pack);
+    record.activate(message);
+
+    try {
+        wrapped->emit(record, message);
+    } catch (...) {
+        // Synthetic records are best effort.
+    }
+}
+
+auto asynchronous_t::report(asynchronous::drops_t& reported) -> void {
+    if (!drops.reset()) {
+        return;
+    }
+
+    const auto snapshot = drops.snapshot();
+    const auto delta = snapshot.since(reported);
+    reported = snapshot;
+
+    if (delta.total() == 0) {
+        return;
+    }
+
+    writer_t writer;
+    const auto severity = asynchronous::describe(delta, writer);
+
+    announce(severity, writer.result());
 }
 
 }  // namespace sink
@@ -0,0 +1,255 @@
+#include "codec.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/extensions/writer.hpp"
+
+#include "../../record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Attribute value tags.
+enum class tag_t : std::uint8_t {
+    null,
+    boolean,
+    sint64,
+    uint64,
+    floating,
+    string
+};
+
+/// Appends fixed-size values and length-prefixed strings to a buffer.
+class encoder_t {
+    std::string& buffer;
+
+public:
+    explicit encoder_t(std::string& buffer) noexcept : buffer(buffer) {}
+
+    template<typename T>
+    auto put(const T& value) -> void {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    auto put_string(const string_view& value) -> void {
+        put(static_cast<std::uint32_t>(value.size()));
+        buffer.append(value.data(), value.size());
+    }
+};
+
+/// Reads values written by the encoder.
+///
+/// Reads past the end yield zero values and empty strings, marking the decoder as failed.
+class decoder_t {
+    const char* it;
+    const char* end;
+    bool failed;
+
+public:
+    decoder_t(const char* it, std::size_t size) noexcept :
+        it(it),
+        end(it + size),
+        failed(false)
+    {}
+
+    /// Returns true if some read has crossed the end.
+    auto fail() const noexcept -> bool {
+        return failed;
+    }
+
+    /// Marks the data as malformed.
+    auto invalidate() noexcept -> void {
+        failed = true;
+        it = end;
+    }
+
+    template<typename T>
+    auto get() noexcept -> T {
+        T value{};
+        if (static_cast<std::size_t>(end - it) < sizeof(value)) {
+            invalidate();
+            return value;
+        }
+
+        std::memcpy(&value, it, sizeof(value));
+        it += sizeof(value);
+        return value;
+    }
+
+    auto get_string() noexcept -> string_view {
+        const auto size = get<std::uint32_t>();
+        if (static_cast<std::size_t>(end - it) < size) {
+            invalidate();
+            return string_view("", 0);
+        }
+
+        const string_view result(it, size);
+        it += size;
+        return result;
+    }
+};
+
+/// Encodes attribute values, rendering lazy ones into strings.
+class encode_visitor : public attribute::view_t::visitor_t {
+    encoder_t& encoder;
+
+public:
+    explicit encode_visitor(encoder_t& encoder) noexcept : encoder(encoder) {}
+
+    auto operator()(const attribute::view_t::null_type&) -> void override {
+        encoder.put(tag_t::null);
+    }
+
+    auto operator()(const attribute::view_t::bool_type& value) -> void override {
+        encoder.put(tag_t::boolean);
+        encoder.put(value);
+    }
+
+    auto operator()(const attribute::view_t::sint64_type& value) -> void override {
+        encoder.put(tag_t::sint64);
+        encoder.put(value);
+    }
+
+    auto operator()(const attribute::view_t::uint64_type& value) -> void override {
+        encoder.put(tag_t::uint64);
+        encoder.put(value);
+    }
+
+    auto operator()(const attribute::view_t::double_type& value) -> void override {
+        encoder.put(tag_t::floating);
+        encoder.put(value);
+    }
+
+    auto operator()(const attribute::view_t::string_type& value) -> void override {
+        encoder.put(tag_t::string);
+        encoder.put_string(value);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) -> void override {
+        writer_t writer;
+        value(writer);
+
+        encoder.put(tag_t::string);
+        encoder.put_string(writer.result());
+    }
+};
+
+auto decode(decoder_t& decoder) -> attribute::view_t {
+    switch (decoder.get<tag_t>()) {
+    case tag_t::null:
+        return attribute::view_t();
+    case tag_t::boolean:
+        return attribute::view_t(decoder.get<std::uint8_t>() != 0);
+    case tag_t::sint64:
+        return attribute::view_t(decoder.get<std::int64_t>());
+    case tag_t::uint64:
+        return attribute::view_t(decoder.get<std::uint64_t>());
+    case tag_t::floating:
+        return attribute::view_t(decoder.get<double>());
+    case tag_t::string:
+        return attribute::view_t(decoder.get_string());
+    }
+
+    decoder.invalidate();
+    return attribute::view_t();
+}
+
+}  // namespace
+
+auto encode(const record_t& record, const string_view& message, std::string& buffer) -> void {
+    encoder_t encoder(buffer);
+
+    encoder.put(static_cast<int>(record.severity()));
+    encoder.put(static_cast<std::uint32_t>(record.pid()));
+    encoder.put(record.timestamp().time_since_epoch().count());
+    encoder.put(record.lwp());
+    encoder.put(record.tid());
+
+    const auto thread = record.thread_name();
+    encoder.put(static_cast<std::uint8_t>(thread != nullptr));
+    encoder.put_string(thread ? string_view(thread, std::strlen(thread)) : string_view("", 0));
+
+    // Unformatted records share the same data for both messages.
+    const auto& formatted = record.formatted();
+    const auto shared = record.message().data() == formatted.data() &&
+        record.message().size() == formatted.size();
+
+    encoder.put_string(record.message());
+    encoder.put(static_cast<std::uint8_t>(shared));
+    if (!shared) {
+        encoder.put_string(formatted);
+    }
+
+    encoder.put_string(message);
+
+    std::uint32_t count = 0;
+    for (const auto& list : record.attributes()) {
+        count += static_cast<std::uint32_t>(list.get().size());
+    }
+
+    encoder.put(count);
+
+    encode_visitor visitor(encoder);
+    for (const auto& list : record.attributes()) {
+        for (const auto& attribute : list.get()) {
+            encoder.put_string(attribute.first);
+            attribute.second.apply(visitor);
+        }
+    }
+}
+
+auto decode(const char* data, std::size_t size, attribute_list& attributes, slot_t& slot) -> bool {
+    slot.valid = false;
+
+    decoder_t decoder(data, size);
+
+    const severity_t severity = decoder.get<int>();
+    const auto pid = decoder.get<std::uint32_t>();
+    const auto timestamp = record_t::time_point(
+        record_t::clock_type::duration(decoder.get<record_t::clock_type::rep>()));
+    const auto lwp = decoder.get<std::uint64_t>();
+    const auto tid = decoder.get<std::thread::native_handle_type>();
+
+    const auto named = decoder.get<std::uint8_t>() != 0;
+    const auto name = decoder.get_string();
+    // The name is copied into the slot, which expects a null-terminated string.
+    char thread[16] = {};
+    std::memcpy(thread, name.data(), std::min(name.size(), sizeof(thread) - 1));
+
+    const auto message = decoder.get_string();
+    const auto shared = decoder.get<std::uint8_t>() != 0;
+    const auto formatted = shared ? message : decoder.get_string();
+    const auto output = decoder.get_string();
+
+    const auto count = decoder.get<std::uint32_t>();
+    attributes.clear();
+    // The count is checked against the data read rather than trusted for reservation.
+    for (std::uint32_t i = 0; i < count && !decoder.fail(); ++i) {
+        const auto key = decoder.get_string();
+        attributes.emplace_back(key, decode(decoder));
+    }
+
+    if (decoder.fail()) {
+        return false;
+    }
+
+    const attribute_pack pack{attributes};
+    const record_t record(record_t::inner_t{
+        message, formatted, severity, pid, timestamp, lwp, tid, named ? thread : nullptr, pack
+    });
+
+    slot.assign(record, output);
+    return true;
+}
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "blackhole/attributes.hpp"
+
+#include "queue.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+
+/// Serializes the given record with its formatted message, appending to the buffer.
+///
+/// Lazy attribute values are rendered into strings. The result is a flat byte sequence without
+/// pointers, so it may be kept in shared memory or in a file.
+auto encode(const record_t& record, const string_view& message, std::string& buffer) -> void;
+
+/// Copies the record serialized with `encode` into the given slot.
+///
+/// Reads never cross the given size, so the data may come from an untrusted source like a file.
+///
+/// The attribute list is used as a scratch storage for attribute views, so it may be reused
+/// between calls to avoid allocations.
+///
+/// \returns false if the data is truncated or malformed, leaving the slot invalid.
+/// \throw std::bad_alloc on memory allocation failure, leaving the slot invalid.
+auto decode(const char* data, std::size_t size, attribute_list& attributes, slot_t& slot) -> bool;
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
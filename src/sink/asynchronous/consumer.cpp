@@ -0,0 +1,261 @@
+#include "consumer.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(__linux__)
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <future>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "blackhole/thread.hpp"
+
+#include "../asynchronous.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Maximum thread name length, not including the terminating null character.
+constexpr std::size_t name_limit = 15;
+
+auto check(int rc, const char* what) -> void {
+    if (rc != 0) {
+        throw std::system_error(rc, std::system_category(), what);
+    }
+}
+
+auto unsupported(const char* what) -> void {
+    throw std::system_error(std::make_error_code(std::errc::not_supported), what);
+}
+
+auto validate(const thread_options_t& options) -> void {
+    if (options.name.size() > name_limit) {
+        throw std::invalid_argument("thread name should be at most 15 characters long");
+    }
+
+#if defined(__linux__)
+    for (auto cpu : options.affinity) {
+        if (cpu >= CPU_SETSIZE) {
+            throw std::invalid_argument("processor " + std::to_string(cpu) +
+                " is out of the supported range");
+        }
+    }
+#endif
+}
+
+auto native(scheduler_t scheduler) -> int {
+    switch (scheduler) {
+    case scheduler_t::other:
+        return SCHED_OTHER;
+    case scheduler_t::fifo:
+        return SCHED_FIFO;
+    case scheduler_t::rr:
+        return SCHED_RR;
+#if defined(__linux__)
+    case scheduler_t::batch:
+        return SCHED_BATCH;
+    case scheduler_t::idle:
+        return SCHED_IDLE;
+#endif
+    default:
+        unsupported("failed to set thread scheduler");
+    }
+
+    return SCHED_OTHER;
+}
+
+/// Applies the given options to the calling thread.
+auto apply(const thread_options_t& options) -> void {
+    if (!options.name.empty()) {
+        this_thread::set_name(options.name);
+    }
+
+    if (!options.affinity.empty()) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : options.affinity) {
+            CPU_SET(cpu, &set);
+        }
+
+        check(::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set),
+            "failed to set thread affinity");
+#else
+        unsupported("failed to set thread affinity");
+#endif
+    }
+
+    if (options.scheduler) {
+        sched_param param{};
+        param.sched_priority = options.priority;
+
+        check(::pthread_setschedparam(::pthread_self(), native(options.scheduler.get()), &param),
+            "failed to set thread scheduler");
+    }
+
+    // Set after the scheduler, which may reset it.
+    if (options.nice) {
+#if defined(__linux__)
+        // On Linux the nice value is a per-thread attribute, despite the POSIX interface.
+        const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+
+        if (::setpriority(PRIO_PROCESS, tid, options.nice.get()) != 0) {
+            check(errno, "failed to set thread nice value");
+        }
+#else
+        unsupported("failed to set thread nice value");
+#endif
+    }
+}
+
+}  // namespace
+
+consumer_t::consumer_t(thread_options_t options,
+                       std::unique_ptr<underflow_policy_t> underflow_policy) :
+    options(std::move(options)),
+    underflow_policy(std::move(underflow_policy)),
+    stopped(false),
+    version(0)
+{
+    validate(this->options);
+
+    // Shared with the thread, which may still be inside `set_value` when the future is ready.
+    auto started = std::make_shared<std::promise<void>>();
+    auto future = started->get_future();
+
+    thread = std::thread([this, started] {
+        try {
+            apply(this->options);
+        } catch (...) {
+            started->set_exception(std::current_exception());
+            return;
+        }
+
+        started->set_value();
+        run();
+    });
+
+    try {
+        future.get();
+    } catch (...) {
+        thread.join();
+        throw;
+    }
+}
+
+consumer_t::~consumer_t() {
+    stopped.store(true);
+    underflow_policy->wakeup();
+    thread.join();
+}
+
+auto consumer_t::attach(asynchronous_t& sink) -> void {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sinks.push_back(&sink);
+        version.fetch_add(1, std::memory_order_release);
+    }
+
+    underflow_policy->wakeup();
+}
+
+auto consumer_t::wakeup() -> void {
+    underflow_policy->wakeup();
+}
+
+auto consumer_t::run() -> void {
+    // Snapshot of attached sinks, so the mutex is locked only when they change.
+    std::vector<asynchronous_t*> active;
+    std::uint64_t seen = 0;
+
+    while (true) {
+        if (version.load(std::memory_order_acquire) != seen) {
+            std::lock_guard<std::mutex> lock(mutex);
+            active = sinks;
+            seen = version.load(std::memory_order_relaxed);
+        }
+
+        if (active.empty() && stopped) {
+            return;
+        }
+
+        bool busy = false;
+        for (auto sink : active) {
+            switch (sink->consume()) {
+            case asynchronous_t::state_t::busy:
+                busy = true;
+                break;
+            case asynchronous_t::state_t::idle:
+                break;
+            case asynchronous_t::state_t::finished:
+                // The sink may be destroyed right after, the snapshot is refreshed before the next
+                // round.
+                detach(*sink);
+                busy = true;
+                break;
+            }
+        }
+
+        if (busy) {
+            continue;
+        }
+
+        underflow_policy->underflow([&]() -> bool {
+            if (stopped.load() || version.load(std::memory_order_acquire) != seen) {
+                return true;
+            }
+
+            return std::any_of(std::begin(active), std::end(active), [](asynchronous_t* sink) {
+                return sink->ready();
+            });
+        });
+    }
+}
+
+auto consumer_t::detach(asynchronous_t& sink) -> void {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sinks.erase(std::remove(std::begin(sinks), std::end(sinks), &sink), std::end(sinks));
+        version.fetch_add(1, std::memory_order_release);
+    }
+
+    sink.release();
+}
+
+auto shared_consumer(const std::string& group,
+                     const thread_options_t& options,
+                     const std::function<auto() -> std::unique_ptr<underflow_policy_t>>& factory) ->
+    std::shared_ptr<consumer_t>
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<consumer_t>> consumers;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& consumer = consumers[group];
+    if (auto result = consumer.lock()) {
+        return result;
+    }
+
+    auto result = std::make_shared<consumer_t>(options, factory());
+    consumer = result;
+    return result;
+}
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/sink/asynchronous.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+class asynchronous_t;
+class underflow_policy_t;
+
+namespace asynchronous {
+
+/// Placement of the consumer thread, applied by the thread itself before consuming anything.
+/// Unset options are inherited from the thread that starts the consumer.
+struct thread_options_t {
+    /// Thread name, at most 15 characters. Empty means the inherited name.
+    std::string name;
+    /// Processors the thread is allowed to run on. Empty means the inherited mask.
+    std::vector<std::size_t> affinity;
+    boost::optional<int> nice;
+    boost::optional<scheduler_t> scheduler;
+    /// Static priority, meaningful for real-time schedulers only.
+    int priority;
+
+    thread_options_t() : priority(0) {}
+};
+
+/// Thread consuming records from the queues of attached asynchronous sinks.
+///
+/// Each sink in turn hands over a single batch, so a slow wrapped sink delays the others, but does
+/// not starve them. Producers of all attached sinks wake the thread up through the same underflow
+/// policy.
+class consumer_t {
+    const thread_options_t options;
+    std::unique_ptr<underflow_policy_t> underflow_policy;
+
+    std::atomic<bool> stopped;
+
+    /// Incremented on each attach and detach, so the thread knows when to refresh its snapshot.
+    std::atomic<std::uint64_t> version;
+    std::mutex mutex;
+    std::vector<asynchronous_t*> sinks;
+
+    std::thread thread;
+
+public:
+    /// Starts the consumer thread, waiting until it applies the given options.
+    ///
+    /// \throw std::invalid_argument if the thread name is too long or some processor is out of the
+    ///     supported range.
+    /// \throw std::system_error if the options can not be applied, for example because of lacking
+    ///     privileges, or are not supported by the platform.
+    consumer_t(thread_options_t options, std::unique_ptr<underflow_policy_t> underflow_policy);
+
+    consumer_t(const consumer_t& other) = delete;
+    auto operator=(const consumer_t& other) -> consumer_t& = delete;
+
+    /// Stops the thread, all sinks must have been detached by then.
+    ~consumer_t();
+
+    /// Starts consuming records of the given sink.
+    ///
+    /// The sink is detached by the consumer once it has been stopped and drained, after which it
+    /// is no longer accessed.
+    auto attach(asynchronous_t& sink) -> void;
+
+    /// Notifies the consumer about new records or requests.
+    auto wakeup() -> void;
+
+private:
+    auto run() -> void;
+    auto detach(asynchronous_t& sink) -> void;
+};
+
+/// Returns the consumer of the given group, starting it with the given options and a policy from
+/// the given factory if there is no running one yet. Options of consumers already running are not
+/// changed.
+///
+/// \throw std::invalid_argument, std::system_error if the consumer can not be started, see
+///     `consumer_t`.
+auto shared_consumer(const std::string& group,
+                     const thread_options_t& options,
+                     const std::function<auto() -> std::unique_ptr<underflow_policy_t>>& factory) ->
+    std::shared_ptr<consumer_t>;
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,136 @@
+#include "drops.hpp"
+
+#include "blackhole/extensions/writer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Returns the stripe index of the calling thread, assigned in a round-robin manner.
+auto stripe(std::size_t stripes) noexcept -> std::size_t {
+    static std::atomic<std::size_t> counter(0);
+    static thread_local const std::size_t index = counter.fetch_add(1, std::memory_order_relaxed);
+    return index % stripes;
+}
+
+}  // namespace
+
+constexpr std::size_t drops_t::severities;
+
+auto drops_t::total() const noexcept -> std::uint64_t {
+    std::uint64_t result = 0;
+    for (auto count : counts) {
+        result += count;
+    }
+
+    return result;
+}
+
+auto drops_t::at(severity_t severity) const noexcept -> std::uint64_t {
+    return counts[bucket(severity)];
+}
+
+auto drops_t::since(const drops_t& other) const noexcept -> drops_t {
+    drops_t result;
+    for (std::size_t i = 0; i < severities; ++i) {
+        result.counts[i] = counts[i] - other.counts[i];
+    }
+
+    return result;
+}
+
+auto drops_t::bucket(severity_t severity) noexcept -> std::size_t {
+    if (severity < 0) {
+        return 0;
+    }
+
+    if (static_cast<std::size_t>(severity) >= severities) {
+        return severities - 1;
+    }
+
+    return static_cast<std::size_t>(severity);
+}
+
+constexpr std::size_t drop_counter_t::stripes;
+
+drop_counter_t::drop_counter_t() :
+    dirty(false)
+{
+    for (auto& stripe : data) {
+        for (auto& count : stripe.counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+auto drop_counter_t::add(severity_t severity) noexcept -> void {
+    data[stripe(stripes)].counts[drops_t::bucket(severity)].fetch_add(1, std::memory_order_relaxed);
+
+    // Avoid bouncing the shared cache line while the flag is already set. Pairs with the fence in
+    // `reset`, so either the consumer sees this increment or we see the flag cleared.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!dirty.load(std::memory_order_relaxed)) {
+        dirty.store(true, std::memory_order_relaxed);
+    }
+}
+
+auto drop_counter_t::reset() noexcept -> bool {
+    if (!dirty.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    dirty.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    return true;
+}
+
+auto drop_counter_t::snapshot() const noexcept -> drops_t {
+    drops_t result;
+    for (const auto& stripe : data) {
+        for (std::size_t i = 0; i < drops_t::severities; ++i) {
+            result.counts[i] += stripe.counts[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    return result;
+}
+
+auto describe(const drops_t& drops, writer_t& writer) -> severity_t {
+    severity_t severity = 0;
+
+    writer.write("dropped {} records (", drops.total());
+
+    bool first = true;
+    for (std::size_t i = 0; i < drops_t::severities; ++i) {
+        if (drops.counts[i] == 0) {
+            continue;
+        }
+
+        if (!first) {
+            writer.write(", ");
+        }
+
+        // The last bucket also accounts all higher severities.
+        if (i + 1 == drops_t::severities) {
+            writer.write("{}+: {}", i, drops.counts[i]);
+        } else {
+            writer.write("{}: {}", i, drops.counts[i]);
+        }
+
+        first = false;
+        severity = static_cast<severity_t>(i);
+    }
+
+    writer.write(")");
+
+    return severity;
+}
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "blackhole/forward.hpp"
+#include "blackhole/severity.hpp"
+#include "blackhole/sink/asynchronous.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+
+/// Counts records dropped on queue overflow by severity.
+///
+/// Counters are split into cache line aligned stripes and each producer thread increments its own
+/// stripe, so threads dropping records simultaneously do not contend. Reading sums up all
+/// stripes, which is fine for an occasional reporting.
+class drop_counter_t {
+    static constexpr std::size_t stripes = 16;
+
+    struct stripe_t {
+        std::array<std::atomic<std::uint64_t>, drops_t::severities> counts;
+        char padding[64];
+    };
+
+    std::array<stripe_t, stripes> data;
+
+    /// Set on each drop, so the consumer can cheaply check whether there is anything new to report.
+    std::atomic<bool> dirty;
+
+public:
+    drop_counter_t();
+
+    /// Accounts a dropped record with the given severity.
+    auto add(severity_t severity) noexcept -> void;
+
+    /// Returns true if some records were dropped since the last call, resetting the flag.
+    auto reset() noexcept -> bool;
+
+    /// Returns the current counters.
+    auto snapshot() const noexcept -> drops_t;
+};
+
+/// Writes the summary of the given dropped records, like "dropped 42 records (2: 40, 3: 2)".
+///
+/// \returns the highest severity among the dropped records, so a synthetic record carrying the
+///     summary passes the same filters.
+auto describe(const drops_t& drops, writer_t& writer) -> severity_t;
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,203 @@
+#include "pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "../asynchronous.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Scrambles bits, so keys differing only in high bits, like aligned pointers, spread evenly over
+/// workers.
+auto mix(std::uint64_t value) noexcept -> std::size_t {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return static_cast<std::size_t>(value);
+}
+
+/// FNV-1a.
+auto fnv1a(const char* data, std::size_t size) noexcept -> std::uint64_t {
+    std::uint64_t result = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < size; ++i) {
+        result ^= static_cast<unsigned char>(data[i]);
+        result *= 0x100000001b3ULL;
+    }
+
+    return result;
+}
+
+class hash_visitor : public attribute::view_t::visitor_t {
+public:
+    std::uint64_t result;
+
+    hash_visitor() : result(0) {}
+
+    auto operator()(const attribute::view_t::null_type&) -> void override {
+        result = 0;
+    }
+
+    auto operator()(const attribute::view_t::bool_type& value) -> void override {
+        result = value ? 1 : 0;
+    }
+
+    auto operator()(const attribute::view_t::sint64_type& value) -> void override {
+        result = static_cast<std::uint64_t>(value);
+    }
+
+    auto operator()(const attribute::view_t::uint64_type& value) -> void override {
+        result = value;
+    }
+
+    auto operator()(const attribute::view_t::double_type& value) -> void override {
+        result = fnv1a(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    auto operator()(const attribute::view_t::string_type& value) -> void override {
+        result = fnv1a(value.data(), value.size());
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) -> void override {
+        writer_t writer;
+        value(writer);
+        result = fnv1a(writer.inner.data(), writer.inner.size());
+    }
+};
+
+/// Non-owning reference to the sink shared by all workers.
+class shared_sink_t : public sink_t {
+    sink_t& inner;
+
+public:
+    explicit shared_sink_t(sink_t& inner) : inner(inner) {}
+
+    auto emit(const record_t& record, const string_view& message) -> void override {
+        inner.emit(record, message);
+    }
+
+    auto emit_batch(const batch_t& batch) -> void override {
+        inner.emit_batch(batch);
+    }
+
+    auto flush() -> void override {
+        inner.flush();
+    }
+
+    auto flush(std::chrono::milliseconds timeout) -> bool override {
+        return inner.flush(timeout);
+    }
+};
+
+}  // namespace
+
+auto thread_key_t::hash(const record_t& record) const -> std::size_t {
+    // Thread handles are integers on some platforms and pointers on others.
+    const auto tid = record.tid();
+    return mix(fnv1a(reinterpret_cast<const char*>(&tid), sizeof(tid)));
+}
+
+attribute_key_t::attribute_key_t(std::string name) :
+    name(std::move(name))
+{}
+
+auto attribute_key_t::hash(const record_t& record) const -> std::size_t {
+    for (const auto& attributes : record.attributes()) {
+        for (const auto& attribute : attributes.get()) {
+            if (attribute.first == name) {
+                hash_visitor visitor;
+                attribute.second.apply(visitor);
+                return mix(visitor.result);
+            }
+        }
+    }
+
+    return 0;
+}
+
+pool_t::pool_t(std::unique_ptr<sink_t> wrapped,
+               std::unique_ptr<key_t> key,
+               std::size_t count,
+               const factory_type& factory) :
+    wrapped(std::move(wrapped)),
+    key(std::move(key))
+{
+    if (count == 0) {
+        throw std::invalid_argument("number of workers should be positive");
+    }
+
+    workers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::unique_ptr<sink_t> shared(new shared_sink_t(*this->wrapped));
+        workers.emplace_back(factory(std::move(shared), i));
+    }
+}
+
+pool_t::~pool_t() = default;
+
+auto pool_t::size() const noexcept -> std::size_t {
+    return workers.size();
+}
+
+auto pool_t::dropped() const -> drops_t {
+    drops_t result;
+    for (const auto& worker : workers) {
+        const auto dropped = worker->dropped();
+
+        for (std::size_t i = 0; i < drops_t::severities; ++i) {
+            result.counts[i] += dropped.counts[i];
+        }
+    }
+
+    return result;
+}
+
+auto pool_t::failed() const noexcept -> std::uint64_t {
+    std::uint64_t result = 0;
+    for (const auto& worker : workers) {
+        result += worker->failed();
+    }
+
+    return result;
+}
+
+auto pool_t::emit(const record_t& record, const string_view& message) -> void {
+    workers[key->hash(record) % workers.size()]->emit(record, message);
+}
+
+auto pool_t::flush(std::chrono::milliseconds timeout) -> bool {
+    const auto until = std::chrono::steady_clock::now() + timeout;
+
+    for (auto& worker : workers) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            until - std::chrono::steady_clock::now());
+
+        if (!worker->flush(std::max(remaining, std::chrono::milliseconds::zero()))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto pool_t::flush() -> void {
+    for (auto& worker : workers) {
+        worker->flush();
+    }
+}
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+#include "drops.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+class asynchronous_t;
+
+namespace asynchronous {
+
+/// Maps records to keys. Records with the same key are emitted by the same worker, preserving
+/// their order.
+class key_t {
+public:
+    virtual ~key_t() = default;
+
+    /// Returns the key hash of the given record.
+    ///
+    /// Called by producer threads, so must be thread-safe.
+    virtual auto hash(const record_t& record) const -> std::size_t = 0;
+};
+
+/// Keys records by their producer thread.
+class thread_key_t : public key_t {
+public:
+    auto hash(const record_t& record) const -> std::size_t override;
+};
+
+/// Keys records by the value of the attribute with the given name, for example the attribute that
+/// defines the destination file path. Records without the attribute share the same key.
+class attribute_key_t : public key_t {
+    std::string name;
+
+public:
+    explicit attribute_key_t(std::string name);
+
+    auto hash(const record_t& record) const -> std::size_t override;
+};
+
+/// Set of asynchronous sinks, each with its own queue and consumer thread, wrapping the same sink,
+/// which therefore must be thread-safe.
+///
+/// Records are routed to workers by their key, so records with the same key are emitted in order,
+/// while records with different keys may be emitted in parallel. This helps when the wrapped sink
+/// is slow, for example waits for network round trips.
+class pool_t : public handle_t {
+public:
+    /// Creates the worker with the given index emitting to the given sink.
+    typedef std::function<auto(std::unique_ptr<sink_t> wrapped, std::size_t index) ->
+        std::unique_ptr<asynchronous_t>> factory_type;
+
+private:
+    std::unique_ptr<sink_t> wrapped;
+    std::unique_ptr<key_t> key;
+    /// Stopped before the wrapped sink is destroyed.
+    std::vector<std::unique_ptr<asynchronous_t>> workers;
+
+public:
+    /// \throw std::invalid_argument if the number of workers is zero.
+    pool_t(std::unique_ptr<sink_t> wrapped,
+           std::unique_ptr<key_t> key,
+           std::size_t count,
+           const factory_type& factory);
+
+    ~pool_t();
+
+    /// Returns the number of workers.
+    auto size() const noexcept -> std::size_t;
+
+    /// Returns the number of records dropped by all workers so far.
+    auto dropped() const -> drops_t override;
+
+    /// Returns the number of records given up by all workers because the wrapped sink has thrown.
+    auto failed() const noexcept -> std::uint64_t override;
+
+    auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Flushes all workers, sharing the given timeout between them.
+    ///
+    /// \returns false on timeout.
+    auto flush(std::chrono::milliseconds timeout) -> bool override;
+
+    auto flush() -> void override;
+};
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,629 @@
+#include "queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "codec.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+auto exp2(std::size_t factor) -> std::size_t {
+    if (factor < 2 || factor > 20) {
+        throw std::invalid_argument("factor should fit in [2; 20] range");
+    }
+
+    return static_cast<std::size_t>(std::exp2(factor));
+}
+
+}  // namespace
+
+shared_queue_t::shared_queue_t(std::size_t capacity) :
+    queue(capacity),
+    tracked(false),
+    size(0),
+    epoch(0),
+    seen(0),
+    barrier(0)
+{}
+
+auto shared_queue_t::capacity() const -> std::size_t {
+    return queue.capacity();
+}
+
+auto shared_queue_t::empty() const -> bool {
+    return queue.empty();
+}
+
+auto shared_queue_t::occupancy() const -> std::size_t {
+    return size.load(std::memory_order_relaxed);
+}
+
+auto shared_queue_t::track() -> void {
+    tracked = true;
+}
+
+auto shared_queue_t::push(const record_t& record, const string_view& message) -> bool {
+    // Read before the slot is claimed, see `mark`.
+    const auto stamp = epoch.load(std::memory_order_acquire);
+
+    if (tracked) {
+        // Counted in advance, so the consumer never decrements the size below zero.
+        size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // An exception must not escape from the queue callback, otherwise the slot remains acquired
+    // forever. The slot is published as invalid instead.
+    std::exception_ptr error;
+    const auto enqueued = queue.enqueue_with([&](slot_t& slot) {
+        slot.sequence = stamp;
+
+        try {
+            slot.assign(record, message);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+
+    if (!enqueued && tracked) {
+        size.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return enqueued;
+}
+
+auto shared_queue_t::pop(slot_t& slot) -> bool {
+    const auto dequeued = queue.dequeue_with([&](slot_t& value) {
+        std::swap(value, slot);
+    });
+
+    if (!dequeued) {
+        return false;
+    }
+
+    if (tracked) {
+        size.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    seen = std::max(seen, slot.sequence);
+    return true;
+}
+
+auto shared_queue_t::mark() const -> mark_t {
+    return {epoch.fetch_add(1, std::memory_order_acq_rel)};
+}
+
+auto shared_queue_t::passed(const mark_t& mark) -> bool {
+    // The consumer pops slots in the order they have been claimed.
+    if (seen > mark.front()) {
+        return true;
+    }
+
+    // No record stamped past the mark may ever come, for example if the load has stopped, so an
+    // invalid slot is pushed instead, unless there is one in the queue already.
+    if (barrier > mark.front()) {
+        return false;
+    }
+
+    const auto stamp = epoch.load(std::memory_order_acquire);
+
+    if (tracked) {
+        size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const auto enqueued = queue.enqueue_with([&](slot_t& slot) {
+        slot.valid = false;
+        slot.sequence = stamp;
+    });
+
+    if (enqueued) {
+        barrier = stamp;
+    } else if (tracked) {
+        size.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return false;
+}
+
+/// Single-producer single-consumer ring.
+///
+/// Both indices grow monotonically and live on their own cache lines. The producer caches the
+/// consumer's index to avoid touching its cache line until the ring looks full.
+class sharded_queue_t::shard_t {
+    const std::size_t mask;
+    std::unique_ptr<slot_t[]> slots;
+
+    char before[64];
+
+    /// Written by the producer only.
+    std::atomic<std::size_t> tail;
+    std::size_t cached;
+
+    char between[64];
+
+    /// Written by the consumer only.
+    std::atomic<std::size_t> head;
+
+    char after[64];
+
+public:
+    /// Serializes producers if the ring is shared.
+    const bool shared;
+    std::mutex mutex;
+
+    /// Whether some thread is producing into this ring.
+    std::atomic<bool> attached;
+    /// Set when the queue is destroyed, so threads can forget the ring.
+    std::atomic<bool> closed;
+
+    shard_t(std::size_t capacity, bool shared) :
+        mask(capacity - 1),
+        slots(new slot_t[capacity]),
+        tail(0),
+        cached(0),
+        head(0),
+        shared(shared),
+        attached(true),
+        closed(false)
+    {}
+
+    auto empty() const noexcept -> bool {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    auto size() const noexcept -> std::size_t {
+        return tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+    }
+
+    auto push(const record_t& record, const string_view& message) -> bool {
+        const auto tail = this->tail.load(std::memory_order_relaxed);
+
+        if (tail - cached > mask) {
+            cached = head.load(std::memory_order_acquire);
+
+            if (tail - cached > mask) {
+                return false;
+            }
+        }
+
+        // The slot is published only after it has been successfully filled, so it just remains
+        // free if an exception is thrown.
+        slots[tail & mask].assign(record, message);
+        this->tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /// Returns the number of records ever pushed.
+    auto pushed() const noexcept -> std::size_t {
+        return tail.load(std::memory_order_acquire);
+    }
+
+    /// Returns the number of records ever popped.
+    ///
+    /// Must be called from the consumer thread only.
+    auto popped() const noexcept -> std::size_t {
+        return head.load(std::memory_order_relaxed);
+    }
+
+    /// Returns the oldest record or nullptr if the ring is empty.
+    auto front() const noexcept -> const slot_t* {
+        const auto head = this->head.load(std::memory_order_relaxed);
+
+        if (head == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        return &slots[head & mask];
+    }
+
+    /// Swaps out the oldest record, which must exist.
+    auto pop(slot_t& slot) noexcept -> void {
+        const auto head = this->head.load(std::memory_order_relaxed);
+        std::swap(slots[head & mask], slot);
+        this->head.store(head + 1, std::memory_order_release);
+    }
+};
+
+namespace {
+
+/// Binds a ring to the current thread for the lifetime of either the thread or the queue.
+struct registration_t {
+    std::uint64_t queue;
+    std::shared_ptr<sharded_queue_t::shard_t> shard;
+
+    registration_t(std::uint64_t queue, std::shared_ptr<sharded_queue_t::shard_t> shard) :
+        queue(queue),
+        shard(std::move(shard))
+    {}
+
+    registration_t(registration_t&& other) = default;
+    auto operator=(registration_t&& other) -> registration_t& = default;
+
+    ~registration_t() {
+        if (shard && !shard->shared) {
+            // Hands all records pushed by this thread over to any thread, that adopts the ring.
+            shard->attached.store(false, std::memory_order_release);
+        }
+    }
+};
+
+auto registrations() -> std::vector<registration_t>& {
+    static thread_local std::vector<registration_t> value;
+    return value;
+}
+
+auto generate() noexcept -> std::uint64_t {
+    static std::atomic<std::uint64_t> counter(0);
+    return ++counter;
+}
+
+}  // namespace
+
+constexpr std::size_t sharded_queue_t::limit;
+
+sharded_queue_t::sharded_queue_t(std::size_t capacity, merge_t merge) :
+    id(generate()),
+    capacity_(capacity),
+    merge(merge),
+    size(0),
+    cursor(0)
+{
+    for (auto& shard : shards) {
+        shard.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+sharded_queue_t::~sharded_queue_t() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& shard : owned) {
+        shard->closed.store(true, std::memory_order_release);
+    }
+}
+
+auto sharded_queue_t::capacity() const -> std::size_t {
+    return capacity_;
+}
+
+auto sharded_queue_t::empty() const -> bool {
+    const auto size = this->size.load(std::memory_order_acquire);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        if (!shards[i].load(std::memory_order_acquire)->empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto sharded_queue_t::occupancy() const -> std::size_t {
+    if (const auto shard = find()) {
+        return shard->size();
+    }
+
+    return 0;
+}
+
+auto sharded_queue_t::push(const record_t& record, const string_view& message) -> bool {
+    auto& shard = local();
+
+    if (shard.shared) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.push(record, message);
+    }
+
+    return shard.push(record, message);
+}
+
+auto sharded_queue_t::pop(slot_t& slot) -> bool {
+    const auto size = this->size.load(std::memory_order_acquire);
+
+    if (size == 0) {
+        return false;
+    }
+
+    shard_t* chosen = nullptr;
+
+    switch (merge) {
+    case merge_t::timestamp: {
+        record_t::time_point timestamp;
+
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto shard = shards[i].load(std::memory_order_acquire);
+
+            if (const auto front = shard->front()) {
+                const auto candidate = front->record.into_view().timestamp();
+
+                if (chosen == nullptr || candidate < timestamp) {
+                    chosen = shard;
+                    timestamp = candidate;
+                }
+            }
+        }
+        break;
+    }
+    case merge_t::relaxed:
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto shard = shards[(cursor + i) % size].load(std::memory_order_acquire);
+
+            if (shard->front()) {
+                chosen = shard;
+                cursor = (cursor + i + 1) % size;
+                break;
+            }
+        }
+        break;
+    }
+
+    if (chosen == nullptr) {
+        return false;
+    }
+
+    chosen->pop(slot);
+    return true;
+}
+
+auto sharded_queue_t::mark() const -> mark_t {
+    const auto size = this->size.load(std::memory_order_acquire);
+
+    mark_t result;
+    result.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        result.push_back(shards[i].load(std::memory_order_acquire)->pushed());
+    }
+
+    return result;
+}
+
+auto sharded_queue_t::passed(const mark_t& mark) -> bool {
+    // Rings registered after the mark was taken have no records behind it.
+    for (std::size_t i = 0; i < mark.size(); ++i) {
+        if (shards[i].load(std::memory_order_relaxed)->popped() < mark[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto sharded_queue_t::local() -> shard_t& {
+    if (const auto shard = find()) {
+        return *shard;
+    }
+
+    return attach();
+}
+
+auto sharded_queue_t::find() const -> shard_t* {
+    for (const auto& registration : registrations()) {
+        if (registration.queue == id) {
+            return registration.shard.get();
+        }
+    }
+
+    return nullptr;
+}
+
+auto sharded_queue_t::attach() -> shard_t& {
+    auto& registrations = asynchronous::registrations();
+
+    // Forget rings of already destroyed queues.
+    registrations.erase(std::remove_if(std::begin(registrations), std::end(registrations),
+        [](const registration_t& registration) -> bool {
+            return registration.shard->closed.load(std::memory_order_acquire);
+        }), std::end(registrations));
+
+    registrations.reserve(registrations.size() + 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& shard : owned) {
+        bool attached = false;
+        if (!shard->shared && shard->attached.compare_exchange_strong(attached, true,
+            std::memory_order_acquire))
+        {
+            registrations.emplace_back(id, shard);
+            return *shard;
+        }
+    }
+
+    const auto size = this->size.load(std::memory_order_relaxed);
+
+    if (size == limit) {
+        // The last ring is the shared one.
+        registrations.emplace_back(id, owned.back());
+        return *owned.back();
+    }
+
+    owned.reserve(owned.size() + 1);
+    owned.push_back(std::make_shared<shard_t>(capacity_, size + 1 == limit));
+    registrations.emplace_back(id, owned.back());
+
+    shards[size].store(owned.back().get(), std::memory_order_release);
+    this->size.store(size + 1, std::memory_order_release);
+
+    return *owned.back();
+}
+
+namespace {
+
+/// Marks entries that only pad the rest of the ring.
+constexpr std::uint64_t padding_flag = 1ULL << 63;
+constexpr std::uint64_t size_mask = 0xffffffffULL;
+
+/// Scratch buffers larger than this are released after use.
+constexpr std::size_t shrink_threshold = 64 * 1024;
+
+auto align(std::size_t size) noexcept -> std::size_t {
+    return (size + sizeof(std::uint64_t) - 1) & ~(sizeof(std::uint64_t) - 1);
+}
+
+/// Per-thread buffer records are serialized into before being copied into the ring.
+auto scratch() -> std::string& {
+    static thread_local std::string buffer;
+    return buffer;
+}
+
+}  // namespace
+
+byte_queue_t::byte_queue_t(std::size_t capacity) :
+    capacity_(align(capacity)),
+    head(0),
+    tail(0)
+{
+    if (capacity < 1024 || capacity >= (1ULL << 32)) {
+        throw std::invalid_argument("byte queue capacity should fit in [1KiB; 4GiB) range");
+    }
+
+    // Zeroed, so all headers are unpublished.
+    data.reset(new std::uint64_t[capacity_ / sizeof(std::uint64_t)]());
+}
+
+auto byte_queue_t::capacity() const -> std::size_t {
+    return capacity_;
+}
+
+auto byte_queue_t::empty() const -> bool {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+auto byte_queue_t::occupancy() const -> std::size_t {
+    const auto tail = this->tail.load(std::memory_order_relaxed);
+    return static_cast<std::size_t>(head.load(std::memory_order_relaxed) - tail);
+}
+
+auto byte_queue_t::push(const record_t& record, const string_view& message) -> bool {
+    auto& buffer = scratch();
+    buffer.clear();
+    encode(record, message, buffer);
+
+    const auto size = align(sizeof(std::uint64_t) + buffer.size());
+
+    if (size > capacity_ / 2) {
+        throw std::length_error("record does not fit in the queue");
+    }
+
+    // Entries never wrap, so an entry that does not fit before the end of the ring is preceded by
+    // a padding one.
+    auto head = this->head.load(std::memory_order_relaxed);
+    std::size_t padding;
+
+    do {
+        const auto offset = static_cast<std::size_t>(head % capacity_);
+        padding = capacity_ - offset < size ? capacity_ - offset : 0;
+
+        if (head + padding + size - tail.load(std::memory_order_acquire) > capacity_) {
+            return false;
+        }
+    } while (!this->head.compare_exchange_weak(head, head + padding + size,
+        std::memory_order_relaxed));
+
+    if (padding > 0) {
+        header(head).store(padding | padding_flag, std::memory_order_release);
+    }
+
+    const auto position = head + padding;
+    std::memcpy(at(position) + sizeof(std::uint64_t), buffer.data(), buffer.size());
+    header(position).store(size, std::memory_order_release);
+
+    if (buffer.capacity() > shrink_threshold) {
+        std::string().swap(buffer);
+    }
+
+    return true;
+}
+
+auto byte_queue_t::pop(slot_t& slot) -> bool {
+    auto tail = this->tail.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto value = header(tail).load(std::memory_order_acquire);
+
+        if (value == 0) {
+            return false;
+        }
+
+        const auto size = static_cast<std::size_t>(value & size_mask);
+
+        if (value & padding_flag) {
+            release(tail, size);
+            tail += size;
+            continue;
+        }
+
+        try {
+            const auto offset = sizeof(std::uint64_t);
+            decode(at(tail) + offset, size - offset, attributes, slot);
+        } catch (const std::bad_alloc&) {
+            // The slot remains invalid and the record is lost.
+        }
+
+        release(tail, size);
+        return true;
+    }
+}
+
+auto byte_queue_t::mark() const -> mark_t {
+    return {head.load(std::memory_order_relaxed)};
+}
+
+auto byte_queue_t::passed(const mark_t& mark) -> bool {
+    return tail.load(std::memory_order_relaxed) >= mark.front();
+}
+
+auto byte_queue_t::header(std::uint64_t position) const noexcept -> std::atomic<std::uint64_t>& {
+    static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t),
+        "atomic header must have the same layout as the raw one");
+
+    return *reinterpret_cast<std::atomic<std::uint64_t>*>(at(position));
+}
+
+auto byte_queue_t::at(std::uint64_t position) const noexcept -> char* {
+    return reinterpret_cast<char*>(data.get()) + position % capacity_;
+}
+
+auto byte_queue_t::release(std::uint64_t position, std::size_t size) noexcept -> void {
+    std::memset(at(position), 0, size);
+    tail.store(position + size, std::memory_order_release);
+}
+
+auto queue_factory_t::create(const std::string& name, std::size_t factor) const ->
+    std::unique_ptr<queue_t>
+{
+    if (name == "shared") {
+        return std::unique_ptr<queue_t>(new shared_queue_t(exp2(factor)));
+    } else if (name == "sharded") {
+        return sharded(factor, merge_t::timestamp);
+    }
+
+    throw std::invalid_argument("no queue with name \"" + name + "\" found");
+}
+
+auto queue_factory_t::sharded(std::size_t factor, merge_t merge) const ->
+    std::unique_ptr<queue_t>
+{
+    return std::unique_ptr<queue_t>(new sharded_queue_t(exp2(factor), merge));
+}
+
+auto queue_factory_t::bytes(std::size_t capacity) const -> std::unique_ptr<queue_t> {
+    return std::unique_ptr<queue_t>(new byte_queue_t(capacity));
+}
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
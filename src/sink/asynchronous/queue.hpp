@@ -0,0 +1,275 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cds/container/vyukov_mpmc_cycle_queue.h>
+
+#include "blackhole/attributes.hpp"
+#include "blackhole/sink/asynchronous.hpp"
+
+#include "../../recordbuf.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+
+/// Queue slot.
+///
+/// Slots are never reallocated, producers copy records into them in place and the consumer swaps
+/// them out, so the memory allocated for a slot is retained for subsequent records.
+struct slot_t {
+    recordbuf_t record;
+    std::string message;
+    /// False if the producer failed to copy the record, which must be skipped then.
+    bool valid;
+    /// Stamp assigned by queues that need it for marks, see `shared_queue_t`.
+    std::uint64_t sequence;
+
+    slot_t() : valid(false), sequence(0) {}
+
+    /// Copies the given record into this slot, reusing its storage.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure, leaving the slot invalid.
+    auto assign(const record_t& record, const string_view& message) -> void {
+        valid = false;
+        this->record.assign(record);
+        this->message.assign(message.data(), message.size());
+        valid = true;
+    }
+};
+
+/// Positions of producers at some moment, opaque to everyone except the queue.
+typedef std::vector<std::uint64_t> mark_t;
+
+/// Bounded record queue with multiple producers and a single consumer.
+class queue_t {
+public:
+    virtual ~queue_t() = default;
+
+    /// Returns the queue capacity in number of records, or in bytes for byte queues.
+    virtual auto capacity() const -> std::size_t = 0;
+
+    /// Checks whether the queue is empty.
+    ///
+    /// May be called from any thread.
+    virtual auto empty() const -> bool = 0;
+
+    /// Returns the approximate number of records in the queue the calling thread pushes into, in
+    /// the same units as the capacity. Queues, that can not derive it for free, report zero until
+    /// `track` has been called.
+    ///
+    /// May be called from any thread, but is meaningful for producers only.
+    virtual auto occupancy() const -> std::size_t = 0;
+
+    /// Makes the queue count its records, so `occupancy` is accurate. This costs producers extra
+    /// contended writes in some queues, therefore is done only on demand of the overflow policy.
+    ///
+    /// Must be called before the first push. The default implementation does nothing.
+    virtual auto track() -> void {}
+
+    /// Copies the given record into the queue.
+    ///
+    /// \returns false if the queue is full.
+    /// \throw std::bad_alloc on memory allocation failure.
+    virtual auto push(const record_t& record, const string_view& message) -> bool = 0;
+
+    /// Moves the next record out of the queue into the given slot, swapping their contents.
+    ///
+    /// Must be called from the consumer thread only.
+    ///
+    /// \returns false if the queue is empty.
+    virtual auto pop(slot_t& slot) -> bool = 0;
+
+    /// Returns the current position of producers, all records pushed before this call are behind
+    /// it.
+    ///
+    /// May be called from any thread.
+    virtual auto mark() const -> mark_t = 0;
+
+    /// Checks whether all records behind the given mark have been popped, regardless of records
+    /// pushed after it.
+    ///
+    /// If this can not be told from the records popped so far, the queue may push an invalid slot
+    /// itself, which pops as usual and lets the mark pass.
+    ///
+    /// Must be called from the consumer thread only.
+    virtual auto passed(const mark_t& mark) -> bool = 0;
+};
+
+/// A single ring shared by all producers, which claim its slots with CAS.
+class shared_queue_t : public queue_t {
+    typedef cds::container::VyukovMPSCCycleQueue<slot_t> queue_type;
+
+    queue_type queue;
+
+    /// Whether records are counted, see `track`.
+    bool tracked;
+    /// Number of enqueued records, the queue itself does not track it.
+    std::atomic<std::size_t> size;
+
+    char padding[64];
+
+    /// Incremented by each mark, so it is rarely written. Producers stamp slots with its value
+    /// read before claiming them, therefore a slot stamped past some mark has been claimed after
+    /// all records pushed before that mark.
+    mutable std::atomic<std::uint64_t> epoch;
+
+    /// The highest stamp popped so far, consumer only.
+    std::uint64_t seen;
+    /// Stamp of the invalid slot pushed by the consumer to pass marks, see `passed`.
+    std::uint64_t barrier;
+
+public:
+    /// \param capacity must be a power of two.
+    explicit shared_queue_t(std::size_t capacity);
+
+    auto capacity() const -> std::size_t override;
+    auto empty() const -> bool override;
+    auto occupancy() const -> std::size_t override;
+    auto track() -> void override;
+    auto push(const record_t& record, const string_view& message) -> bool override;
+    auto pop(slot_t& slot) -> bool override;
+    auto mark() const -> mark_t override;
+    auto passed(const mark_t& mark) -> bool override;
+};
+
+/// Set of single-producer rings, one for each producer thread.
+///
+/// Threads register their rings lazily on the first push, so producers never write to the memory
+/// shared with other producers. Rings of exited threads are adopted by new ones. If the number of
+/// rings reaches its limit, remaining threads share the last one, serializing on its mutex.
+///
+/// The consumer merges the rings either by record timestamps, which approximates the arrival
+/// order, or in a round-robin manner preserving only the order of records from the same thread.
+class sharded_queue_t : public queue_t {
+public:
+    /// Maximum number of rings.
+    static constexpr std::size_t limit = 256;
+
+    class shard_t;
+
+private:
+    const std::uint64_t id;
+    const std::size_t capacity_;
+    const merge_t merge;
+
+    /// Published rings, readable without locking.
+    std::array<std::atomic<shard_t*>, limit> shards;
+    std::atomic<std::size_t> size;
+
+    /// Consumer's round-robin position.
+    std::size_t cursor;
+
+    /// Protects registration.
+    std::mutex mutex;
+    std::vector<std::shared_ptr<shard_t>> owned;
+
+public:
+    /// \param capacity of each ring, must be a power of two.
+    sharded_queue_t(std::size_t capacity, merge_t merge);
+    ~sharded_queue_t();
+
+    /// Returns the capacity of each ring.
+    auto capacity() const -> std::size_t override;
+    auto empty() const -> bool override;
+
+    /// Returns the number of records in the ring of the calling thread.
+    auto occupancy() const -> std::size_t override;
+    auto push(const record_t& record, const string_view& message) -> bool override;
+    auto pop(slot_t& slot) -> bool override;
+
+    /// Returns the positions of all rings registered by now.
+    auto mark() const -> mark_t override;
+    auto passed(const mark_t& mark) -> bool override;
+
+private:
+    /// Returns the ring of the current thread, registering it if required.
+    auto local() -> shard_t&;
+    /// Returns the ring of the current thread or nullptr if it has not been registered yet.
+    auto find() const -> shard_t*;
+    auto attach() -> shard_t&;
+};
+
+/// A contiguous byte ring shared by all producers, which keeps records serialized as
+/// variable-length entries.
+///
+/// The capacity is defined in bytes, so the memory footprint does not depend on the number of
+/// records, while small records take little space and bursts of large ones fit as well. Entries are
+/// 8-byte aligned and start with a header word, which the producer publishes after filling the
+/// entry. An entry never wraps, the producer pads the rest of the ring instead. The consumer reads
+/// entries sequentially and zeroes them before releasing, so producers always see zero headers.
+class byte_queue_t : public queue_t {
+    const std::size_t capacity_;
+    std::unique_ptr<std::uint64_t[]> data;
+
+    char before[64];
+
+    /// Reservation position, advanced by producers.
+    std::atomic<std::uint64_t> head;
+
+    char between[64];
+
+    /// Release position, advanced by the consumer.
+    std::atomic<std::uint64_t> tail;
+
+    char after[64];
+
+    /// Consumer's storage for attributes of the entry being decoded.
+    attribute_list attributes;
+
+public:
+    /// \param capacity in bytes, rounded up to 8 bytes.
+    ///
+    /// \throw std::invalid_argument if the capacity does not fit in [1KiB; 4GiB) range.
+    explicit byte_queue_t(std::size_t capacity);
+
+    /// Returns the queue capacity in bytes.
+    auto capacity() const -> std::size_t override;
+    auto empty() const -> bool override;
+
+    /// Returns the number of bytes taken by records in the queue.
+    auto occupancy() const -> std::size_t override;
+
+    /// \throw std::length_error if the serialized record exceeds half of the capacity.
+    auto push(const record_t& record, const string_view& message) -> bool override;
+    auto pop(slot_t& slot) -> bool override;
+
+    /// Returns the reservation position, so the mark includes records being written.
+    auto mark() const -> mark_t override;
+    auto passed(const mark_t& mark) -> bool override;
+
+private:
+    auto header(std::uint64_t position) const noexcept -> std::atomic<std::uint64_t>&;
+    auto at(std::uint64_t position) const noexcept -> char*;
+
+    /// Zeroes the entry at the given position and hands its space over to producers.
+    auto release(std::uint64_t position, std::size_t size) noexcept -> void;
+};
+
+class queue_factory_t {
+public:
+    /// Creates a queue by its type name, "shared" or "sharded", with exp2(factor) capacity.
+    ///
+    /// \throw std::invalid_argument if the factor does not fit in [2; 20] range or the name is
+    ///     unknown.
+    auto create(const std::string& name, std::size_t factor) const -> std::unique_ptr<queue_t>;
+
+    /// Creates a sharded queue with exp2(factor) capacity of each ring.
+    auto sharded(std::size_t factor, merge_t merge) const -> std::unique_ptr<queue_t>;
+
+    /// Creates a byte ring queue with the given capacity in bytes.
+    auto bytes(std::size_t capacity) const -> std::unique_ptr<queue_t>;
+};
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
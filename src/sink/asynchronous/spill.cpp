@@ -0,0 +1,252 @@
+#include "spill.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "codec.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+constexpr std::uint64_t magic = 0x31004c4c49505342ULL;
+
+/// Format of the header and entries, files of other versions are refused.
+constexpr std::uint64_t version = 1;
+
+/// The ring starts at the page boundary.
+constexpr std::size_t offset = 4096;
+
+/// Marks entries that only pad the rest of the ring.
+constexpr std::uint64_t padding_flag = 1ULL << 63;
+constexpr std::uint64_t size_mask = 0xffffffffULL;
+
+auto align(std::size_t size) noexcept -> std::size_t {
+    return (size + sizeof(std::uint64_t) - 1) & ~(sizeof(std::uint64_t) - 1);
+}
+
+auto fail(const std::string& message) -> void {
+    throw std::system_error(errno, std::system_category(), message);
+}
+
+}  // namespace
+
+struct spill_t::header_t {
+    std::uint64_t magic;
+    std::uint64_t version;
+    std::uint64_t capacity;
+    /// Write position, only grows.
+    std::uint64_t head;
+    /// Read position, only grows.
+    std::uint64_t tail;
+};
+
+spill_t::spill_t(const std::string& path, std::size_t size) :
+    fd(-1),
+    data(nullptr),
+    size(0)
+{
+    if (size < 64 * 1024 || size >= (1ULL << 32)) {
+        throw std::invalid_argument("spill file size should fit in [64KiB; 4GiB) range");
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        fail("failed to open spill file '" + path + "'");
+    }
+
+    try {
+        if (::flock(fd, LOCK_EX | LOCK_NB) == -1) {
+            fail("failed to lock spill file '" + path + "'");
+        }
+
+        struct stat stat;
+        if (::fstat(fd, &stat) == -1) {
+            fail("failed to stat spill file '" + path + "'");
+        }
+
+        const header_t blank{};
+
+        header_t existing{};
+        if (stat.st_size > 0) {
+            const auto nread = ::pread(fd, &existing, sizeof(existing), 0);
+            if (nread == -1) {
+                fail("failed to read spill file '" + path + "'");
+            }
+
+            // Files resized before writing their header, which older versions did, are left zeroed
+            // by a crash in between. Such files are treated as uninitialized.
+            const auto uninitialized = std::memcmp(&existing, &blank, sizeof(existing)) == 0;
+
+            // Never overwrite some unrelated file.
+            if (!uninitialized && (nread != sizeof(existing) || existing.magic != magic)) {
+                throw std::invalid_argument("file '" + path + "' is not a spill file");
+            }
+
+            // Nor records some other version may still need.
+            if (!uninitialized && existing.version != version) {
+                throw std::invalid_argument("spill file '" + path + "' has unsupported version " +
+                    std::to_string(existing.version));
+            }
+        }
+
+        // A damaged spill file is reset.
+        const auto valid = existing.magic == magic &&
+            existing.capacity % sizeof(std::uint64_t) == 0 &&
+            static_cast<std::uint64_t>(stat.st_size) == offset + existing.capacity &&
+            existing.tail <= existing.head &&
+            existing.head - existing.tail <= existing.capacity;
+
+        this->size = valid ? stat.st_size : offset + align(size);
+
+        if (!valid) {
+            // The header is made durable before the file is extended, so a crash at any point
+            // leaves either an empty file or a spill file of the wrong size, which is reset again.
+            const header_t initial{magic, version, this->size - offset, 0, 0};
+
+            if (::ftruncate(fd, 0) == -1) {
+                fail("failed to truncate spill file '" + path + "'");
+            }
+
+            const auto nwritten = ::pwrite(fd, &initial, sizeof(initial), 0);
+            if (nwritten != static_cast<ssize_t>(sizeof(initial))) {
+                fail("failed to write spill file '" + path + "' header");
+            }
+
+            if (::fsync(fd) == -1) {
+                fail("failed to sync spill file '" + path + "'");
+            }
+
+            // Extending zeroes the ring.
+            if (::ftruncate(fd, static_cast<off_t>(this->size)) == -1) {
+                fail("failed to resize spill file '" + path + "'");
+            }
+        }
+
+        auto mapped = ::mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            fail("failed to map spill file '" + path + "'");
+        }
+
+        data = static_cast<char*>(mapped);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+spill_t::~spill_t() {
+    ::munmap(data, size);
+    ::close(fd);
+}
+
+auto spill_t::capacity() const noexcept -> std::size_t {
+    return size - offset;
+}
+
+auto spill_t::empty() const noexcept -> bool {
+    return header().head == header().tail;
+}
+
+auto spill_t::occupancy() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(header().head - header().tail);
+}
+
+auto spill_t::push(const record_t& record, const string_view& message) -> bool {
+    buffer.clear();
+    encode(record, message, buffer);
+
+    const auto size = align(sizeof(std::uint64_t) + buffer.size());
+    const auto capacity = this->capacity();
+
+    auto& header = this->header();
+    const auto offset = static_cast<std::size_t>(header.head % capacity);
+    const auto padding = capacity - offset < size ? capacity - offset : 0;
+
+    if (header.head + padding + size - header.tail > capacity) {
+        return false;
+    }
+
+    if (padding > 0) {
+        const auto value = padding | padding_flag;
+        std::memcpy(at(header.head), &value, sizeof(value));
+    }
+
+    const auto position = header.head + padding;
+    const std::uint64_t value = size;
+    std::memcpy(at(position), &value, sizeof(value));
+    std::memcpy(at(position) + sizeof(value), buffer.data(), buffer.size());
+
+    // Published last, so a partially written entry is never read back.
+    header.head = position + size;
+
+    return true;
+}
+
+auto spill_t::pop(slot_t& slot) -> bool {
+    auto& header = this->header();
+
+    while (header.tail != header.head) {
+        std::uint64_t value;
+        std::memcpy(&value, at(header.tail), sizeof(value));
+
+        const auto size = static_cast<std::size_t>(value & size_mask);
+
+        const auto offset = static_cast<std::size_t>(header.tail % capacity());
+
+        if (size < sizeof(value) || size % sizeof(value) != 0 ||
+            size > header.head - header.tail || offset + size > capacity())
+        {
+            // The file has been corrupted, there is no way to find the next entry.
+            header.tail = header.head;
+            return false;
+        }
+
+        if (value & padding_flag) {
+            header.tail += size;
+            continue;
+        }
+
+        const auto position = header.tail;
+        header.tail += size;
+
+        // A damaged entry is skipped, its size is still trusted to find the next one.
+        if (decode(at(position) + sizeof(value), size - sizeof(value), attributes, slot)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto spill_t::written() const noexcept -> std::uint64_t {
+    return header().head;
+}
+
+auto spill_t::read() const noexcept -> std::uint64_t {
+    return header().tail;
+}
+
+auto spill_t::header() const noexcept -> header_t& {
+    return *reinterpret_cast<header_t*>(data);
+}
+
+auto spill_t::at(std::uint64_t position) const noexcept -> char* {
+    return data + offset + position % capacity();
+}
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
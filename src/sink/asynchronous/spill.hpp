@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "blackhole/attributes.hpp"
+
+#include "queue.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+
+/// Bounded ring of serialized records kept in a memory-mapped file.
+///
+/// The file starts with a header, which keeps the ring positions, followed by the ring itself.
+/// Entries are 8-byte aligned and start with a size word, an entry never wraps, the rest of the
+/// ring is padded instead. Positions are updated only after an entry has been completely written
+/// or read, so records survive a process restart or crash and are read back by the next owner of
+/// the file. Records that have been read but not yet emitted when the process dies are lost.
+///
+/// The file contents are not trusted: entries that can not be decoded are skipped, and if an entry
+/// size is damaged, the rest of the ring is discarded.
+///
+/// The file is exclusively locked while open.
+///
+/// Not thread-safe.
+class spill_t {
+    struct header_t;
+
+    int fd;
+    char* data;
+    std::size_t size;
+
+    /// Serialization buffer, reused between records.
+    std::string buffer;
+    /// Storage for attributes of the entry being decoded.
+    attribute_list attributes;
+
+public:
+    /// Opens the spill file at the given path, creating it with the given size in bytes if it does
+    /// not exist. An existing file keeps its size and records.
+    ///
+    /// \throw std::invalid_argument if the size does not fit in [64KiB; 4GiB) range or the existing
+    ///     file is not a spill file of the supported format version.
+    /// \throw std::system_error on I/O failure or if the file is locked by some other owner.
+    spill_t(const std::string& path, std::size_t size);
+
+    spill_t(const spill_t& other) = delete;
+    auto operator=(const spill_t& other) -> spill_t& = delete;
+
+    ~spill_t();
+
+    /// Returns the ring capacity in bytes.
+    auto capacity() const noexcept -> std::size_t;
+
+    auto empty() const noexcept -> bool;
+
+    /// Returns the number of bytes taken by records.
+    auto occupancy() const noexcept -> std::size_t;
+
+    /// Returns the position after the last appended record, it never decreases.
+    auto written() const noexcept -> std::uint64_t;
+
+    /// Returns the position after the last popped record, it never decreases.
+    auto read() const noexcept -> std::uint64_t;
+
+    /// Appends the given record.
+    ///
+    /// \returns false if there is no room for it.
+    auto push(const record_t& record, const string_view& message) -> bool;
+
+    /// Moves the oldest record into the given slot.
+    ///
+    /// \returns false if the file is empty.
+    /// \throw std::bad_alloc on memory allocation failure, the record is lost then.
+    auto pop(slot_t& slot) -> bool;
+
+private:
+    auto header() const noexcept -> header_t&;
+    auto at(std::uint64_t position) const noexcept -> char*;
+};
+
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
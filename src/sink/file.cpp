@@ -156,6 +156,42 @@ auto file_t::emit(const record_t& record, const string_view& formatted) -> void
     backend(filename).write(formatted);
 }
 
+auto file_t::emit_batch(const batch_t& batch) -> void {
+    std::string filename;
+    file::backend_t* backend = nullptr;
+    bool flush = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& entry : batch) {
+        auto next = this->filename(entry.record);
+
+        if (backend == nullptr || next != filename) {
+            if (flush) {
+                backend->flush();
+            }
+
+            filename = std::move(next);
+            backend = &this->backend(filename);
+            flush = false;
+        }
+
+        flush = backend->append(entry.message) || flush;
+    }
+
+    if (flush) {
+        backend->flush();
+    }
+}
+
+auto file_t::flush() -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& backend : data.backends) {
+        backend.second.flush();
+    }
+}
+
 }  // namespace sink
 
 class builder<sink::file_t>::inner_t {
@@ -39,11 +39,22 @@ public:
     }
 
     auto write(const string_view& message) -> void {
+        if (append(message)) {
+            flush();
+        }
+    }
+
+    /// Writes the message without flushing the stream.
+    ///
+    /// \returns true if the flusher demands the stream to be flushed.
+    auto append(const string_view& message) -> bool {
         stream->write(message.data(), static_cast<std::streamsize>(message.size()));
         stream->put('\n');
-        if (flusher->update(message.size() + 1) == flusher_t::flush) {
-            stream->flush();
-        }
+        return flusher->update(message.size() + 1) == flusher_t::flush;
+    }
+
+    auto flush() -> void {
+        stream->flush();
     }
 };
 
@@ -86,6 +97,16 @@ public:
     ///
     /// Depending on the filename pattern it is possible to write into multiple destinations.
     auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+    /// Outputs all records from the given batch under a single lock acquisition.
+    ///
+    /// Consecutive records destined to the same file are written to its stream buffer with a
+    /// single flush at the end, if the flusher demanded any, so the buffer coalesces them into a
+    /// few write system calls. Rotation is checked once for each such group.
+    auto emit_batch(const batch_t& batch) -> void override;
+
+    /// Flushes streams of all opened files.
+    auto flush() -> void override;
 };
 
 }  // namespace sink
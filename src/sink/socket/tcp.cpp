@@ -133,6 +133,26 @@ auto tcp_t::emit(const record_t&, const string_view& message) -> void {
     }
 }
 
+auto tcp_t::emit_batch(const batch_t& batch) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!socket) {
+        socket = reconnect(io_service, host(), port());
+    }
+
+    buffers.clear();
+    for (const auto& entry : batch) {
+        buffers.emplace_back(entry.message.data(), entry.message.size());
+    }
+
+    try {
+        boost::asio::write(*socket, buffers);
+    } catch (const boost::system::system_error&) {
+        socket.reset();
+        std::rethrow_exception(std::current_exception());
+    }
+}
+
 }  // namespace socket
 }  // namespace sink
 
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <mutex>
+#include <vector>
 
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
 
@@ -19,6 +21,9 @@ class tcp_t : public sink_t {
     boost::asio::io_service io_service;
     std::unique_ptr<boost::asio::ip::tcp::socket> socket;
 
+    /// Scatter-gather buffers for batched writes, reused between batches.
+    std::vector<boost::asio::const_buffer> buffers;
+
     mutable std::mutex mutex;
 
 public:
@@ -28,6 +33,9 @@ public:
     auto port() const noexcept -> std::uint16_t;
 
     auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Sends all messages from the given batch using vectored writes.
+    auto emit_batch(const batch_t& batch) -> void override;
 };
 
 }  // namespace socket
@@ -1,3 +1,13 @@
+#if defined(__linux__)
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <system_error>
+
 #include <boost/lexical_cast.hpp>
 #include <boost/optional/optional.hpp>
 
@@ -34,6 +44,52 @@ auto udp_t::emit(const record_t&, const string_view& formatted) -> void {
     socket.send_to(boost::asio::buffer(formatted.data(), formatted.size()), endpoint_);
 }
 
+auto udp_t::emit_batch(const batch_t& batch) -> void {
+#if defined(__linux__)
+    constexpr std::size_t chunk = 64;
+
+    std::array<::mmsghdr, chunk> headers;
+    std::array<::iovec, chunk> iovecs;
+
+    const auto fd = socket.native_handle();
+
+    for (std::size_t offset = 0; offset < batch.size(); offset += chunk) {
+        const auto count = std::min(chunk, batch.size() - offset);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& message = batch[offset + i].message;
+
+            iovecs[i].iov_base = const_cast<char*>(message.data());
+            iovecs[i].iov_len = message.size();
+
+            headers[i] = ::mmsghdr();
+            headers[i].msg_hdr.msg_name = endpoint_.data();
+            headers[i].msg_hdr.msg_namelen = static_cast<::socklen_t>(endpoint_.size());
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        std::size_t sent = 0;
+        while (sent < count) {
+            const auto rc = ::sendmmsg(fd, headers.data() + sent,
+                static_cast<unsigned int>(count - sent), 0);
+
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::system_category(), "failed to send datagrams");
+            }
+
+            sent += static_cast<std::size_t>(rc);
+        }
+    }
+#else
+    sink_t::emit_batch(batch);
+#endif
+}
+
 }  // namespace socket
 }  // namespace sink
 
@@ -28,6 +28,11 @@ public:
 
     /// Emits a datagram to the specified endpoint.
     auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Emits a datagram for each message from the given batch.
+    ///
+    /// On Linux datagrams are sent using `sendmmsg`, up to 64 ones per system call.
+    auto emit_batch(const batch_t& batch) -> void override;
 };
 
 }  // namespace socket
@@ -0,0 +1,112 @@
+#include "blackhole/thread.hpp"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+    #include <sys/prctl.h>
+    #include <sys/syscall.h>
+    #include <sys/types.h>
+#endif
+
+#include <array>
+#include <atomic>
+#include <system_error>
+
+#include "thread.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace this_thread {
+namespace {
+
+/// Process id, zero if not obtained yet.
+std::atomic<std::uint64_t> pid(0);
+
+/// Must be trivially constructible to avoid thread-local initialization guards on each access.
+struct local_t {
+    std::uint64_t lwp;
+    /// Whether the name below has been obtained.
+    bool cached;
+    bool named;
+    std::array<char, 16> name;
+};
+
+thread_local local_t local = {0, false, false, {{}}};
+
+auto fetch_lwp() noexcept -> std::uint64_t {
+#if defined(__linux__)
+    return static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+auto fetch_name(local_t& local) noexcept -> void {
+#if defined(__linux__)
+    local.named = ::prctl(PR_GET_NAME, local.name.data(), 0, 0, 0) == 0;
+#else
+    local.named = ::pthread_getname_np(::pthread_self(), local.name.data(), local.name.size()) == 0;
+#endif
+    local.name.back() = '\0';
+}
+
+/// Only the forking thread survives in the child, which is exactly the thread calling this.
+auto on_fork() noexcept -> void {
+    pid.store(static_cast<std::uint64_t>(::getpid()), std::memory_order_relaxed);
+
+    if (local.lwp != 0) {
+        local.lwp = fetch_lwp();
+    }
+}
+
+const int registered = ::pthread_atfork(nullptr, nullptr, &on_fork);
+
+}  // namespace
+
+auto info() noexcept -> info_t {
+    (void)registered;
+
+    auto id = pid.load(std::memory_order_relaxed);
+    if (id == 0) {
+        id = static_cast<std::uint64_t>(::getpid());
+        pid.store(id, std::memory_order_relaxed);
+    }
+
+    if (local.lwp == 0) {
+        local.lwp = fetch_lwp();
+    }
+
+#if defined(__linux__)
+    if (!local.cached) {
+        fetch_name(local);
+        local.cached = true;
+    }
+#else
+    fetch_name(local);
+#endif
+
+    return {id, local.lwp, local.named ? local.name.data() : nullptr};
+}
+
+auto set_name(const std::string& name) -> void {
+#if defined(__APPLE__)
+    const auto rc = ::pthread_setname_np(name.c_str());
+#else
+    const auto rc = ::pthread_setname_np(::pthread_self(), name.c_str());
+#endif
+
+    refresh();
+
+    if (rc != 0) {
+        throw std::system_error(rc, std::system_category(), "failed to set thread name");
+    }
+}
+
+auto refresh() noexcept -> void {
+    local.cached = false;
+}
+
+}  // namespace this_thread
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace this_thread {
+
+/// Cached identity of the calling thread.
+///
+/// All values are obtained once per thread (or once per process for pid) and then served from
+/// thread-local storage, so capturing them while constructing a record costs no system calls.
+struct info_t {
+    std::uint64_t pid;
+    std::uint64_t lwp;
+
+    /// Null-terminated thread name or nullptr if it can not be obtained.
+    const char* name;
+};
+
+/// Returns the identity of the calling thread.
+///
+/// The pid and lwp are refreshed in the child process after fork. On Linux the name is cached until
+/// the thread renames itself with `set_name` or calls `refresh`, otherwise it is obtained on each
+/// call.
+///
+/// \warning the returned name pointer is valid until the calling thread exits, renames or refreshes
+///     its name.
+auto info() noexcept -> info_t;
+
+}  // namespace this_thread
+}  // namespace v1
+}  // namespace blackhole
@@ -30,6 +30,10 @@ auto wrapper_t::log(severity_t severity, const lazy_message_t& message, attribut
     inner.log(severity, message, pack);
 }
 
+auto wrapper_t::enabled(severity_t severity) const noexcept -> bool {
+    return inner.enabled(severity);
+}
+
 auto wrapper_t::manager() -> scope::manager_t& {
     return inner.manager();
 }
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/clock.hpp>
+
+namespace blackhole {
+namespace testing {
+
+using std::chrono::milliseconds;
+
+namespace {
+
+auto distance(record_t::time_point lhs, record_t::time_point rhs) -> milliseconds {
+    return std::chrono::duration_cast<milliseconds>(lhs > rhs ? lhs - rhs : rhs - lhs);
+}
+
+}  // namespace
+
+TEST(clock_source, Precise) {
+    const auto clock = clock_source::precise();
+
+    const auto min = record_t::clock_type::now();
+    const auto now = clock->now();
+    const auto max = record_t::clock_type::now();
+
+    EXPECT_TRUE(min <= now);
+    EXPECT_TRUE(now <= max);
+}
+
+TEST(clock_source, Coarse) {
+    const auto clock = clock_source::coarse();
+
+    EXPECT_LE(distance(record_t::clock_type::now(), clock->now()), milliseconds(50));
+}
+
+TEST(clock_source, Tsc) {
+    const auto clock = clock_source::tsc();
+
+    EXPECT_LE(distance(record_t::clock_type::now(), clock->now()), milliseconds(5));
+
+    std::this_thread::sleep_for(milliseconds(20));
+
+    EXPECT_LE(distance(record_t::clock_type::now(), clock->now()), milliseconds(5));
+}
+
+TEST(clock_source, TscIsMonotonicAcrossResync) {
+    const auto clock = clock_source::tsc();
+
+    auto prev = clock->now();
+    const auto deadline = std::chrono::steady_clock::now() + milliseconds(1500);
+    while (std::chrono::steady_clock::now() < deadline) {
+        const auto now = clock->now();
+        ASSERT_TRUE(prev <= now);
+        prev = now;
+    }
+
+    EXPECT_LE(distance(record_t::clock_type::now(), clock->now()), milliseconds(5));
+}
+
+TEST(clock_source, TscIsShared) {
+    const auto clock = clock_source::tsc();
+
+    EXPECT_EQ(clock, clock_source::tsc());
+}
+
+TEST(clock_source, CreateByName) {
+    EXPECT_EQ(clock_source::precise(), clock_source::create("precise"));
+    EXPECT_EQ(clock_source::coarse(), clock_source::create("coarse"));
+
+    const auto clock = clock_source::tsc();
+    EXPECT_EQ(clock, clock_source::create("tsc"));
+}
+
+TEST(clock_source, ThrowsOnUnknownName) {
+    EXPECT_THROW(clock_source::create("sundial"), std::invalid_argument);
+}
+
+}  // namespace testing
+}  // namespace blackhole
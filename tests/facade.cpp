@@ -169,5 +169,72 @@ TEST(Facade, FormattedAttributeLog) {
     });
 }
 
+TEST(Facade, SkipsDisabledSeverity) {
+    class disabled_t : public logger_type {
+    public:
+        auto enabled(severity_t severity) const noexcept -> bool override {
+            return severity >= 1;
+        }
+    };
+
+    disabled_t inner;
+    logger_facade<logger_type> logger(inner);
+
+    EXPECT_CALL(inner, log(_, _))
+        .Times(0);
+    EXPECT_CALL(inner, log(_, An<const message_t&>(), _))
+        .Times(0);
+    EXPECT_CALL(inner, log(_, An<const lazy_message_t&>(), _))
+        .Times(0);
+
+    logger.log(0, "GET /porn.png HTTP/1.0");
+    logger.log(0, "GET /porn.png HTTP/1.0", attribute_list{{"key#1", {42}}});
+    logger.log(0, "GET /porn.png HTTP/1.0 - {}", 2345);
+    logger.log(0, "GET /porn.png HTTP/1.0 - {}", 2345, attribute_list{{"key#1", {42}}});
+}
+
+TEST(Facade, StripsSeverityBelowCompileTimeThreshold) {
+    typedef logger_facade<logger_type, 2> facade_type;
+
+    static_assert(!facade_type::compiled(1), "severity below threshold must be stripped");
+    static_assert(facade_type::compiled(2), "severity at threshold must be compiled in");
+
+    logger_type inner;
+    facade_type logger(inner);
+
+    int evaluated = 0;
+    const auto arg = [&]() -> int {
+        return ++evaluated;
+    };
+
+    EXPECT_CALL(inner, log(_, An<const lazy_message_t&>(), _))
+        .Times(0);
+
+    BLACKHOLE_LOG(logger, 1, "GET /porn.png HTTP/1.0 - {}", arg(), attribute_list{{"key#1", {42}}});
+    logger.log(1, "GET /porn.png HTTP/1.0 - {}", 42);
+
+    EXPECT_EQ(0, evaluated);
+}
+
+TEST(Facade, LogsSeverityAboveCompileTimeThreshold) {
+    logger_type inner;
+    logger_facade<logger_type, 2> logger(inner);
+
+    int evaluated = 0;
+    const auto arg = [&]() -> int {
+        return ++evaluated;
+    };
+
+    EXPECT_CALL(inner, log(severity_t(2), An<const lazy_message_t&>(), _))
+        .Times(1)
+        .WillOnce(WithArg<1>(Invoke([](const lazy_message_t& message) {
+            EXPECT_EQ("GET /porn.png HTTP/1.0 - 1", message.supplier().to_string());
+        })));
+
+    BLACKHOLE_LOG(logger, 2, "GET /porn.png HTTP/1.0 - {}", arg());
+
+    EXPECT_EQ(1, evaluated);
+}
+
 }  // namespace testing
 }  // namespace blackhole
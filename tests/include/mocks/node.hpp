@@ -23,10 +23,11 @@ public:
 
     auto is_string() const noexcept -> bool { return is_string_(); }
     auto is_vector() const noexcept -> bool { return false; }
-    auto is_object() const noexcept -> bool { return false; }
+    auto is_object() const noexcept -> bool { return is_object_(); }
 
     MOCK_CONST_METHOD0(is_uint64_, bool());
     MOCK_CONST_METHOD0(is_string_, bool());
+    MOCK_CONST_METHOD0(is_object_, bool());
 
     MOCK_CONST_METHOD0(to_bool, bool());
     MOCK_CONST_METHOD0(to_sint64, std::int64_t());
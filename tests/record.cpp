@@ -1,13 +1,21 @@
 #include <gtest/gtest.h>
 
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #if defined(__linux__)
     #include <sys/syscall.h>
-    #include <sys/types.h>
-    #include <unistd.h>
 #endif
 
+#include <cstring>
+#include <system_error>
+#include <thread>
+
 #include <blackhole/attribute.hpp>
 #include <blackhole/record.hpp>
+#include <blackhole/thread.hpp>
 
 namespace blackhole {
 namespace testing {
@@ -72,6 +80,104 @@ TEST(Record, Tid) {
     EXPECT_EQ(::pthread_self(), record.tid());
 }
 
+#if defined(__linux__)
+TEST(Record, LwpFromAnotherThread) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    std::uint64_t lwp = 0;
+    std::uint64_t expected = 0;
+
+    std::thread([&] {
+        record_t record(42, message, pack);
+        lwp = record.lwp();
+        expected = static_cast<std::uint64_t>(syscall(SYS_gettid));
+    }).join();
+
+    EXPECT_EQ(expected, lwp);
+    EXPECT_NE(static_cast<std::uint64_t>(syscall(SYS_gettid)), lwp);
+}
+
+TEST(Record, PidAndLwpAfterFork) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    // Warm up the cache in the parent process.
+    record_t record(42, message, pack);
+
+    const auto pid = ::fork();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+        record_t child(42, message, pack);
+
+        const auto pass = child.pid() == static_cast<std::uint64_t>(::getpid()) &&
+            child.lwp() == static_cast<std::uint64_t>(syscall(SYS_gettid));
+        ::_exit(pass ? 0 : 1);
+    }
+
+    int status = 0;
+    ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST(Record, ThreadNameRefreshedAfterRename) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    std::thread([&] {
+        blackhole::this_thread::set_name("worker#1");
+        {
+            record_t record(42, message, pack);
+            ASSERT_NE(nullptr, record.thread_name());
+            EXPECT_STREQ("worker#1", record.thread_name());
+        }
+
+        blackhole::this_thread::set_name("worker#2");
+        {
+            record_t record(42, message, pack);
+            ASSERT_NE(nullptr, record.thread_name());
+            EXPECT_STREQ("worker#2", record.thread_name());
+        }
+    }).join();
+}
+
+TEST(Record, ThreadNameRefreshedExplicitly) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    std::thread([&] {
+        blackhole::this_thread::set_name("worker#1");
+        {
+            record_t record(42, message, pack);
+            EXPECT_STREQ("worker#1", record.thread_name());
+        }
+
+        // Renames by other means are not tracked until asked.
+        ::pthread_setname_np(::pthread_self(), "worker#2");
+        {
+            record_t record(42, message, pack);
+            EXPECT_STREQ("worker#1", record.thread_name());
+        }
+
+        blackhole::this_thread::refresh();
+        {
+            record_t record(42, message, pack);
+            ASSERT_NE(nullptr, record.thread_name());
+            EXPECT_STREQ("worker#2", record.thread_name());
+        }
+    }).join();
+}
+
+TEST(Record, ThrowsIfThreadNameIsTooLong) {
+    std::thread([] {
+        EXPECT_THROW(blackhole::this_thread::set_name("a name that is too long"),
+            std::system_error);
+    }).join();
+}
+#endif
+
 TEST(Record, NullTimestampByDefault) {
     const string_view message("GET /porn.png HTTP/1.1");
     const attribute_pack pack;
@@ -1,11 +1,132 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include <blackhole/config/factory.hpp>
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/factory.hpp>
+#include <blackhole/formatter.hpp>
 #include <blackhole/registry.hpp>
 #include <blackhole/root.hpp>
 
 #include "mocks/node.hpp"
 
 namespace blackhole {
+namespace testing {
+namespace {
+
+/// In-memory configuration tree of strings, integers, arrays and objects.
+class tree_t : public config::node_t {
+    std::string value;
+    std::int64_t number;
+    bool integer;
+    std::vector<tree_t> items;
+    std::vector<std::string> keys;
+    std::vector<tree_t> values;
+    bool array;
+
+public:
+    tree_t(const char* value) : value(value), number(0), integer(false), array(false) {}
+    tree_t(std::int64_t number) : number(number), integer(true), array(false) {}
+    tree_t(std::vector<tree_t> items) :
+        number(0),
+        integer(false),
+        items(std::move(items)),
+        array(true)
+    {}
+    tree_t(std::vector<std::pair<std::string, tree_t>> members) :
+        number(0),
+        integer(false),
+        array(false)
+    {
+        for (auto& member : members) {
+            keys.push_back(std::move(member.first));
+            values.push_back(std::move(member.second));
+        }
+    }
+
+    auto is_bool() const noexcept -> bool { return false; }
+    auto is_sint64() const noexcept -> bool { return integer; }
+    auto is_uint64() const noexcept -> bool { return false; }
+    auto is_double() const noexcept -> bool { return false; }
+    auto is_string() const noexcept -> bool { return !integer && !array && keys.empty(); }
+    auto is_vector() const noexcept -> bool { return array; }
+    auto is_object() const noexcept -> bool { return !keys.empty(); }
+
+    auto to_bool() const -> bool { throw std::logic_error("not a bool"); }
+    auto to_sint64() const -> std::int64_t {
+        if (integer) {
+            return number;
+        }
+
+        throw std::logic_error("not a number");
+    }
+    auto to_uint64() const -> std::uint64_t { throw std::logic_error("not a number"); }
+    auto to_double() const -> double { throw std::logic_error("not a number"); }
+    auto to_string() const -> std::string { return value; }
+
+    auto each(const each_function& fn) const -> void {
+        for (const auto& item : items) {
+            fn(item);
+        }
+    }
+
+    auto each_map(const member_function& fn) const -> void {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            fn(keys[i], values[i]);
+        }
+    }
+
+    auto operator[](const std::size_t& idx) const -> config::option<config::node_t> {
+        if (idx < items.size()) {
+            return config::make_option<tree_t>(items[idx]);
+        }
+
+        return {};
+    }
+
+    auto operator[](const std::string& key) const -> config::option<config::node_t> {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) {
+                return config::make_option<tree_t>(values[i]);
+            }
+        }
+
+        return {};
+    }
+};
+
+class tree_factory_t : public config::factory_t {
+    tree_t tree;
+
+public:
+    explicit tree_factory_t(tree_t tree) : tree(std::move(tree)) {}
+
+    auto config() const -> const config::node_t& {
+        return tree;
+    }
+};
+
+}  // namespace
+}  // namespace testing
+
+namespace config {
+
+template<>
+class factory_traits<::blackhole::testing::tree_t> {
+public:
+    static auto construct(::blackhole::testing::tree_t tree) -> std::unique_ptr<factory_t> {
+        return blackhole::make_unique<::blackhole::testing::tree_factory_t>(std::move(tree));
+    }
+};
+
+}  // namespace config
+
 namespace testing {
 
 using ::testing::ByRef;
@@ -99,5 +220,201 @@ TEST(registry_t, ThrowsWhenTryingBuildOnUnknownHandler) {
     }
 }
 
+TEST(registry_t, BuildFromObjectWithClock) {
+    using config::testing::mock::node_t;
+
+    auto registry = registry::configured();
+
+    node_t n0;
+    auto n1 = new node_t;
+    auto n2 = new node_t;
+    auto n3 = new node_t;
+
+    auto builder = registry->builder<node_t>();
+
+    auto& factory = dynamic_cast<config::factory<node_t>&>(builder.configurator());
+    EXPECT_CALL(factory, config())
+        .Times(1)
+        .WillOnce(ReturnRef(n0));
+
+    EXPECT_CALL(n0, subscript_key("root"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, is_object_())
+        .WillRepeatedly(Return(true));
+
+    EXPECT_CALL(*n1, subscript_key("handlers"))
+        .Times(1)
+        .WillOnce(Return(n2));
+
+    EXPECT_CALL(*n2, each(_))
+        .Times(1);
+
+    EXPECT_CALL(*n1, subscript_key("clock"))
+        .Times(1)
+        .WillOnce(Return(n3));
+
+    EXPECT_CALL(*n3, to_string())
+        .Times(1)
+        .WillOnce(Return("sundial"));
+
+    EXPECT_THROW(builder.build("root"), std::invalid_argument);
+}
+
+namespace {
+
+/// Counts both formatters created and records formatted.
+struct counters_t {
+    std::size_t created = 0;
+    std::size_t formatted = 0;
+};
+
+class counting_formatter_t : public formatter_t {
+    counters_t& counters;
+
+public:
+    explicit counting_formatter_t(counters_t& counters) : counters(counters) {}
+
+    auto format(const record_t&, writer_t& writer) -> void override {
+        ++counters.formatted;
+        writer.write("-");
+    }
+};
+
+class counting_factory_t : public factory<formatter_t> {
+    counters_t& counters;
+
+public:
+    explicit counting_factory_t(counters_t& counters) : counters(counters) {}
+
+    auto type() const noexcept -> const char* override {
+        return "counting";
+    }
+
+    auto from(const config::node_t&) const -> std::unique_ptr<formatter_t> override {
+        ++counters.created;
+        return std::unique_ptr<formatter_t>(new counting_formatter_t(counters));
+    }
+};
+
+/// Creates a blocking handler config with a null sink and the given formatter config.
+auto handler(std::vector<std::pair<std::string, tree_t>> formatter) -> tree_t {
+    return std::vector<std::pair<std::string, tree_t>>{
+        {"formatter", std::move(formatter)},
+        {"sinks", std::vector<tree_t>{
+            std::vector<std::pair<std::string, tree_t>>{{"type", "null"}}
+        }}
+    };
+}
+
+}  // namespace
+
+TEST(registry_t, BuildSharesIdenticalFormatters) {
+    counters_t counters;
+
+    auto registry = registry::configured();
+    registry->add(std::make_shared<counting_factory_t>(counters));
+
+    const std::vector<tree_t> pattern{"{message}"};
+
+    const tree_t root = std::vector<std::pair<std::string, tree_t>>{
+        {"root", std::vector<tree_t>{
+            handler({{"type", "counting"}, {"pattern", pattern}, {"x", "1"}}),
+            handler({{"x", "1"}, {"type", "counting"}, {"pattern", pattern}}),
+            handler({{"type", "counting"}, {"pattern", pattern}, {"x", "2"}})
+        }}
+    };
+
+    auto logger = registry->builder<tree_t>(root).build("root");
+
+    // The first two handlers differ only in the order of formatter options.
+    EXPECT_EQ(2, counters.created);
+
+    logger.log(0, "value");
+    EXPECT_EQ(2, counters.formatted);
+
+    logger.log(0, "value");
+    EXPECT_EQ(4, counters.formatted);
+}
+
+TEST(registry_t, SeparateBuildsDoNotShareFormatters) {
+    counters_t counters;
+
+    auto registry = registry::configured();
+    registry->add(std::make_shared<counting_factory_t>(counters));
+
+    const std::vector<tree_t> pattern{"{message}"};
+
+    const tree_t root = std::vector<std::pair<std::string, tree_t>>{
+        {"root", std::vector<tree_t>{
+            handler({{"type", "counting"}, {"pattern", pattern}})
+        }}
+    };
+
+    auto builder = registry->builder<tree_t>(root);
+    auto l1 = builder.build("root");
+    auto l2 = builder.build("root");
+
+    EXPECT_EQ(2, counters.created);
+}
+
+namespace {
+
+/// Creates a sink config of the given type, filtered by the given severity threshold.
+auto sink(const char* type, std::int64_t threshold) -> tree_t {
+    return std::vector<std::pair<std::string, tree_t>>{
+        {"type", type},
+        {"filter", std::vector<std::pair<std::string, tree_t>>{
+            {"type", "severity"},
+            {"threshold", threshold}
+        }}
+    };
+}
+
+/// Creates a handler config of the given type with a string formatter and the given sinks.
+auto handler(const char* type, std::vector<tree_t> sinks) -> tree_t {
+    return std::vector<std::pair<std::string, tree_t>>{
+        {"type", type},
+        {"formatter", std::vector<std::pair<std::string, tree_t>>{
+            {"type", "string"},
+            {"pattern", "{message}"}
+        }},
+        {"sinks", std::move(sinks)}
+    };
+}
+
+}  // namespace
+
+TEST(registry_t, BuildReportsThresholdOfSinkFilters) {
+    const tree_t root = std::vector<std::pair<std::string, tree_t>>{
+        {"root", std::vector<tree_t>{
+            handler("blocking", {sink("null", 3), sink("null", 5)}),
+            handler("asynchronous", {sink("null", 4)})
+        }}
+    };
+
+    auto logger = registry::configured()->builder<tree_t>(root).build("root");
+
+    EXPECT_FALSE(logger.enabled(2));
+    EXPECT_TRUE(logger.enabled(3));
+    EXPECT_TRUE(logger.enabled(4));
+}
+
+TEST(registry_t, BuildReportsNoThresholdForUnfilteredSink) {
+    const tree_t root = std::vector<std::pair<std::string, tree_t>>{
+        {"root", std::vector<tree_t>{
+            handler("blocking", {
+                sink("null", 3),
+                std::vector<std::pair<std::string, tree_t>>{{"type", "null"}}
+            })
+        }}
+    };
+
+    auto logger = registry::configured()->builder<tree_t>(root).build("root");
+
+    EXPECT_TRUE(logger.enabled(-1));
+}
+
 }  // namespace testing
 }  // namespace blackhole
@@ -1,12 +1,24 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/clock.hpp>
 #include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler/asynchronous.hpp>
+#include <blackhole/handler/blocking.hpp>
 #include <blackhole/logger.hpp>
 #include <blackhole/record.hpp>
 #include <blackhole/root.hpp>
 #include <blackhole/scope/holder.hpp>
+#include <blackhole/scope/manager.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/sink/asynchronous.hpp>
 
 #include "mocks/handler.hpp"
 
@@ -325,6 +337,91 @@ TEST(RootLogger, LogWithNestedScopedAttributes) {
     logger.log(0, "GET /porn.png HTTP/1.1");
 }
 
+TEST(RootLogger, LogWithNestedScopedAttributesRepeatedly) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    const auto outer = [](const record_t& record) {
+        ASSERT_EQ(1, record.attributes().size());
+        EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(0).get());
+    };
+
+    const auto inner = [](const record_t& record) {
+        ASSERT_EQ(2, record.attributes().size());
+        EXPECT_EQ((attribute_list{{"key#2", {100}}}), record.attributes().at(0).get());
+        EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(1).get());
+    };
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(5)
+        .WillOnce(Invoke(outer))
+        .WillOnce(Invoke(inner))
+        .WillOnce(Invoke(inner))
+        .WillOnce(Invoke(outer))
+        .WillOnce(Invoke(outer));
+
+    root_logger_t logger(std::move(handlers));
+    const scope::holder_t s1(logger, {{"key#1", {42}}});
+
+    logger.log(0, "-");
+
+    {
+        const scope::holder_t s2(logger, {{"key#2", {100}}});
+        logger.log(0, "-");
+        logger.log(0, "-");
+    }
+
+    logger.log(0, "-");
+    logger.log(0, "-");
+}
+
+TEST(RootLogger, ScopedAttributesAreBoundToLogger) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            EXPECT_EQ(0, record.attributes().size());
+        }));
+
+    root_logger_t other({});
+    root_logger_t logger(std::move(handlers));
+    const scope::holder_t scoped(other, {{"key#1", {42}}});
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+}
+
+TEST(RootLogger, ScopedAttributesAreThreadLocal) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            EXPECT_EQ(0, record.attributes().size());
+        }));
+
+    root_logger_t logger(std::move(handlers));
+    const scope::holder_t scoped(logger, {{"key#1", {42}}});
+
+    std::thread([&] {
+        EXPECT_EQ(nullptr, logger.manager().get());
+        logger.log(0, "GET /porn.png HTTP/1.1");
+    }).join();
+
+    EXPECT_NE(nullptr, logger.manager().get());
+}
+
 TEST(RootLogger, AssignmentMovesScopedAttributes) {
     typedef view_of<attributes_t>::type attribute_list;
 
@@ -428,6 +525,128 @@ TEST(RootLogger, AssignmentMovesNestedTripleScopedAttributes) {
     logger1.log(0, "-");
 }
 
+TEST(RootLogger, FilterCanBeReplacedWhileHandling) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+
+    // Replacing the filter from inside the handler must neither deadlock nor invalidate the
+    // snapshot that is currently used for dispatching.
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t&) {
+            logger.filter([](const record_t&) -> bool {
+                return false;
+            });
+        }));
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+    logger.log(0, "GET /porn.png HTTP/1.1");
+}
+
+TEST(RootLogger, DisabledWithoutHandlers) {
+    root_logger_t logger({});
+
+    EXPECT_FALSE(logger.enabled(0));
+}
+
+TEST(RootLogger, UsesClockSource) {
+    class clock_t : public clock_source_t {
+    public:
+        auto now() const noexcept -> time_point override {
+            return time_point(std::chrono::seconds(42));
+        }
+    };
+
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+    logger.clock(std::make_shared<clock_t>());
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            EXPECT_EQ(record_t::time_point(std::chrono::seconds(42)), record.timestamp());
+        }));
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+}
+
+TEST(RootLogger, EnabledRespectsFilterThreshold) {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(new mock::handler_t);
+
+    root_logger_t logger(std::move(handlers));
+
+    EXPECT_TRUE(logger.enabled(-1));
+
+    logger.filter([](const record_t&) -> bool {
+        return true;
+    }, 2);
+
+    EXPECT_FALSE(logger.enabled(1));
+    EXPECT_TRUE(logger.enabled(2));
+    EXPECT_TRUE(logger.enabled(3));
+
+    logger.filter([](const record_t&) -> bool {
+        return true;
+    });
+
+    EXPECT_TRUE(logger.enabled(1));
+}
+
+TEST(RootLogger, EnabledRespectsHandlersThreshold) {
+    class handler_t : public mock::handler_t {
+        int value;
+
+    public:
+        explicit handler_t(int value) : value(value) {}
+
+        auto threshold() const noexcept -> severity_t override {
+            return value;
+        }
+    };
+
+    std::vector<std::unique_ptr<blackhole::handler_t>> handlers;
+    handlers.emplace_back(new handler_t(3));
+    handlers.emplace_back(new handler_t(1));
+
+    root_logger_t logger(std::move(handlers));
+
+    EXPECT_FALSE(logger.enabled(0));
+    EXPECT_TRUE(logger.enabled(1));
+
+    logger.filter([](const record_t&) -> bool {
+        return true;
+    }, 2);
+
+    EXPECT_FALSE(logger.enabled(1));
+    EXPECT_TRUE(logger.enabled(2));
+}
+
+TEST(RootLogger, MoveConstructorMovesThreshold) {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(new mock::handler_t);
+
+    root_logger_t original(std::move(handlers));
+    original.filter([](const record_t&) -> bool {
+        return true;
+    }, 2);
+
+    root_logger_t logger(std::move(original));
+
+    EXPECT_FALSE(logger.enabled(1));
+    EXPECT_TRUE(logger.enabled(2));
+}
+
 TEST(RootLogger, IgnoresExceptionsFromHandlers) {
     auto handler = new mock::handler_t;
     std::vector<std::unique_ptr<handler_t>> handlers;
@@ -508,5 +727,89 @@ TEST(RootLogger, BuilderChainedAddHandler) {
     logger->log(0, "GET /porn.png HTTP/1.1");
 }
 
+/// Emits slowly, so records pile up in queues, and counts what has been flushed.
+class slow_sink_t : public sink_t {
+    std::atomic<int>& emitted;
+    std::atomic<int>& flushed;
+
+public:
+    slow_sink_t(std::atomic<int>& emitted, std::atomic<int>& flushed) :
+        emitted(emitted),
+        flushed(flushed)
+    {}
+
+    auto emit(const record_t&, const string_view&) -> void override {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        ++emitted;
+    }
+
+    auto flush() -> void override {
+        flushed.store(emitted.load());
+    }
+};
+
+TEST(RootLogger, FlushWaitsForAsynchronousSinks) {
+    std::atomic<int> emitted(0);
+    std::atomic<int> flushed(0);
+
+    std::unique_ptr<sink_t> sink(new slow_sink_t(emitted, flushed));
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{message}").build())
+        .add(builder<sink::asynchronous_t>(std::move(sink)).build())
+        .build());
+
+    root_logger_t logger(std::move(handlers));
+
+    for (int i = 0; i < 200; ++i) {
+        logger.log(0, "value");
+    }
+
+    EXPECT_TRUE(logger.flush(std::chrono::seconds(10)));
+    EXPECT_EQ(200, emitted.load());
+    EXPECT_EQ(200, flushed.load());
+}
+
+TEST(RootLogger, FlushWaitsForAsynchronousHandlers) {
+    std::atomic<int> emitted(0);
+    std::atomic<int> flushed(0);
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::asynchronous_t>()
+        .set(builder<formatter::string_t>("{message}").build())
+        .add(std::unique_ptr<sink_t>(new slow_sink_t(emitted, flushed)))
+        .build());
+
+    root_logger_t logger(std::move(handlers));
+
+    for (int i = 0; i < 200; ++i) {
+        logger.log(0, "value");
+    }
+
+    EXPECT_TRUE(logger.flush(std::chrono::seconds(10)));
+    EXPECT_EQ(200, emitted.load());
+    EXPECT_EQ(200, flushed.load());
+}
+
+TEST(RootLogger, FlushTimesOut) {
+    std::atomic<int> emitted(0);
+    std::atomic<int> flushed(0);
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::asynchronous_t>()
+        .set(builder<formatter::string_t>("{message}").build())
+        .add(std::unique_ptr<sink_t>(new slow_sink_t(emitted, flushed)))
+        .build());
+
+    root_logger_t logger(std::move(handlers));
+
+    for (int i = 0; i < 1000; ++i) {
+        logger.log(0, "value");
+    }
+
+    EXPECT_FALSE(logger.flush(std::chrono::milliseconds(1)));
+}
+
 } // namespace
 } // namespace blackhole
@@ -0,0 +1,509 @@
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/filter.hpp>
+#include <blackhole/handler/asynchronous.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/registry.hpp>
+#include <src/handler/asynchronous.hpp>
+#include <src/sink/asynchronous/queue.hpp>
+
+#include "mocks/formatter.hpp"
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::_;
+
+using namespace testing;
+
+TEST(asynchronous_t, FormatsAndEmitsOnBackgroundThread) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    const auto caller = std::this_thread::get_id();
+    std::thread::id worker;
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t& record, writer_t& writer) {
+            worker = std::this_thread::get_id();
+
+            EXPECT_EQ(42, record.severity());
+            EXPECT_EQ("-", record.message().to_string());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ("key", record.attributes().at(0).get().at(0).first.to_string());
+
+            writer.write("---");
+        }));
+
+    EXPECT_CALL(sink, emit(_, string_view("---")))
+        .Times(1);
+
+    {
+        auto handler = builder<asynchronous_t>()
+            .set(std::move(formatter_))
+            .add(std::move(sink_))
+            .factor(4)
+            .build();
+
+        // The record and its attributes die before the worker thread has a chance to format it.
+        const string_view message("-");
+        const attribute_list attributes{{"key", "value"}};
+        const attribute_pack pack{attributes};
+        record_t record(42, message, pack);
+
+        handler->handle(record);
+    }
+
+    EXPECT_NE(caller, worker);
+}
+
+TEST(asynchronous_t, EmitsToAllSinksInOrder) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            writer.inner << record.severity();
+        }));
+
+    std::vector<int> first;
+    std::vector<int> second;
+
+    std::unique_ptr<mock::sink_t> sink1(new mock::sink_t);
+    EXPECT_CALL(*sink1, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            first.push_back(std::stoi(message.to_string()));
+        }));
+
+    std::unique_ptr<mock::sink_t> sink2(new mock::sink_t);
+    EXPECT_CALL(*sink2, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            second.push_back(std::stoi(message.to_string()));
+        }));
+
+    {
+        auto handler = builder<asynchronous_t>()
+            .set(std::move(formatter))
+            .add(std::move(sink1))
+            .add(std::move(sink2))
+            .factor(2)
+            .wait()
+            .build();
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 100; ++i) {
+            record_t record(i, message, pack);
+            handler->handle(record);
+        }
+    }
+
+    ASSERT_EQ(100, first.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(i, first[i]);
+    }
+
+    EXPECT_EQ(first, second);
+}
+
+TEST(asynchronous_t, DropsRecordIfFormatterThrows) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            if (record.severity() == 1) {
+                throw std::runtime_error("-");
+            }
+
+            writer.inner << record.severity();
+        }));
+
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    EXPECT_CALL(*sink, emit(_, string_view("0")))
+        .Times(1);
+    EXPECT_CALL(*sink, emit(_, string_view("2")))
+        .Times(1);
+
+    auto handler = builder<asynchronous_t>()
+        .set(std::move(formatter))
+        .add(std::move(sink))
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int i = 0; i < 3; ++i) {
+        record_t record(i, message, pack);
+        handler->handle(record);
+    }
+}
+
+/// Denies records with severity below the threshold.
+class threshold_filter_t : public filter_t {
+    severity_t threshold;
+
+public:
+    explicit threshold_filter_t(severity_t threshold) : threshold(threshold) {}
+
+    auto filter(const record_t& record) -> action_t override {
+        return record.severity() >= threshold ? action_t::neutral : action_t::deny;
+    }
+};
+
+TEST(asynchronous_t, FiltersPerSink) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    std::vector<int> formatted;
+    EXPECT_CALL(*formatter, format(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            formatted.push_back(record.severity());
+            writer.inner << record.severity();
+        }));
+
+    std::vector<std::string> first;
+    std::vector<std::string> second;
+
+    std::unique_ptr<mock::sink_t> sink1(new mock::sink_t);
+    EXPECT_CALL(*sink1, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            first.push_back(message.to_string());
+        }));
+
+    std::unique_ptr<mock::sink_t> sink2(new mock::sink_t);
+    EXPECT_CALL(*sink2, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            second.push_back(message.to_string());
+        }));
+
+    {
+        auto handler = builder<asynchronous_t>()
+            .set(std::move(formatter))
+            .add(std::move(sink1), std::unique_ptr<filter_t>(new threshold_filter_t(2)))
+            .add(std::move(sink2), std::unique_ptr<filter_t>(new threshold_filter_t(4)))
+            .build();
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 5; ++i) {
+            record_t record(i, message, pack);
+            handler->handle(record);
+        }
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"2", "3", "4"}), first);
+    EXPECT_EQ((std::vector<std::string>{"4"}), second);
+
+    // Records denied by all sinks are not formatted.
+    EXPECT_EQ((std::vector<int>{2, 3, 4}), formatted);
+}
+
+/// Throws on records with the given severity, accepting others.
+class throwing_filter_t : public filter_t {
+    severity_t severity;
+
+public:
+    explicit throwing_filter_t(severity_t severity) : severity(severity) {}
+
+    auto filter(const record_t& record) -> action_t override {
+        if (record.severity() == severity) {
+            throw 42;
+        }
+
+        return action_t::neutral;
+    }
+};
+
+TEST(asynchronous_t, ThrowingFilterDeniesRecord) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            writer.inner << record.severity();
+        }));
+
+    std::vector<std::string> first;
+    std::vector<std::string> second;
+
+    std::unique_ptr<mock::sink_t> sink1(new mock::sink_t);
+    EXPECT_CALL(*sink1, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            first.push_back(message.to_string());
+        }));
+
+    std::unique_ptr<mock::sink_t> sink2(new mock::sink_t);
+    EXPECT_CALL(*sink2, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            second.push_back(message.to_string());
+        }));
+
+    {
+        auto handler = builder<asynchronous_t>()
+            .set(std::move(formatter))
+            .add(std::move(sink1), std::unique_ptr<filter_t>(new throwing_filter_t(1)))
+            .add(std::move(sink2))
+            .build();
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 3; ++i) {
+            record_t record(i, message, pack);
+            handler->handle(record);
+        }
+    }
+
+    // The worker thread survives, only the sink behind the throwing filter misses the record.
+    EXPECT_EQ((std::vector<std::string>{"0", "2"}), first);
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2"}), second);
+}
+
+TEST(asynchronous_t, DropsRecordIfFormatterThrowsNonStandard) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            if (record.severity() == 1) {
+                throw 42;
+            }
+
+            writer.inner << record.severity();
+        }));
+
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    EXPECT_CALL(*sink, emit(_, string_view("0")))
+        .Times(1);
+    EXPECT_CALL(*sink, emit(_, string_view("2")))
+        .WillOnce(Invoke([](const record_t&, const string_view&) {
+            throw 42;
+        }));
+
+    auto handler = builder<asynchronous_t>()
+        .set(std::move(formatter))
+        .add(std::move(sink))
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int i = 0; i < 3; ++i) {
+        record_t record(i, message, pack);
+        handler->handle(record);
+    }
+}
+
+TEST(asynchronous_t, FactorySinkFilter) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    std::vector<std::string> messages;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    EXPECT_CALL(*sink_, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            messages.push_back(message.to_string());
+        }));
+
+    EXPECT_CALL(registry, formatter("string"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<formatter_t> {
+            std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+            EXPECT_CALL(*formatter, format(_, _))
+                .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+                    writer.inner << record.severity();
+                }));
+            return std::move(formatter);
+        }));
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([&](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::move(sink_);
+        }));
+
+    EXPECT_CALL(registry, filter("severity"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<filter_t> {
+            return std::unique_ptr<filter_t>(new threshold_filter_t(3));
+        }));
+
+    /// Creates a node with the "type" child of the given value.
+    auto typed = [](const std::string& type) -> NiceMock<node_t>* {
+        auto node = new NiceMock<node_t>;
+        EXPECT_CALL(*node, subscript_key("type"))
+            .WillRepeatedly(Invoke([=](const std::string&) {
+                auto ntype = new NiceMock<node_t>;
+                EXPECT_CALL(*ntype, to_string())
+                    .WillRepeatedly(Return(type));
+                return ntype;
+            }));
+        return node;
+    };
+
+    EXPECT_CALL(config, subscript_key("formatter"))
+        .WillRepeatedly(Invoke([&](const std::string&) {
+            return typed("string");
+        }));
+
+    auto nsinks = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("sinks"))
+        .WillOnce(Return(nsinks));
+    EXPECT_CALL(*nsinks, each(_))
+        .WillOnce(Invoke([&](const node_t::each_function& fn) {
+            auto nsink = typed("null");
+            EXPECT_CALL(*nsink, subscript_key("filter"))
+                .WillRepeatedly(Invoke([&](const std::string&) {
+                    return typed("severity");
+                }));
+
+            fn(*nsink);
+            delete nsink;
+        }));
+
+    for (auto key : {"factor", "queue", "overflow", "underflow", "deadline"}) {
+        EXPECT_CALL(config, subscript_key(key))
+            .WillOnce(Return(nullptr));
+    }
+
+    {
+        auto handler = factory<asynchronous_t>(registry).from(config);
+
+        const string_view message("-");
+        const attribute_pack pack;
+        handler->handle(record_t(2, message, pack));
+        handler->handle(record_t(4, message, pack));
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"4"}), messages);
+}
+
+/// Emits each batch slowly, recording single records, which are synthetic reports.
+class slow_sink_t : public sink_t {
+public:
+    struct state_t {
+        std::mutex mutex;
+        std::size_t emitted = 0;
+        std::vector<std::string> reports;
+    };
+
+    state_t& state;
+
+    explicit slow_sink_t(state_t& state) : state(state) {}
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.reports.push_back(message.to_string());
+    }
+
+    auto emit_batch(const batch_t& batch) -> void override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.emitted += batch.size();
+    }
+};
+
+/// Writes the record message as is.
+auto message_formatter() -> std::unique_ptr<formatter_t> {
+    std::unique_ptr<NiceMock<mock::formatter_t>> formatter(new NiceMock<mock::formatter_t>);
+    ON_CALL(*formatter, format(_, _))
+        .WillByDefault(Invoke([](const record_t& record, writer_t& writer) {
+            writer.inner << record.message().to_string();
+        }));
+
+    return std::move(formatter);
+}
+
+TEST(asynchronous_t, HandlerReportsDroppedRecords) {
+    slow_sink_t::state_t state;
+
+    {
+        auto handler = builder<asynchronous_t>()
+            .set(message_formatter())
+            .add(std::unique_ptr<sink_t>(new slow_sink_t(state)))
+            .factor(2)
+            .drop()
+            .build();
+
+        const string_view message("-");
+        const attribute_pack pack;
+        record_t record(2, message, pack);
+
+        handler->handle(record);
+        // Let the worker block while emitting the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        for (int i = 1; i < 10; ++i) {
+            handler->handle(record);
+        }
+    }
+
+    const auto dropped = std::to_string(10 - state.emitted);
+
+    ASSERT_EQ(1, state.reports.size());
+    EXPECT_EQ("dropped " + dropped + " records (2: " + dropped + ")", state.reports[0]);
+    EXPECT_GT(10, state.emitted);
+}
+
+TEST(asynchronous_t, HandlerDeadlineAbandonsQueuedRecords) {
+    slow_sink_t::state_t state;
+
+    {
+        auto handler = builder<asynchronous_t>()
+            .set(message_formatter())
+            .add(std::unique_ptr<sink_t>(new slow_sink_t(state)))
+            .factor(8)
+            .deadline(std::chrono::milliseconds(1))
+            .build();
+
+        const string_view message("-");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        handler->handle(record);
+        // Let the worker block while emitting the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        for (int i = 1; i < 200; ++i) {
+            handler->handle(record);
+        }
+    }
+
+    // The batch being emitted when the deadline expires is still completed.
+    ASSERT_EQ(1, state.reports.size());
+    EXPECT_EQ("abandoned " + std::to_string(200 - state.emitted) + " records on shutdown",
+        state.reports[0]);
+    EXPECT_GT(200, state.emitted);
+}
+
+TEST(asynchronous_t, HandlerFactoryType) {
+    mock_registry_t registry;
+    factory<asynchronous_t> factory(registry);
+
+    EXPECT_EQ(std::string("asynchronous"), factory.type());
+}
+
+}  // namespace
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
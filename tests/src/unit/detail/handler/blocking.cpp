@@ -1,12 +1,18 @@
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <blackhole/attribute.hpp>
 #include <blackhole/extensions/writer.hpp>
+#include <blackhole/filter.hpp>
 #include <blackhole/handler/blocking.hpp>
 #include <blackhole/record.hpp>
 #include <src/handler/blocking.hpp>
 
 #include "mocks/formatter.hpp"
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
 #include "mocks/sink.hpp"
 
 namespace blackhole {
@@ -15,6 +21,8 @@ namespace handler {
 namespace {
 
 using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
 using ::testing::_;
 
 using namespace testing;
@@ -51,6 +59,238 @@ TEST(blocking_t, Handle) {
     handler.handle(record);
 }
 
+TEST(blocking_t, ReusesFormatBufferBetweenRecords) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    // Larger than the writer inline buffer, so the formatted message lives on the heap.
+    const std::string line(2048, 'x');
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t&, writer_t& writer) {
+            writer.write(line);
+        }));
+
+    std::vector<const char*> data;
+    EXPECT_CALL(sink, emit(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            EXPECT_EQ(line, message.to_string());
+            data.push_back(message.data());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    handler.handle(record);
+    handler.handle(record);
+
+    ASSERT_EQ(2, data.size());
+    EXPECT_EQ(data[0], data[1]);
+}
+
+TEST(blocking_t, NestedHandleGetsOwnFormatBuffer) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.severity());
+        }));
+
+    std::vector<std::string> messages;
+    EXPECT_CALL(sink, emit(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t& record, const string_view& message) {
+            // Imitates a sink, which logs about its own troubles through the same handler.
+            if (record.severity() == 1) {
+                const string_view inner("-");
+                const attribute_pack pack;
+                handler.handle(record_t(2, inner, pack));
+            }
+
+            messages.push_back(message.to_string());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(1, message, pack);
+
+    handler.handle(record);
+
+    EXPECT_EQ((std::vector<std::string>{"2", "1"}), messages);
+}
+
+/// Denies records with severity below the threshold.
+class threshold_filter_t : public filter_t {
+    severity_t threshold;
+
+public:
+    /// Number of records evaluated.
+    std::size_t calls;
+
+    explicit threshold_filter_t(severity_t threshold) : threshold(threshold), calls(0) {}
+
+    auto filter(const record_t& record) -> action_t override {
+        ++calls;
+        return record.severity() >= threshold ? action_t::neutral : action_t::deny;
+    }
+};
+
+TEST(blocking_t, FiltersPerSink) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink1_(new mock::sink_t);
+    std::unique_ptr<mock::sink_t> sink2_(new mock::sink_t);
+    mock::sink_t& sink1 = *sink1_;
+    mock::sink_t& sink2 = *sink2_;
+
+    std::unique_ptr<threshold_filter_t> filter_(new threshold_filter_t(3));
+    threshold_filter_t& filter = *filter_;
+
+    std::vector<blocking_t::target_t> targets;
+    targets.push_back({std::move(sink1_), nullptr});
+    targets.push_back({std::move(sink2_), std::move(filter_)});
+
+    blocking_t handler(std::move(formatter_), std::move(targets));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.severity());
+        }));
+
+    EXPECT_CALL(sink1, emit(_, string_view("1")))
+        .Times(1);
+    EXPECT_CALL(sink1, emit(_, string_view("4")))
+        .Times(1);
+    EXPECT_CALL(sink2, emit(_, string_view("4")))
+        .Times(1);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    handler.handle(record_t(1, message, pack));
+    handler.handle(record_t(4, message, pack));
+
+    EXPECT_EQ(2, filter.calls);
+}
+
+TEST(blocking_t, SkipsFormattingIfNoSinkAccepts) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink1_(new mock::sink_t);
+    std::unique_ptr<mock::sink_t> sink2_(new mock::sink_t);
+    mock::sink_t& sink1 = *sink1_;
+    mock::sink_t& sink2 = *sink2_;
+
+    std::vector<blocking_t::target_t> targets;
+    targets.push_back({std::move(sink1_), std::unique_ptr<filter_t>(new threshold_filter_t(3))});
+    targets.push_back({std::move(sink2_), std::unique_ptr<filter_t>(new threshold_filter_t(5))});
+
+    blocking_t handler(std::move(formatter_), std::move(targets));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(0);
+    EXPECT_CALL(sink1, emit(_, _))
+        .Times(0);
+    EXPECT_CALL(sink2, emit(_, _))
+        .Times(0);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    handler.handle(record_t(2, message, pack));
+}
+
+TEST(blocking_t, FactorySinkFilter) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    EXPECT_CALL(registry, formatter("string"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<formatter_t> {
+            std::unique_ptr<mock::formatter_t> formatter(new NiceMock<mock::formatter_t>);
+            return std::move(formatter);
+        }));
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([&](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::move(sink_);
+        }));
+
+    EXPECT_CALL(registry, filter("severity"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<filter_t> {
+            return std::unique_ptr<filter_t>(new threshold_filter_t(3));
+        }));
+
+    /// Creates a node with the "type" child of the given value.
+    auto typed = [](const std::string& type) -> NiceMock<node_t>* {
+        auto node = new NiceMock<node_t>;
+        EXPECT_CALL(*node, subscript_key("type"))
+            .WillRepeatedly(Invoke([=](const std::string&) {
+                auto ntype = new NiceMock<node_t>;
+                EXPECT_CALL(*ntype, to_string())
+                    .WillRepeatedly(Return(type));
+                return ntype;
+            }));
+        return node;
+    };
+
+    EXPECT_CALL(config, subscript_key("formatter"))
+        .WillRepeatedly(Invoke([&](const std::string&) {
+            return typed("string");
+        }));
+
+    auto nsinks = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("sinks"))
+        .WillOnce(Return(nsinks));
+    EXPECT_CALL(*nsinks, each(_))
+        .WillOnce(Invoke([&](const node_t::each_function& fn) {
+            auto nsink = typed("null");
+            EXPECT_CALL(*nsink, subscript_key("filter"))
+                .WillRepeatedly(Invoke([&](const std::string&) {
+                    return typed("severity");
+                }));
+
+            fn(*nsink);
+            delete nsink;
+        }));
+
+    auto handler = factory<blocking_t>(registry).from(config);
+
+    EXPECT_CALL(sink, emit(_, _))
+        .Times(1);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    handler->handle(record_t(2, message, pack));
+    handler->handle(record_t(4, message, pack));
+}
+
 }  // namespace
 }  // namespace handler
 }  // namespace v1
@@ -1,11 +1,31 @@
 #include <memory>
+#include <string>
+
+#include <blackhole/extensions/writer.hpp>
 
 #include <src/recordbuf.hpp>
 
 #include <gtest/gtest.h>
 
+namespace {
+
+struct endpoint_t {
+    std::string host;
+    std::uint16_t port;
+};
+
+}  // namespace
+
 namespace blackhole {
 inline namespace v1 {
+
+template<>
+struct display_traits<endpoint_t> {
+    static auto apply(const endpoint_t& endpoint, writer_t& wr) -> void {
+        wr.write("{}:{}", endpoint.host, endpoint.port);
+    }
+};
+
 namespace {
 
 TEST(recordbuf_t, FromRecordMessage) {
@@ -87,6 +107,35 @@ TEST(owned, FromRecordThreadId) {
     EXPECT_EQ(::pthread_self(), result->into_view().tid());
 }
 
+TEST(owned, FromRecordProcessAndThread) {
+    std::unique_ptr<recordbuf_t> result;
+    std::uint64_t pid = 0;
+    std::uint64_t lwp = 0;
+    std::string name;
+
+    {
+        const string_view message("");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+
+        pid = record.pid();
+        lwp = record.lwp();
+        if (record.thread_name()) {
+            name = record.thread_name();
+        }
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    recordbuf_t moved(std::move(*result));
+    const auto view = moved.into_view();
+
+    EXPECT_EQ(pid, view.pid());
+    EXPECT_EQ(lwp, view.lwp());
+    ASSERT_NE(nullptr, view.thread_name());
+    EXPECT_EQ(name, view.thread_name());
+}
+
 TEST(owned, FromRecordAttributes) {
     std::unique_ptr<recordbuf_t> result;
 
@@ -189,6 +238,129 @@ TEST(owned, MoveAssignmentWithDifferentSizes) {
     EXPECT_EQ(attributes, result->into_view().attributes().at(0).get());
 }
 
+TEST(recordbuf_t, Default) {
+    const recordbuf_t recordbuf;
+    const auto record = recordbuf.into_view();
+
+    EXPECT_EQ(string_view(""), record.message());
+    EXPECT_EQ(string_view(""), record.formatted());
+    ASSERT_EQ(1, record.attributes().size());
+    EXPECT_TRUE(record.attributes().at(0).get().empty());
+}
+
+TEST(recordbuf_t, FlattensAttributePack) {
+    std::unique_ptr<recordbuf_t> result;
+
+    {
+        const string_view message("GET");
+        const std::string value("value#2");
+        const attribute_list attributes1{{"key#1", "value#1"}, {"key#2", value}};
+        const attribute_list attributes2{{"key#3", 42}, {"key#4", 3.1415}, {"key#5", true}};
+        const attribute_pack pack{attributes1, attributes2};
+        const record_t record(0, message, pack);
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    const attribute_list expected{
+        {"key#1", "value#1"},
+        {"key#2", "value#2"},
+        {"key#3", 42},
+        {"key#4", 3.1415},
+        {"key#5", true},
+    };
+
+    ASSERT_EQ(1, result->into_view().attributes().size());
+    EXPECT_EQ(expected, result->into_view().attributes().at(0).get());
+}
+
+TEST(recordbuf_t, RendersLazyAttributes) {
+    std::unique_ptr<recordbuf_t> result;
+
+    {
+        const string_view message("GET");
+        const endpoint_t endpoint1{"127.0.0.1", 8080};
+        const endpoint_t endpoint2{"::1", 10053};
+        const attribute_list attributes{
+            {"endpoint#1", endpoint1},
+            {"key#1", "value#1"},
+            {"endpoint#2", endpoint2},
+        };
+        const attribute_pack pack{attributes};
+        const record_t record(0, message, pack);
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    recordbuf_t moved(std::move(*result));
+
+    const attribute_list expected{
+        {"endpoint#1", "127.0.0.1:8080"},
+        {"key#1", "value#1"},
+        {"endpoint#2", "::1:10053"},
+    };
+
+    ASSERT_EQ(1, moved.into_view().attributes().size());
+    EXPECT_EQ(expected, moved.into_view().attributes().at(0).get());
+}
+
+TEST(recordbuf_t, AssignReusesStorage) {
+    recordbuf_t recordbuf;
+
+    {
+        const string_view message("GET /porn.png HTTP/1.1");
+        const attribute_list attributes{{"key#1", "value#1"}};
+        const attribute_pack pack{attributes};
+        const record_t record(0, message, pack);
+
+        recordbuf.assign(record);
+    }
+
+    const auto data = recordbuf.into_view().message().data();
+
+    {
+        const string_view message("POST");
+        const attribute_list attributes{{"key#2", "value#2"}, {"key#3", 42}};
+        const attribute_pack pack{attributes};
+        const record_t record(10, message, pack);
+
+        recordbuf.assign(record);
+    }
+
+    EXPECT_EQ(data, recordbuf.into_view().message().data());
+    EXPECT_EQ(string_view("POST"), recordbuf.into_view().message());
+    EXPECT_EQ(10, recordbuf.into_view().severity());
+
+    const attribute_list attributes{{"key#2", "value#2"}, {"key#3", 42}};
+    ASSERT_EQ(1, recordbuf.into_view().attributes().size());
+    EXPECT_EQ(attributes, recordbuf.into_view().attributes().at(0).get());
+}
+
+TEST(recordbuf_t, AssignGrowsStorage) {
+    recordbuf_t recordbuf;
+
+    {
+        const string_view message("GET");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+
+        recordbuf.assign(record);
+    }
+
+    const std::string message(1024, 'x');
+
+    {
+        const string_view view(message);
+        const attribute_pack pack;
+        const record_t record(0, view, pack);
+
+        recordbuf.assign(record);
+    }
+
+    EXPECT_EQ(string_view(message), recordbuf.into_view().message());
+    EXPECT_TRUE(recordbuf.into_view().attributes().at(0).get().empty());
+}
+
 TEST(recordbuf_t, DefaultMove) {
     recordbuf_t recordbuf;
 
@@ -0,0 +1,152 @@
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/formatter/shared.hpp>
+
+#include "mocks/formatter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+/// Writes the record message, counting invocations.
+auto message(std::size_t& calls) -> std::function<void(const record_t&, writer_t&)> {
+    return [&](const record_t& record, writer_t& writer) {
+        ++calls;
+        writer.write("{}", record.message().to_string());
+    };
+}
+
+TEST(shared_t, FormatsOnceWithinDispatch) {
+    auto inner = std::make_shared<testing::mock::formatter_t>();
+    shared_t formatter1(inner);
+    shared_t formatter2(inner);
+
+    std::size_t calls = 0;
+    EXPECT_CALL(*inner, format(_, _))
+        .WillRepeatedly(Invoke(message(calls)));
+
+    const string_view message("value");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    writer_t writer1;
+    writer_t writer2;
+    {
+        const dispatch_t dispatch(record);
+        formatter1.format(record, writer1);
+        formatter2.format(record, writer2);
+    }
+
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ("value", writer1.inner.str());
+    EXPECT_EQ("value", writer2.inner.str());
+}
+
+TEST(shared_t, FormatsEachDispatchedRecord) {
+    auto inner = std::make_shared<testing::mock::formatter_t>();
+    shared_t formatter1(inner);
+    shared_t formatter2(inner);
+
+    std::size_t calls = 0;
+    EXPECT_CALL(*inner, format(_, _))
+        .WillRepeatedly(Invoke(message(calls)));
+
+    const attribute_pack pack;
+
+    for (std::string value : {"first", "second"}) {
+        const string_view message(value.data(), value.size());
+        record_t record(0, message, pack);
+
+        writer_t writer1;
+        writer_t writer2;
+
+        const dispatch_t dispatch(record);
+        formatter1.format(record, writer1);
+        formatter2.format(record, writer2);
+
+        EXPECT_EQ(value, writer1.inner.str());
+        EXPECT_EQ(value, writer2.inner.str());
+    }
+
+    EXPECT_EQ(2, calls);
+}
+
+TEST(shared_t, FormatsDirectlyOutsideDispatch) {
+    auto inner = std::make_shared<testing::mock::formatter_t>();
+    shared_t formatter1(inner);
+    shared_t formatter2(inner);
+
+    std::size_t calls = 0;
+    EXPECT_CALL(*inner, format(_, _))
+        .WillRepeatedly(Invoke(message(calls)));
+
+    const string_view message("value");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    writer_t writer1;
+    writer_t writer2;
+    formatter1.format(record, writer1);
+    formatter2.format(record, writer2);
+
+    EXPECT_EQ(2, calls);
+    EXPECT_EQ("value", writer2.inner.str());
+}
+
+TEST(shared_t, NestedDispatchCachesOwnRecord) {
+    auto inner = std::make_shared<testing::mock::formatter_t>();
+    shared_t formatter1(inner);
+    shared_t formatter2(inner);
+
+    std::size_t calls = 0;
+    EXPECT_CALL(*inner, format(_, _))
+        .WillRepeatedly(Invoke(message(calls)));
+
+    const attribute_pack pack;
+    const string_view outer_message("outer");
+    const string_view nested_message("nested");
+    record_t outer(0, outer_message, pack);
+    record_t nested(0, nested_message, pack);
+
+    writer_t writer1;
+    writer_t writer2;
+    writer_t writer3;
+    writer_t writer4;
+    {
+        const dispatch_t dispatch(outer);
+        formatter1.format(outer, writer1);
+        {
+            const dispatch_t dispatch(nested);
+            formatter1.format(nested, writer2);
+            formatter2.format(nested, writer3);
+        }
+        formatter2.format(outer, writer4);
+    }
+
+    // The nested record takes over the cached output, so the outer one is formatted again.
+    EXPECT_EQ(3, calls);
+    EXPECT_EQ("outer", writer1.inner.str());
+    EXPECT_EQ("nested", writer2.inner.str());
+    EXPECT_EQ("nested", writer3.inner.str());
+    EXPECT_EQ("outer", writer4.inner.str());
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -10,6 +10,7 @@
 #include <blackhole/formatter.hpp>
 #include <blackhole/formatter/string.hpp>
 #include <blackhole/record.hpp>
+#include <blackhole/thread.hpp>
 
 namespace {
 
@@ -427,25 +428,12 @@ TEST(string_t, ThreadExplicitlySpec) {
 }
 
 struct threadname_guard {
-    template<std::size_t N>
-    threadname_guard(const char(&name)[N]) {
-        #ifdef __linux__
-            ::pthread_setname_np(::pthread_self(), name);
-        #elif __APPLE__
-            ::pthread_setname_np(name);
-        #else
-        #error "Not implemented. Please write an implementation for your OS."
-        #endif
+    explicit threadname_guard(const char* name) {
+        ::blackhole::this_thread::set_name(name);
     }
 
     ~threadname_guard() {
-        #ifdef __linux__
-            ::pthread_setname_np(::pthread_self(), "");
-        #elif __APPLE__
-            ::pthread_setname_np("");
-        #else
-        #error "Not implemented. Please write an implementation for your OS."
-        #endif
+        ::blackhole::this_thread::set_name("");
     }
 };
 
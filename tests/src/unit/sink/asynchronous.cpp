@@ -1,3 +1,18 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <blackhole/attribute.hpp>
 #include <blackhole/registry.hpp>
 #include <blackhole/sink/asynchronous.hpp>
 
@@ -7,6 +22,7 @@
 #include <gtest/gtest.h>
 
 // TODO: Rename directory to just "mock" to be consistent with namespace.
+#include "mocks/node.hpp"
 #include "mocks/registry.hpp"
 #include "mocks/sink.hpp"
 
@@ -17,6 +33,8 @@ namespace {
 
 using ::testing::_;
 using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
 
 namespace mock = testing::mock;
 
@@ -40,6 +58,485 @@ TEST(asynchronous_t, DelegatesEmit) {
     sink.emit(record, "formatted message");
 }
 
+TEST(asynchronous_t, DelegatesEmitReusingSlots) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::vector<std::string> messages;
+    std::vector<std::string> values;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(100)
+        .WillRepeatedly(Invoke([&](const record_t& record, string_view message) {
+            messages.push_back(message.to_string());
+
+            ASSERT_EQ(1, record.attributes().size());
+            ASSERT_EQ(1, record.attributes().at(0).get().size());
+            const auto& value = record.attributes().at(0).get().at(0).second;
+            values.push_back(attribute::get<string_view>(value).to_string());
+        }));
+
+    {
+        asynchronous_t sink(std::move(wrapped), 2);
+
+        for (int i = 0; i < 100; ++i) {
+            const std::string value(static_cast<std::size_t>(i * 7 % 50), 'v');
+            const string_view message("unformatted message");
+            const attribute_list attributes{{"key", value}};
+            const attribute_pack pack({attributes});
+            record_t record(42, message, pack);
+
+            sink.emit(record, std::to_string(i));
+        }
+    }
+
+    ASSERT_EQ(100, messages.size());
+    ASSERT_EQ(100, values.size());
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(std::to_string(i), messages[static_cast<std::size_t>(i)]);
+        EXPECT_EQ(std::string(static_cast<std::size_t>(i * 7 % 50), 'v'),
+            values[static_cast<std::size_t>(i)]);
+    }
+}
+
+/// Records the size of each batch emitted, blocking until released.
+class batch_sink_t : public sink_t {
+public:
+    struct state_t {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool released = false;
+        std::vector<std::size_t> batches;
+        std::vector<std::string> messages;
+        std::size_t flushes = 0;
+
+        auto release() -> void {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                released = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    state_t& state;
+
+    explicit batch_sink_t(state_t& state) : state(state) {}
+
+    auto emit(const record_t&, const string_view&) -> void override {
+        FAIL() << "records must be emitted in batches";
+    }
+
+    auto emit_batch(const batch_t& batch) -> void override {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.cv.wait(lock, [&] { return state.released; });
+
+        state.batches.push_back(batch.size());
+        for (const auto& entry : batch) {
+            state.messages.push_back(entry.message.to_string());
+        }
+    }
+
+    auto flush() -> void override {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        ++state.flushes;
+    }
+};
+
+TEST(asynchronous_t, EmitsBatches) {
+    batch_sink_t::state_t state;
+
+    {
+        asynchronous_t sink(std::unique_ptr<sink_t>(new batch_sink_t(state)), 4);
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        sink.emit(record, "0");
+        // Let the consumer block while emitting the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        for (int i = 1; i < 10; ++i) {
+            sink.emit(record, std::to_string(i));
+        }
+
+        state.release();
+    }
+
+    ASSERT_EQ(10, state.messages.size());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(std::to_string(i), state.messages[static_cast<std::size_t>(i)]);
+    }
+
+    // Records enqueued while the consumer was busy are handed over at once.
+    ASSERT_EQ(2, state.batches.size());
+    EXPECT_EQ(1, state.batches[0]);
+    EXPECT_EQ(9, state.batches[1]);
+}
+
+TEST(asynchronous_t, SpillsOverflowingRecords) {
+    const auto path = "/tmp/blackhole-spill-" + std::to_string(::getpid());
+    std::remove(path.c_str());
+
+    batch_sink_t::state_t state;
+
+    {
+        asynchronous_t sink(std::unique_ptr<sink_t>(new batch_sink_t(state)),
+            asynchronous::queue_factory_t().create("shared", 2),
+            exception_policy_factory_t().create("ignore"),
+            overflow_policy_factory_t().spill(path, 64 * 1024),
+            underflow_policy_factory_t().create("park"));
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        sink.emit(record, "0");
+        // Let the consumer block while emitting the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        // Only four records fit in the queue, the rest must be spilled rather than dropped.
+        for (int i = 1; i < 20; ++i) {
+            sink.emit(record, std::to_string(i));
+        }
+
+        EXPECT_EQ(0, sink.dropped().total());
+
+        state.release();
+    }
+
+    std::remove(path.c_str());
+
+    ASSERT_EQ(20, state.messages.size());
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(std::to_string(i), state.messages[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_t, FlushWaitsForQueuedRecords) {
+    batch_sink_t::state_t state;
+    state.released = true;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new batch_sink_t(state)), 4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    for (int i = 0; i < 10; ++i) {
+        sink.emit(record, std::to_string(i));
+    }
+
+    ASSERT_TRUE(sink.flush(std::chrono::seconds(10)));
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    EXPECT_EQ(10, state.messages.size());
+    EXPECT_EQ(1, state.flushes);
+}
+
+TEST(asynchronous_t, FlushTimesOut) {
+    batch_sink_t::state_t state;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new batch_sink_t(state)), 4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    sink.emit(record, "0");
+
+    EXPECT_FALSE(sink.flush(std::chrono::milliseconds(10)));
+
+    state.release();
+    sink.flush();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    EXPECT_EQ(1, state.messages.size());
+    EXPECT_LE(1, state.flushes);
+}
+
+/// Emits ten numbered records while another thread keeps loading the sink, then checks that a flush
+/// completes once these records have been emitted rather than once the load stops.
+auto flush_under_load(std::unique_ptr<asynchronous::queue_t> queue,
+                      std::unique_ptr<overflow_policy_t> overflow_policy) -> void
+{
+    batch_sink_t::state_t state;
+    state.released = true;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new batch_sink_t(state)),
+        std::move(queue),
+        exception_policy_factory_t().create("ignore"),
+        std::move(overflow_policy),
+        underflow_policy_factory_t().create("park"));
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    std::atomic<bool> stop(false);
+    std::thread producer([&] {
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        while (!stop) {
+            sink.emit(record, "load");
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    for (int i = 0; i < 10; ++i) {
+        sink.emit(record, std::to_string(i));
+    }
+
+    const auto flushed = sink.flush(std::chrono::seconds(2));
+
+    std::vector<std::string> messages;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (const auto& message : state.messages) {
+            if (message != "load") {
+                messages.push_back(message);
+            }
+        }
+    }
+
+    stop = true;
+    producer.join();
+
+    // Spilled records may be emitted out of order with the queued ones.
+    std::sort(messages.begin(), messages.end());
+
+    EXPECT_TRUE(flushed);
+    ASSERT_EQ(10, messages.size());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(std::to_string(i), messages[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_t, FlushCompletesUnderLoad) {
+    flush_under_load(asynchronous::queue_factory_t().create("shared", 10),
+        overflow_policy_factory_t().create("wait"));
+}
+
+TEST(asynchronous_t, FlushCompletesUnderLoadSharded) {
+    flush_under_load(asynchronous::queue_factory_t().create("sharded", 10),
+        overflow_policy_factory_t().create("wait"));
+}
+
+TEST(asynchronous_t, FlushCompletesUnderLoadBytes) {
+    flush_under_load(asynchronous::queue_factory_t().bytes(64 * 1024),
+        overflow_policy_factory_t().create("wait"));
+}
+
+TEST(asynchronous_t, FlushCompletesUnderLoadSpilling) {
+    const auto path = "/tmp/blackhole-spill-load-" + std::to_string(::getpid());
+    std::remove(path.c_str());
+
+    flush_under_load(asynchronous::queue_factory_t().create("shared", 2),
+        overflow_policy_factory_t().spill(path, 64 * 1024 * 1024));
+
+    std::remove(path.c_str());
+}
+
+/// Emits each batch slowly, recording single records, which are synthetic reports.
+class slow_sink_t : public sink_t {
+public:
+    struct state_t {
+        std::mutex mutex;
+        std::size_t emitted = 0;
+        std::vector<std::string> reports;
+    };
+
+    state_t& state;
+
+    explicit slow_sink_t(state_t& state) : state(state) {}
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.reports.push_back(message.to_string());
+    }
+
+    auto emit_batch(const batch_t& batch) -> void override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.emitted += batch.size();
+    }
+};
+
+TEST(asynchronous_t, DeadlineAbandonsQueuedRecords) {
+    slow_sink_t::state_t state;
+
+    {
+        asynchronous_t sink(std::unique_ptr<sink_t>(new slow_sink_t(state)),
+            asynchronous::queue_factory_t().create("shared", 8),
+            exception_policy_factory_t().create("ignore"),
+            overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("park"),
+            std::chrono::milliseconds(1));
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        sink.emit(record, "0");
+        // Let the consumer block while emitting the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        for (int i = 1; i < 200; ++i) {
+            sink.emit(record, std::to_string(i));
+        }
+    }
+
+    // The batch being emitted when the deadline expires is still completed.
+    ASSERT_EQ(1, state.reports.size());
+    EXPECT_EQ("abandoned " + std::to_string(200 - state.emitted) + " records on shutdown",
+        state.reports[0]);
+    EXPECT_GT(200, state.emitted);
+}
+
+/// Throws on the given number of batches, then records messages.
+class throwing_sink_t : public sink_t {
+public:
+    struct state_t {
+        std::mutex mutex;
+        std::size_t failures = 0;
+        std::vector<std::string> messages;
+    };
+
+    state_t& state;
+
+    explicit throwing_sink_t(state_t& state) : state(state) {}
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.messages.push_back(message.to_string());
+    }
+
+    auto emit_batch(const batch_t& batch) -> void override {
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        if (state.failures > 0) {
+            --state.failures;
+            throw std::runtime_error("connection refused");
+        }
+
+        for (const auto& entry : batch) {
+            state.messages.push_back(entry.message.to_string());
+        }
+    }
+};
+
+TEST(asynchronous_t, IgnoresSinkExceptions) {
+    throwing_sink_t::state_t state;
+    state.failures = 1;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new throwing_sink_t(state)), 4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    sink.emit(record, "0");
+    ASSERT_TRUE(sink.flush(std::chrono::seconds(10)));
+
+    sink.emit(record, "1");
+    ASSERT_TRUE(sink.flush(std::chrono::seconds(10)));
+
+    EXPECT_EQ(1, sink.failed());
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    EXPECT_EQ(std::vector<std::string>{"1"}, state.messages);
+}
+
+TEST(asynchronous_t, RetriesFailedBatch) {
+    throwing_sink_t::state_t state;
+    state.failures = 2;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new throwing_sink_t(state)),
+        asynchronous::queue_factory_t().create("shared", 4),
+        exception_policy_factory_t().retry(3, std::chrono::milliseconds(1)),
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("park"));
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    sink.emit(record, "0");
+    ASSERT_TRUE(sink.flush(std::chrono::seconds(10)));
+
+    EXPECT_EQ(0, sink.failed());
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    EXPECT_EQ(std::vector<std::string>{"0"}, state.messages);
+}
+
+TEST(asynchronous_t, RetryGivesUpAfterAttempts) {
+    throwing_sink_t::state_t state;
+    state.failures = 2;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new throwing_sink_t(state)),
+        asynchronous::queue_factory_t().create("shared", 4),
+        exception_policy_factory_t().retry(2, std::chrono::milliseconds(1)),
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("park"));
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    sink.emit(record, "0");
+    ASSERT_TRUE(sink.flush(std::chrono::seconds(10)));
+
+    EXPECT_EQ(1, sink.failed());
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    EXPECT_TRUE(state.messages.empty());
+}
+
+TEST(asynchronous_t, DivertsFailedBatchToFallback) {
+    throwing_sink_t::state_t state;
+    state.failures = 1;
+
+    throwing_sink_t::state_t fallback;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new throwing_sink_t(state)),
+        asynchronous::queue_factory_t().create("shared", 4),
+        exception_policy_factory_t().fallback(std::make_shared<throwing_sink_t>(fallback)),
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("park"));
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    sink.emit(record, "0");
+    ASSERT_TRUE(sink.flush(std::chrono::seconds(10)));
+
+    EXPECT_EQ(0, sink.failed());
+
+    std::lock_guard<std::mutex> lock(fallback.mutex);
+    EXPECT_EQ(std::vector<std::string>{"0"}, fallback.messages);
+}
+
+TEST(exception_policy_factory_t, CreatesRegisteredPolicies) {
+    EXPECT_NO_THROW(exception_policy_factory_t().create("ignore"));
+    EXPECT_NO_THROW(exception_policy_factory_t().create("retry"));
+}
+
+TEST(exception_policy_factory_t, ThrowsIfRequestedNonRegisteredPolicy) {
+    EXPECT_THROW(exception_policy_factory_t().create("abort"), std::invalid_argument);
+}
+
+TEST(exception_policy_factory_t, ThrowsIfNoRetryAttempts) {
+    EXPECT_THROW(exception_policy_factory_t().retry(0, std::chrono::milliseconds(1)),
+        std::invalid_argument);
+}
+
 TEST(asynchronous_t, FactoryType) {
     mock_registry_t registry;
     factory<asynchronous_t> factory(registry);
@@ -47,11 +544,723 @@ TEST(asynchronous_t, FactoryType) {
     EXPECT_EQ(std::string("asynchronous"), factory.type());
 }
 
+TEST(asynchronous_t, WakesParkedConsumer) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int emitted = 0;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t&, string_view) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++emitted;
+            cv.notify_one();
+        }));
+
+    asynchronous_t sink(std::move(wrapped), 2, overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("park"));
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    for (int i = 1; i <= 2; ++i) {
+        sink.emit(record, "formatted message");
+
+        std::unique_lock<std::mutex> lock(mutex);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return emitted == i; }));
+        lock.unlock();
+
+        // Give the consumer enough time to park.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+TEST(asynchronous_t, BusyPolling) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(10);
+
+    auto sink = builder<asynchronous_t>(std::move(wrapped))
+        .spin()
+        .build();
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    for (int i = 0; i < 10; ++i) {
+        sink->emit(record, "formatted message");
+    }
+}
+
+TEST(asynchronous_t, WaitBlocksUntilSlotIsFreed) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+    std::vector<std::string> messages;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(16)
+        .WillRepeatedly(Invoke([&](const record_t&, string_view message) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return released; });
+            messages.push_back(message.to_string());
+        }));
+
+    {
+        asynchronous_t sink(std::move(wrapped), 2, overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("park"));
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        // The queue has only 4 slots and the consumer is stuck, so producers must block.
+        std::vector<std::thread> threads;
+        for (int id = 0; id < 4; ++id) {
+            threads.emplace_back([&, id] {
+                for (int i = 0; i < 4; ++i) {
+                    sink.emit(record, std::to_string(id * 4 + i));
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = true;
+        }
+        cv.notify_all();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    EXPECT_EQ(16, messages.size());
+}
+
+TEST(asynchronous_t, WaitDropsAfterTimeout) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+
+    // One record is being emitted, other four are queued, the rest must be dropped.
+    EXPECT_CALL(*wrapped, emit(_, string_view("formatted message")))
+        .Times(5)
+        .WillRepeatedly(Invoke([&](const record_t&, string_view) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return released; });
+        }));
+
+    EXPECT_CALL(*wrapped, emit(_, string_view("dropped 2 records (15+: 2)")))
+        .Times(1);
+
+    {
+        asynchronous_t sink(std::move(wrapped), 2,
+            overflow_policy_factory_t().wait(std::chrono::milliseconds(10)),
+            underflow_policy_factory_t().create("park"));
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        sink.emit(record, "formatted message");
+        // Let the consumer pick up the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        for (int i = 0; i < 6; ++i) {
+            sink.emit(record, "formatted message");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = true;
+        }
+        cv.notify_all();
+    }
+}
+
+TEST(asynchronous_t, ReportsDroppedRecords) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+
+    std::vector<std::string> messages;
+    std::vector<severity_t> severities;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, string_view message) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return released; });
+
+            EXPECT_EQ(message, record.formatted());
+            messages.push_back(message.to_string());
+            severities.push_back(record.severity());
+        }));
+
+    {
+        asynchronous_t sink(std::move(wrapped), 2,
+            overflow_policy_factory_t().create("drop"),
+            underflow_policy_factory_t().create("park"));
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+
+        record_t record(0, message, pack);
+        record.activate(message);
+        sink.emit(record, message);
+        // Let the consumer pick up the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        for (int i = 0; i < 4; ++i) {
+            sink.emit(record, message);
+        }
+
+        for (severity_t severity : {1, 3, 1}) {
+            record_t record(severity, message, pack);
+            sink.emit(record, message);
+        }
+
+        const auto dropped = sink.dropped();
+        EXPECT_EQ(3, dropped.total());
+        EXPECT_EQ(0, dropped.at(0));
+        EXPECT_EQ(2, dropped.at(1));
+        EXPECT_EQ(1, dropped.at(3));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = true;
+        }
+        cv.notify_all();
+    }
+
+    ASSERT_EQ(6, messages.size());
+    EXPECT_EQ("dropped 3 records (1: 2, 3: 1)", messages.back());
+    EXPECT_EQ(3, severities.back());
+}
+
+TEST(asynchronous_t, BuilderExposesDropCounters) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t&, string_view) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return released; });
+        }));
+
+    // Only the public interface is used here.
+    std::unique_ptr<asynchronous::handle_t> sink = builder<asynchronous_t>(std::move(wrapped))
+        .factor(2)
+        .drop()
+        .build();
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+
+    record_t record(2, message, pack);
+    record.activate(message);
+    sink->emit(record, message);
+    // Let the consumer pick up the first record.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    for (int i = 0; i < 6; ++i) {
+        sink->emit(record, message);
+    }
+
+    const auto dropped = sink->dropped();
+    EXPECT_EQ(2, dropped.total());
+    EXPECT_EQ(2, dropped.at(2));
+    EXPECT_EQ(0, sink->failed());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    cv.notify_all();
+}
+
+TEST(asynchronous_t, WatermarkShedsLowSeverityRecords) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+
+    std::vector<severity_t> severities;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, string_view) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return released; });
+
+            severities.push_back(record.severity());
+        }));
+
+    {
+        asynchronous_t sink(std::move(wrapped), 2,
+            overflow_policy_factory_t().watermark({{0, 50}, {2, 100}}, 3),
+            underflow_policy_factory_t().create("park"));
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+
+        record_t record(2, message, pack);
+        sink.emit(record, message);
+        // Let the consumer pick up the first record.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        // Records with severity 0 and 1 take no more than half of the queue.
+        for (severity_t severity : {0, 1, 0}) {
+            record_t record(severity, message, pack);
+            sink.emit(record, message);
+        }
+
+        // Records with severity 2 may fill it up, but are dropped after that.
+        for (severity_t severity : {2, 2, 2}) {
+            record_t record(severity, message, pack);
+            sink.emit(record, message);
+        }
+
+        const auto dropped = sink.dropped();
+        EXPECT_EQ(2, dropped.total());
+        EXPECT_EQ(1, dropped.at(0));
+        EXPECT_EQ(1, dropped.at(2));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = true;
+        }
+        cv.notify_all();
+    }
+
+    // The last one is the drop report.
+    EXPECT_EQ((std::vector<severity_t>{2, 0, 1, 2, 2, 2}), severities);
+}
+
+TEST(overflow_policy_factory_t, ThrowsIfWatermarkLevelIsOutOfRange) {
+    EXPECT_THROW(overflow_policy_factory_t().watermark({{0, 101}}, 0), std::invalid_argument);
+}
+
+TEST(asynchronous_t, FactoryOverflowPolicyFromObject) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::unique_ptr<sink_t>(new mock::sink_t);
+        }));
+
+    EXPECT_CALL(config, subscript_key("sink"))
+        .WillRepeatedly(Invoke([](const std::string&) {
+            auto nsink = new NiceMock<node_t>;
+            EXPECT_CALL(*nsink, subscript_key("type"))
+                .WillRepeatedly(Invoke([](const std::string&) {
+                    auto ntype = new NiceMock<node_t>;
+                    EXPECT_CALL(*ntype, to_string())
+                        .WillRepeatedly(Return("null"));
+                    return ntype;
+                }));
+            return nsink;
+        }));
+
+    auto nfactor = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("factor"))
+        .WillOnce(Return(nfactor));
+    EXPECT_CALL(*nfactor, to_uint64())
+        .WillOnce(Return(4));
+
+    EXPECT_CALL(config, subscript_key("workers"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("key"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("deadline"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("thread"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("exception"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("queue"))
+        .WillOnce(Return(nullptr));
+
+    auto noverflow = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("overflow"))
+        .WillOnce(Return(noverflow));
+    EXPECT_CALL(*noverflow, is_object_())
+        .WillRepeatedly(Return(true));
+
+    auto ntype = new NiceMock<node_t>;
+    EXPECT_CALL(*noverflow, subscript_key("type"))
+        .WillOnce(Return(ntype));
+    EXPECT_CALL(*ntype, to_string())
+        .WillOnce(Return("wait"));
+
+    auto ntimeout = new NiceMock<node_t>;
+    EXPECT_CALL(*noverflow, subscript_key("timeout"))
+        .WillOnce(Return(ntimeout));
+    EXPECT_CALL(*ntimeout, to_uint64())
+        .WillOnce(Return(100));
+
+    EXPECT_CALL(config, subscript_key("underflow"))
+        .WillOnce(Return(nullptr));
+
+    auto sink = factory<asynchronous_t>(registry).from(config);
+
+    EXPECT_EQ(16, dynamic_cast<asynchronous_t&>(*sink).capacity());
+}
+
+TEST(asynchronous_t, FactoryWatermarkOverflowPolicy) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::unique_ptr<sink_t>(new mock::sink_t);
+        }));
+
+    EXPECT_CALL(config, subscript_key("sink"))
+        .WillRepeatedly(Invoke([](const std::string&) {
+            auto nsink = new NiceMock<node_t>;
+            EXPECT_CALL(*nsink, subscript_key("type"))
+                .WillRepeatedly(Invoke([](const std::string&) {
+                    auto ntype = new NiceMock<node_t>;
+                    EXPECT_CALL(*ntype, to_string())
+                        .WillRepeatedly(Return("null"));
+                    return ntype;
+                }));
+            return nsink;
+        }));
+
+    auto nfactor = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("factor"))
+        .WillOnce(Return(nfactor));
+    EXPECT_CALL(*nfactor, to_uint64())
+        .WillOnce(Return(4));
+
+    EXPECT_CALL(config, subscript_key("workers"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("key"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("deadline"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("thread"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("exception"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("queue"))
+        .WillOnce(Return(nullptr));
+
+    auto noverflow = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("overflow"))
+        .WillOnce(Return(noverflow));
+    EXPECT_CALL(*noverflow, is_object_())
+        .WillRepeatedly(Return(true));
+
+    auto ntype = new NiceMock<node_t>;
+    EXPECT_CALL(*noverflow, subscript_key("type"))
+        .WillOnce(Return(ntype));
+    EXPECT_CALL(*ntype, to_string())
+        .WillOnce(Return("watermark"));
+
+    auto nwatermarks = new NiceMock<node_t>;
+    EXPECT_CALL(*noverflow, subscript_key("watermarks"))
+        .WillOnce(Return(nwatermarks));
+    EXPECT_CALL(*nwatermarks, each(_))
+        .WillOnce(Invoke([](const node_t::each_function& fn) {
+            NiceMock<node_t> nwatermark;
+
+            EXPECT_CALL(nwatermark, subscript_key("severity"))
+                .WillOnce(Invoke([](const std::string&) {
+                    auto nseverity = new NiceMock<node_t>;
+                    EXPECT_CALL(*nseverity, to_sint64())
+                        .WillOnce(Return(0));
+                    return nseverity;
+                }));
+            EXPECT_CALL(nwatermark, subscript_key("level"))
+                .WillOnce(Invoke([](const std::string&) {
+                    auto nlevel = new NiceMock<node_t>;
+                    EXPECT_CALL(*nlevel, to_uint64())
+                        .WillOnce(Return(50));
+                    return nlevel;
+                }));
+
+            fn(nwatermark);
+        }));
+
+    auto nblock = new NiceMock<node_t>;
+    EXPECT_CALL(*noverflow, subscript_key("block"))
+        .WillOnce(Return(nblock));
+    EXPECT_CALL(*nblock, to_sint64())
+        .WillOnce(Return(3));
+
+    EXPECT_CALL(config, subscript_key("underflow"))
+        .WillOnce(Return(nullptr));
+
+    auto sink = factory<asynchronous_t>(registry).from(config);
+
+    EXPECT_EQ(16, dynamic_cast<asynchronous_t&>(*sink).capacity());
+}
+
+TEST(asynchronous_t, FactoryThrowsIfOverflowObjectHasNoType) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::unique_ptr<sink_t>(new mock::sink_t);
+        }));
+
+    EXPECT_CALL(config, subscript_key("sink"))
+        .WillRepeatedly(Invoke([](const std::string&) {
+            auto nsink = new NiceMock<node_t>;
+            EXPECT_CALL(*nsink, subscript_key("type"))
+                .WillRepeatedly(Invoke([](const std::string&) {
+                    auto ntype = new NiceMock<node_t>;
+                    EXPECT_CALL(*ntype, to_string())
+                        .WillRepeatedly(Return("null"));
+                    return ntype;
+                }));
+            return nsink;
+        }));
+
+    auto nfactor = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("factor"))
+        .WillOnce(Return(nfactor));
+    EXPECT_CALL(*nfactor, to_uint64())
+        .WillOnce(Return(4));
+
+    EXPECT_CALL(config, subscript_key("workers"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("key"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("deadline"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("thread"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("exception"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("queue"))
+        .WillOnce(Return(nullptr));
+
+    auto noverflow = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("overflow"))
+        .WillOnce(Return(noverflow));
+    EXPECT_CALL(*noverflow, is_object_())
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*noverflow, subscript_key("type"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<asynchronous_t>(registry).from(config), std::invalid_argument);
+}
+
+TEST(asynchronous_t, FactoryShardedQueueFromObject) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::unique_ptr<sink_t>(new mock::sink_t);
+        }));
+
+    EXPECT_CALL(config, subscript_key("sink"))
+        .WillRepeatedly(Invoke([](const std::string&) {
+            auto nsink = new NiceMock<node_t>;
+            EXPECT_CALL(*nsink, subscript_key("type"))
+                .WillRepeatedly(Invoke([](const std::string&) {
+                    auto ntype = new NiceMock<node_t>;
+                    EXPECT_CALL(*ntype, to_string())
+                        .WillRepeatedly(Return("null"));
+                    return ntype;
+                }));
+            return nsink;
+        }));
+
+    auto nfactor = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("factor"))
+        .WillOnce(Return(nfactor));
+    EXPECT_CALL(*nfactor, to_uint64())
+        .WillOnce(Return(4));
+
+    auto nqueue = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("workers"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("key"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("deadline"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("thread"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("exception"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("queue"))
+        .WillOnce(Return(nqueue));
+    EXPECT_CALL(*nqueue, is_object_())
+        .WillRepeatedly(Return(true));
+
+    auto ntype = new NiceMock<node_t>;
+    EXPECT_CALL(*nqueue, subscript_key("type"))
+        .WillOnce(Return(ntype));
+    EXPECT_CALL(*ntype, to_string())
+        .WillOnce(Return("sharded"));
+
+    auto nmerge = new NiceMock<node_t>;
+    EXPECT_CALL(*nqueue, subscript_key("merge"))
+        .WillOnce(Return(nmerge));
+    EXPECT_CALL(*nmerge, to_string())
+        .WillOnce(Return("relaxed"));
+
+    auto noverflow = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("overflow"))
+        .WillOnce(Return(noverflow));
+    EXPECT_CALL(*noverflow, to_string())
+        .WillOnce(Return("drop"));
+
+    EXPECT_CALL(config, subscript_key("underflow"))
+        .WillOnce(Return(nullptr));
+
+    auto sink = factory<asynchronous_t>(registry).from(config);
+
+    EXPECT_EQ(16, dynamic_cast<asynchronous_t&>(*sink).capacity());
+}
+
+TEST(asynchronous_t, FactoryFallbackExceptionPolicy) {
+    using config::testing::mock::node_t;
+
+    mock_registry_t registry;
+    NiceMock<node_t> config;
+
+    EXPECT_CALL(registry, sink("null"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::unique_ptr<sink_t>(new mock::sink_t);
+        }));
+
+    EXPECT_CALL(registry, sink("console"))
+        .WillOnce(Return([](const config::node_t&) -> std::unique_ptr<sink_t> {
+            return std::unique_ptr<sink_t>(new mock::sink_t);
+        }));
+
+    EXPECT_CALL(config, subscript_key("sink"))
+        .WillRepeatedly(Invoke([](const std::string&) {
+            auto nsink = new NiceMock<node_t>;
+            EXPECT_CALL(*nsink, subscript_key("type"))
+                .WillRepeatedly(Invoke([](const std::string&) {
+                    auto ntype = new NiceMock<node_t>;
+                    EXPECT_CALL(*ntype, to_string())
+                        .WillRepeatedly(Return("null"));
+                    return ntype;
+                }));
+            return nsink;
+        }));
+
+    auto nfactor = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("factor"))
+        .WillOnce(Return(nfactor));
+    EXPECT_CALL(*nfactor, to_uint64())
+        .WillOnce(Return(4));
+
+    EXPECT_CALL(config, subscript_key("workers"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("key"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("deadline"))
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("thread"))
+        .WillOnce(Return(nullptr));
+
+    auto nexception = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("exception"))
+        .WillOnce(Return(nexception));
+    EXPECT_CALL(*nexception, is_object_())
+        .WillRepeatedly(Return(true));
+
+    auto ntype = new NiceMock<node_t>;
+    EXPECT_CALL(*nexception, subscript_key("type"))
+        .WillOnce(Return(ntype));
+    EXPECT_CALL(*ntype, to_string())
+        .WillOnce(Return("fallback"));
+
+    EXPECT_CALL(*nexception, subscript_key("sink"))
+        .WillRepeatedly(Invoke([](const std::string&) {
+            auto nsink = new NiceMock<node_t>;
+            EXPECT_CALL(*nsink, subscript_key("type"))
+                .WillRepeatedly(Invoke([](const std::string&) {
+                    auto ntype = new NiceMock<node_t>;
+                    EXPECT_CALL(*ntype, to_string())
+                        .WillRepeatedly(Return("console"));
+                    return ntype;
+                }));
+            return nsink;
+        }));
+
+    EXPECT_CALL(config, subscript_key("queue"))
+        .WillOnce(Return(nullptr));
+
+    auto noverflow = new NiceMock<node_t>;
+    EXPECT_CALL(config, subscript_key("overflow"))
+        .WillOnce(Return(noverflow));
+    EXPECT_CALL(*noverflow, to_string())
+        .WillOnce(Return("drop"));
+
+    EXPECT_CALL(config, subscript_key("underflow"))
+        .WillOnce(Return(nullptr));
+
+    EXPECT_NO_THROW(factory<asynchronous_t>(registry).from(config));
+}
+
+TEST(underflow_policy_factory_t, CreatesRegisteredPolicies) {
+    EXPECT_NO_THROW(underflow_policy_factory_t().create("park"));
+    EXPECT_NO_THROW(underflow_policy_factory_t().create("spin"));
+}
+
+TEST(underflow_policy_factory_t, ThrowsIfRequestedNonRegisteredPolicy) {
+    EXPECT_THROW(underflow_policy_factory_t().create("sleep"), std::invalid_argument);
+}
+
 TEST(overflow_policy_factory_t, CreatesRegisteredPolicies) {
     EXPECT_NO_THROW(overflow_policy_factory_t().create("drop"));
     EXPECT_NO_THROW(overflow_policy_factory_t().create("wait"));
 }
 
+TEST(overflow_policy_factory_t, ThrowsIfSpillHasNoPath) {
+    EXPECT_THROW(overflow_policy_factory_t().create("spill"), std::invalid_argument);
+}
+
 TEST(overflow_policy_factory_t, ThrowsIfRequestedNonRegisteredPolicy) {
     EXPECT_THROW(overflow_policy_factory_t().create(""), std::invalid_argument);
 }
@@ -117,6 +1326,144 @@ TEST(asynchronous_t, BuilderSetWaitOverflowPolicyFlow) {
         .build();
 }
 
+TEST(asynchronous_t, BuilderSetRetryExceptionPolicyFlow) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    builder<asynchronous_t>(std::move(wrapped))
+        .retry(5, std::chrono::milliseconds(10))
+        .build();
+}
+
+TEST(asynchronous_t, BuilderThrowsIfNoRetryAttempts) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    EXPECT_THROW(builder<asynchronous_t>(std::move(wrapped))
+        .retry(0, std::chrono::milliseconds(10)), std::invalid_argument);
+}
+
+TEST(asynchronous_t, BuilderSetFallbackExceptionPolicyFlow) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    builder<asynchronous_t>(std::move(wrapped))
+        .fallback(std::unique_ptr<sink_t>(new mock::sink_t))
+        .build();
+}
+
+TEST(asynchronous_t, BuilderSetByteQueue) {
+    batch_sink_t::state_t state;
+    state.released = true;
+
+    auto sink = builder<asynchronous_t>(std::unique_ptr<sink_t>(new batch_sink_t(state)))
+        .bytes(64 * 1024)
+        .build();
+
+    auto& asynchronous = dynamic_cast<asynchronous_t&>(*sink);
+    EXPECT_EQ(64 * 1024, asynchronous.capacity());
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    for (int i = 0; i < 10; ++i) {
+        sink->emit(record, std::to_string(i));
+    }
+
+    ASSERT_TRUE(asynchronous.flush(std::chrono::seconds(10)));
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    ASSERT_EQ(10, state.messages.size());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(std::to_string(i), state.messages[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_t, Sharded) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::vector<std::string> messages;
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(400)
+        .WillRepeatedly(Invoke([&](const record_t&, string_view message) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(message.to_string());
+        }));
+
+    {
+        auto sink = builder<asynchronous_t>(std::move(wrapped))
+            .factor(4)
+            .sharded(merge_t::relaxed)
+            .build();
+
+        EXPECT_EQ(16, dynamic_cast<asynchronous_t&>(*sink).capacity());
+
+        const string_view message("unformatted message");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        std::vector<std::thread> threads;
+        for (int id = 0; id < 4; ++id) {
+            threads.emplace_back([&, id] {
+                for (int i = 0; i < 100; ++i) {
+                    sink->emit(record, std::to_string(id) + ":" + std::to_string(i));
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    ASSERT_EQ(400, messages.size());
+
+    // Records from the same thread must keep their order.
+    std::vector<int> last(4, -1);
+    for (const auto& message : messages) {
+        const auto id = std::stoi(message.substr(0, message.find(':')));
+        const auto i = std::stoi(message.substr(message.find(':') + 1));
+
+        EXPECT_EQ(last[static_cast<std::size_t>(id)] + 1, i);
+        last[static_cast<std::size_t>(id)] = i;
+    }
+}
+
+TEST(asynchronous_t, BuilderSetWaitOverflowPolicyWithTimeoutFlow) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    builder<asynchronous_t>(std::move(wrapped))
+        .wait(std::chrono::milliseconds(100))
+        .build();
+}
+
+TEST(asynchronous_t, BuilderSetThreadOptionsFlow) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    builder<asynchronous_t>(std::move(wrapped))
+        .name("blackhole")
+        .scheduler(scheduler_t::other)
+        .group("builder")
+        .build();
+}
+
+TEST(asynchronous_t, BuilderThrowsIfGroupedSinkRetries) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    EXPECT_THROW(builder<asynchronous_t>(std::move(wrapped))
+        .retry(3, std::chrono::milliseconds(10))
+        .group("builder")
+        .build(), std::invalid_argument);
+}
+
+TEST(asynchronous_t, BuilderThrowsIfThreadNameIsTooLong) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    EXPECT_THROW(builder<asynchronous_t>(std::move(wrapped))
+        .name("blackhole-asynchronous")
+        .build(), std::invalid_argument);
+}
+
 }  // namespace
 }  // namespace sink
 }  // namespace v1
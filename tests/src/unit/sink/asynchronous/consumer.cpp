@@ -0,0 +1,232 @@
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(__linux__)
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/asynchronous.hpp>
+
+#include <src/sink/asynchronous.hpp>
+#include <src/sink/asynchronous/consumer.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Placement of the thread records were emitted on.
+struct state_t {
+    std::mutex mutex;
+    std::size_t count = 0;
+    std::thread::id id;
+    std::string name;
+    std::vector<std::size_t> affinity;
+    int nice = 0;
+};
+
+/// Captures the placement of the calling thread on each record.
+class probe_sink_t : public sink_t {
+public:
+    state_t& state;
+
+    explicit probe_sink_t(state_t& state) : state(state) {}
+
+    auto emit(const record_t&, const string_view&) -> void override {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        ++state.count;
+        state.id = std::this_thread::get_id();
+
+        char name[16] = {};
+        ::pthread_getname_np(::pthread_self(), name, sizeof(name));
+        state.name = name;
+
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        ::pthread_getaffinity_np(::pthread_self(), sizeof(set), &set);
+
+        state.affinity.clear();
+        for (std::size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                state.affinity.push_back(cpu);
+            }
+        }
+
+        state.nice = ::getpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)));
+#endif
+    }
+};
+
+auto park() -> std::unique_ptr<underflow_policy_t> {
+    return underflow_policy_factory_t().create("park");
+}
+
+auto make(state_t& state, std::shared_ptr<consumer_t> consumer) -> std::unique_ptr<asynchronous_t> {
+    return std::unique_ptr<asynchronous_t>(new asynchronous_t(
+        std::unique_ptr<sink_t>(new probe_sink_t(state)),
+        queue_factory_t().create("shared", 4),
+        exception_policy_factory_t().create("ignore"),
+        overflow_policy_factory_t().create("wait"),
+        std::move(consumer)));
+}
+
+auto emit(sink_t& sink, std::size_t count) -> void {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        sink.emit(record, message);
+    }
+}
+
+TEST(consumer_t, ThrowsIfNameIsTooLong) {
+    thread_options_t options;
+    options.name = "sixteen-chars-xx";
+
+    EXPECT_THROW(consumer_t(options, park()), std::invalid_argument);
+}
+
+TEST(consumer_t, ThrowsIfOptionsCanNotBeApplied) {
+    thread_options_t options;
+    options.scheduler = scheduler_t::fifo;
+    options.priority = 1000;
+
+    EXPECT_THROW(consumer_t(options, park()), std::system_error);
+}
+
+TEST(consumer_t, AppliesName) {
+    thread_options_t options;
+    options.name = "blackhole-test";
+
+    state_t state;
+    {
+        auto sink = make(state, std::make_shared<consumer_t>(options, park()));
+        emit(*sink, 1);
+    }
+
+    EXPECT_EQ("blackhole-test", state.name);
+}
+
+#if defined(__linux__)
+
+TEST(consumer_t, AppliesAffinity) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    ASSERT_EQ(0, ::sched_getaffinity(0, sizeof(set), &set));
+
+    // The last processor this process is allowed to run on.
+    std::size_t cpu = 0;
+    for (std::size_t i = 0; i < CPU_SETSIZE; ++i) {
+        if (CPU_ISSET(i, &set)) {
+            cpu = i;
+        }
+    }
+
+    thread_options_t options;
+    options.affinity = {cpu};
+
+    state_t state;
+    {
+        auto sink = make(state, std::make_shared<consumer_t>(options, park()));
+        emit(*sink, 1);
+    }
+
+    EXPECT_EQ(std::vector<std::size_t>{cpu}, state.affinity);
+}
+
+TEST(consumer_t, AppliesNice) {
+    thread_options_t options;
+    options.nice = 19;
+
+    state_t state;
+    {
+        auto sink = make(state, std::make_shared<consumer_t>(options, park()));
+        emit(*sink, 1);
+    }
+
+    EXPECT_EQ(19, state.nice);
+    // Other threads are not affected.
+    EXPECT_NE(19, ::getpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid))));
+}
+
+#endif
+
+TEST(consumer_t, SharedBySinks) {
+    auto consumer = std::make_shared<consumer_t>(thread_options_t(), park());
+
+    state_t state1;
+    state_t state2;
+    {
+        auto sink1 = make(state1, consumer);
+        auto sink2 = make(state2, consumer);
+
+        emit(*sink1, 100);
+        emit(*sink2, 100);
+
+        ASSERT_TRUE(sink1->flush(std::chrono::seconds(10)));
+        ASSERT_TRUE(sink2->flush(std::chrono::seconds(10)));
+    }
+
+    EXPECT_EQ(100, state1.count);
+    EXPECT_EQ(100, state2.count);
+    EXPECT_EQ(state1.id, state2.id);
+}
+
+TEST(consumer_t, KeepsConsumingAfterSinkDestroyed) {
+    auto consumer = std::make_shared<consumer_t>(thread_options_t(), park());
+
+    state_t state1;
+    state_t state2;
+
+    auto sink2 = make(state2, consumer);
+    {
+        auto sink1 = make(state1, consumer);
+        emit(*sink1, 100);
+    }
+
+    emit(*sink2, 100);
+    ASSERT_TRUE(sink2->flush(std::chrono::seconds(10)));
+
+    EXPECT_EQ(100, state1.count);
+    EXPECT_EQ(100, state2.count);
+}
+
+TEST(shared_consumer, SameForSameGroup) {
+    auto consumer1 = shared_consumer("test", thread_options_t(), &park);
+    auto consumer2 = shared_consumer("test", thread_options_t(), &park);
+    auto consumer3 = shared_consumer("other", thread_options_t(), &park);
+
+    EXPECT_EQ(consumer1, consumer2);
+    EXPECT_NE(consumer1, consumer3);
+}
+
+TEST(shared_consumer, RestartsOnceReleased) {
+    std::weak_ptr<consumer_t> released = shared_consumer("test", thread_options_t(), &park);
+
+    EXPECT_TRUE(released.expired());
+    EXPECT_NE(nullptr, shared_consumer("test", thread_options_t(), &park));
+}
+
+}  // namespace
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,88 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <src/sink/asynchronous/drops.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+TEST(drop_counter_t, Empty) {
+    drop_counter_t counter;
+
+    EXPECT_FALSE(counter.reset());
+    EXPECT_EQ(0, counter.snapshot().total());
+}
+
+TEST(drop_counter_t, CountsBySeverity) {
+    drop_counter_t counter;
+
+    counter.add(0);
+    counter.add(2);
+    counter.add(2);
+
+    EXPECT_TRUE(counter.reset());
+    EXPECT_FALSE(counter.reset());
+
+    const auto snapshot = counter.snapshot();
+    EXPECT_EQ(3, snapshot.total());
+    EXPECT_EQ(1, snapshot.at(0));
+    EXPECT_EQ(0, snapshot.at(1));
+    EXPECT_EQ(2, snapshot.at(2));
+}
+
+TEST(drop_counter_t, ClampsSeverity) {
+    drop_counter_t counter;
+
+    counter.add(-1);
+    counter.add(100);
+
+    const auto snapshot = counter.snapshot();
+    EXPECT_EQ(1, snapshot.at(0));
+    EXPECT_EQ(1, snapshot.at(drops_t::severities - 1));
+    EXPECT_EQ(1, snapshot.at(1000));
+}
+
+TEST(drop_counter_t, SumsAllThreads) {
+    drop_counter_t counter;
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 20; ++id) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                counter.add(1);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(20000, counter.snapshot().at(1));
+}
+
+TEST(drops_t, Since) {
+    drop_counter_t counter;
+
+    counter.add(1);
+    const auto before = counter.snapshot();
+
+    counter.add(1);
+    counter.add(3);
+    const auto delta = counter.snapshot().since(before);
+
+    EXPECT_EQ(2, delta.total());
+    EXPECT_EQ(1, delta.at(1));
+    EXPECT_EQ(1, delta.at(3));
+}
+
+}  // namespace
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
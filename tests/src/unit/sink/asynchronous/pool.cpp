@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/asynchronous.hpp>
+
+#include <src/sink/asynchronous.hpp>
+#include <src/sink/asynchronous/pool.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Sequence numbers of emitted records by their key attribute.
+struct state_t {
+    std::mutex mutex;
+    std::map<std::int64_t, std::vector<std::int64_t>> records;
+};
+
+/// Records emitted records into the state, which outlives the sink.
+class recording_sink_t : public sink_t {
+public:
+    state_t& state;
+
+    explicit recording_sink_t(state_t& state) : state(state) {}
+
+    auto emit(const record_t& record, const string_view&) -> void override {
+        std::int64_t key = -1;
+        std::int64_t id = -1;
+
+        for (const auto& attribute : record.attributes().at(0).get()) {
+            if (attribute.first == "key") {
+                key = attribute::get<std::int64_t>(attribute.second);
+            } else if (attribute.first == "id") {
+                id = attribute::get<std::int64_t>(attribute.second);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.records[key].push_back(id);
+    }
+};
+
+auto worker(std::unique_ptr<sink_t> wrapped, std::size_t) -> std::unique_ptr<asynchronous_t> {
+    return std::unique_ptr<asynchronous_t>(new asynchronous_t(std::move(wrapped), 4));
+}
+
+TEST(thread_key_t, SameForSameThread) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record1(0, message, pack);
+    record_t record2(0, message, pack);
+
+    thread_key_t key;
+    EXPECT_EQ(key.hash(record1), key.hash(record2));
+}
+
+TEST(attribute_key_t, HashesAttributeValue) {
+    const string_view message("-");
+
+    const attribute_list attributes1{{"key", "value"}, {"id", 1}};
+    const attribute_list attributes2{{"id", 2}, {"key", "value"}};
+    const attribute_list attributes3{{"id", 3}};
+    const attribute_pack pack1{attributes1};
+    const attribute_pack pack2{attributes2};
+    const attribute_pack pack3{attributes3};
+
+    record_t record1(0, message, pack1);
+    record_t record2(0, message, pack2);
+    record_t record3(0, message, pack3);
+
+    attribute_key_t key("key");
+    EXPECT_EQ(key.hash(record1), key.hash(record2));
+    EXPECT_EQ(0, key.hash(record3));
+}
+
+TEST(pool_t, ThrowsIfNoWorkers) {
+    state_t state;
+    std::unique_ptr<sink_t> wrapped(new recording_sink_t(state));
+    std::unique_ptr<key_t> key(new thread_key_t);
+
+    EXPECT_THROW(pool_t(std::move(wrapped), std::move(key), 0, &worker), std::invalid_argument);
+}
+
+TEST(pool_t, KeepsOrderPerKey) {
+    state_t state;
+
+    {
+        std::unique_ptr<sink_t> wrapped(new recording_sink_t(state));
+        std::unique_ptr<key_t> key(new attribute_key_t("key"));
+        pool_t pool(std::move(wrapped), std::move(key), 4, &worker);
+
+        EXPECT_EQ(4, pool.size());
+
+        const string_view message("-");
+
+        for (std::int64_t id = 0; id < 100; ++id) {
+            for (std::int64_t key = 0; key < 8; ++key) {
+                const attribute_list attributes{{"key", key}, {"id", id}};
+                const attribute_pack pack{attributes};
+                record_t record(0, message, pack);
+
+                pool.emit(record, message);
+            }
+        }
+    }
+
+    ASSERT_EQ(8, state.records.size());
+
+    for (const auto& records : state.records) {
+        ASSERT_EQ(100, records.second.size());
+
+        for (std::int64_t id = 0; id < 100; ++id) {
+            EXPECT_EQ(id, records.second[id]);
+        }
+    }
+}
+
+TEST(pool_t, FlushWaitsForAllWorkers) {
+    state_t state;
+
+    std::unique_ptr<sink_t> wrapped(new recording_sink_t(state));
+    std::unique_ptr<key_t> key(new attribute_key_t("key"));
+    pool_t pool(std::move(wrapped), std::move(key), 4, &worker);
+
+    const string_view message("-");
+
+    for (std::int64_t key = 0; key < 8; ++key) {
+        const attribute_list attributes{{"key", key}, {"id", 0}};
+        const attribute_pack pack{attributes};
+        record_t record(0, message, pack);
+
+        pool.emit(record, message);
+    }
+
+    ASSERT_TRUE(pool.flush(std::chrono::seconds(10)));
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    EXPECT_EQ(8, state.records.size());
+}
+
+TEST(pool_t, Builder) {
+    state_t state;
+
+    auto sink = builder<asynchronous_t>(std::unique_ptr<sink_t>(new recording_sink_t(state)))
+        .workers(2)
+        .key("key")
+        .build();
+
+    EXPECT_EQ(2, dynamic_cast<pool_t&>(*sink).size());
+}
+
+TEST(pool_t, BuilderSpillsToFilePerWorker) {
+    const auto path = "/tmp/blackhole-pool-spill-" + std::to_string(::getpid());
+
+    state_t state;
+
+    {
+        auto sink = builder<asynchronous_t>(std::unique_ptr<sink_t>(new recording_sink_t(state)))
+            .workers(2)
+            .spill(path, 64 * 1024)
+            .build();
+
+        EXPECT_EQ(0, ::access((path + ".0").c_str(), F_OK));
+        EXPECT_EQ(0, ::access((path + ".1").c_str(), F_OK));
+    }
+
+    std::remove((path + ".0").c_str());
+    std::remove((path + ".1").c_str());
+}
+
+}  // namespace
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
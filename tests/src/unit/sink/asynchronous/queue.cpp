@@ -0,0 +1,430 @@
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/sink/asynchronous/queue.hpp>
+
+namespace {
+
+struct endpoint_t {
+    std::string host;
+    std::uint16_t port;
+};
+
+}  // namespace
+
+namespace blackhole {
+inline namespace v1 {
+
+template<>
+struct display_traits<endpoint_t> {
+    static auto apply(const endpoint_t& endpoint, writer_t& wr) -> void {
+        wr.write("{}:{}", endpoint.host, endpoint.port);
+    }
+};
+
+namespace sink {
+namespace asynchronous {
+namespace {
+
+auto pop(queue_t& queue) -> std::vector<std::string> {
+    std::vector<std::string> result;
+
+    slot_t slot;
+    while (queue.pop(slot)) {
+        result.push_back(slot.message);
+    }
+
+    return result;
+}
+
+TEST(shared_queue_t, PushPop) {
+    shared_queue_t queue(4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(record, std::to_string(i)));
+    }
+
+    EXPECT_FALSE(queue.push(record, "overflow"));
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3"}), pop(queue));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(shared_queue_t, Occupancy) {
+    shared_queue_t queue(4);
+    queue.track();
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    EXPECT_EQ(0, queue.occupancy());
+
+    for (int i = 0; i < 5; ++i) {
+        queue.push(record, message);
+    }
+
+    EXPECT_EQ(4, queue.occupancy());
+
+    slot_t slot;
+    queue.pop(slot);
+    EXPECT_EQ(3, queue.occupancy());
+}
+
+TEST(shared_queue_t, OccupancyIsNotTrackedByDefault) {
+    shared_queue_t queue(4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    queue.push(record, message);
+    EXPECT_EQ(0, queue.occupancy());
+}
+
+TEST(shared_queue_t, MarkPassedByLaterRecord) {
+    shared_queue_t queue(4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    queue.push(record, message);
+    const auto mark = queue.mark();
+    queue.push(record, message);
+
+    slot_t slot;
+    ASSERT_TRUE(queue.pop(slot));
+    ASSERT_TRUE(queue.pop(slot));
+    EXPECT_TRUE(queue.passed(mark));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(shared_queue_t, MarkPassedOnIdleQueue) {
+    shared_queue_t queue(4);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    queue.push(record, message);
+    const auto mark = queue.mark();
+
+    slot_t slot;
+    ASSERT_TRUE(queue.pop(slot));
+    EXPECT_TRUE(slot.valid);
+
+    // Nothing pushed after the mark tells it has been passed, so the queue pushes an invalid slot.
+    EXPECT_FALSE(queue.passed(mark));
+    EXPECT_FALSE(queue.passed(mark));
+
+    ASSERT_TRUE(queue.pop(slot));
+    EXPECT_FALSE(slot.valid);
+    EXPECT_TRUE(queue.passed(mark));
+    EXPECT_FALSE(queue.pop(slot));
+}
+
+TEST(sharded_queue_t, OccupancyOfOwnRing) {
+    sharded_queue_t queue(4, merge_t::relaxed);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    EXPECT_EQ(0, queue.occupancy());
+
+    queue.push(record, message);
+    queue.push(record, message);
+    EXPECT_EQ(2, queue.occupancy());
+
+    std::thread([&] {
+        EXPECT_EQ(0, queue.occupancy());
+        queue.push(record, message);
+        EXPECT_EQ(1, queue.occupancy());
+    }).join();
+
+    EXPECT_EQ(2, queue.occupancy());
+}
+
+TEST(sharded_queue_t, PushPop) {
+    sharded_queue_t queue(4, merge_t::relaxed);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(record, std::to_string(i)));
+    }
+
+    // Each thread has its own ring, so only the current one is full.
+    EXPECT_FALSE(queue.push(record, "overflow"));
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3"}), pop(queue));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(sharded_queue_t, RingPerThread) {
+    sharded_queue_t queue(4, merge_t::relaxed);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(record, "main"));
+    }
+
+    std::thread([&] {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(queue.push(record, "other"));
+        }
+    }).join();
+
+    EXPECT_EQ(8, pop(queue).size());
+}
+
+TEST(sharded_queue_t, AdoptsRingOfExitedThread) {
+    sharded_queue_t queue(4, merge_t::relaxed);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    std::thread([&] {
+        EXPECT_TRUE(queue.push(record, "first"));
+    }).join();
+
+    std::thread([&] {
+        // Records of the previous thread remain in the adopted ring, ahead of new ones.
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_TRUE(queue.push(record, "second"));
+        }
+
+        EXPECT_FALSE(queue.push(record, "overflow"));
+    }).join();
+
+    EXPECT_EQ((std::vector<std::string>{"first", "second", "second", "second"}), pop(queue));
+}
+
+TEST(sharded_queue_t, MergesByTimestamp) {
+    sharded_queue_t queue(4, merge_t::timestamp);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+
+    const auto now = record_t::clock_type::now();
+
+    record_t first(42, message, pack);
+    first.activate(message, now);
+    record_t second(42, message, pack);
+    second.activate(message, now + std::chrono::seconds(1));
+    record_t third(42, message, pack);
+    third.activate(message, now + std::chrono::seconds(2));
+
+    EXPECT_TRUE(queue.push(second, "second"));
+
+    std::thread([&] {
+        EXPECT_TRUE(queue.push(first, "first"));
+        EXPECT_TRUE(queue.push(third, "third"));
+    }).join();
+
+    EXPECT_EQ((std::vector<std::string>{"first", "second", "third"}), pop(queue));
+}
+
+TEST(byte_queue_t, PreservesRecord) {
+    byte_queue_t queue(1024);
+
+    const string_view message("unformatted message");
+    const endpoint_t endpoint{"127.0.0.1", 8080};
+    const attribute_list attributes{
+        {"null", nullptr},
+        {"bool", true},
+        {"sint", -42},
+        {"uint", 42u},
+        {"double", 3.1415},
+        {"string", "value"},
+        {"lazy", endpoint}
+    };
+    const attribute_pack pack{attributes};
+    record_t record(3, message, pack);
+    record.activate();
+
+    EXPECT_TRUE(queue.push(record, "formatted message"));
+
+    slot_t slot;
+    ASSERT_TRUE(queue.pop(slot));
+    ASSERT_TRUE(slot.valid);
+    EXPECT_FALSE(queue.pop(slot));
+
+    const auto result = slot.record.into_view();
+    EXPECT_EQ("formatted message", slot.message);
+    EXPECT_EQ(message, result.message());
+    EXPECT_EQ(3, result.severity());
+    EXPECT_EQ(record.timestamp(), result.timestamp());
+    EXPECT_EQ(record.pid(), result.pid());
+    EXPECT_EQ(record.lwp(), result.lwp());
+    EXPECT_EQ(record.tid(), result.tid());
+
+    const attribute_list expected{
+        {"null", nullptr},
+        {"bool", true},
+        {"sint", -42},
+        {"uint", 42u},
+        {"double", 3.1415},
+        {"string", "value"},
+        {"lazy", "127.0.0.1:8080"}
+    };
+
+    ASSERT_EQ(1, result.attributes().size());
+    EXPECT_EQ(expected, result.attributes().at(0).get());
+}
+
+TEST(byte_queue_t, CapacityInBytes) {
+    byte_queue_t queue(1024);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    EXPECT_EQ(1024, queue.capacity());
+    EXPECT_EQ(0, queue.occupancy());
+
+    std::size_t small = 0;
+    while (queue.push(record, "-")) {
+        ++small;
+    }
+
+    EXPECT_LT(0, queue.occupancy());
+    EXPECT_GE(1024, queue.occupancy());
+    EXPECT_EQ(small, pop(queue).size());
+    EXPECT_TRUE(queue.empty());
+
+    std::size_t large = 0;
+    while (queue.push(record, std::string(200, 'x'))) {
+        ++large;
+    }
+
+    // Small records take less space than large ones.
+    EXPECT_LT(large, small);
+    EXPECT_EQ(large, pop(queue).size());
+}
+
+TEST(byte_queue_t, WrapsAround) {
+    byte_queue_t queue(1024);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    // Sizes are not multiples of the capacity, so entries are padded at the end of the ring.
+    for (int round = 0; round < 100; ++round) {
+        std::vector<std::string> expected;
+
+        for (int i = 0; i < 3; ++i) {
+            expected.push_back(std::string(static_cast<std::size_t>(50 + round % 7 * 20), 'a' + i));
+            ASSERT_TRUE(queue.push(record, expected.back()));
+        }
+
+        EXPECT_EQ(expected, pop(queue));
+        EXPECT_TRUE(queue.empty());
+    }
+}
+
+TEST(byte_queue_t, ThrowsIfRecordDoesNotFit) {
+    byte_queue_t queue(1024);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    EXPECT_THROW(queue.push(record, std::string(600, 'x')), std::length_error);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(byte_queue_t, ManyProducers) {
+    byte_queue_t queue(4096);
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 4; ++id) {
+        threads.emplace_back([&, id] {
+            const string_view message("unformatted message");
+            const attribute_list attributes{{"id", id}};
+            const attribute_pack pack{attributes};
+            record_t record(42, message, pack);
+
+            for (int i = 0; i < 1000; ++i) {
+                while (!queue.push(record, std::to_string(i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> next(4, 0);
+    std::size_t count = 0;
+
+    slot_t slot;
+    while (count < 4000) {
+        if (!queue.pop(slot)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const auto id = attribute::get<std::int64_t>(
+            slot.record.into_view().attributes().at(0).get().at(0).second);
+
+        // Records of each producer remain in order.
+        EXPECT_EQ(std::to_string(next[static_cast<std::size_t>(id)]++), slot.message);
+        ++count;
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(queue_factory_t, CreatesRegisteredQueues) {
+    EXPECT_EQ(16, queue_factory_t().create("shared", 4)->capacity());
+    EXPECT_EQ(16, queue_factory_t().create("sharded", 4)->capacity());
+}
+
+TEST(queue_factory_t, ThrowsIfRequestedNonRegisteredQueue) {
+    EXPECT_THROW(queue_factory_t().create("sharped", 4), std::invalid_argument);
+}
+
+TEST(queue_factory_t, ThrowsIfByteCapacityIsOutOfRange) {
+    EXPECT_THROW(queue_factory_t().bytes(512), std::invalid_argument);
+    EXPECT_THROW(queue_factory_t().bytes(1ULL << 32), std::invalid_argument);
+}
+
+TEST(queue_factory_t, ThrowsIfFactorIsOutOfRange) {
+    EXPECT_THROW(queue_factory_t().create("shared", 21), std::invalid_argument);
+    EXPECT_THROW(queue_factory_t().sharded(1, merge_t::relaxed), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
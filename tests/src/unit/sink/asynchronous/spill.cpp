@@ -0,0 +1,251 @@
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/sink/asynchronous/spill.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace asynchronous {
+namespace {
+
+/// Removes the spill file of the test on both ends.
+class spill_test : public ::testing::Test {
+protected:
+    std::string path;
+
+    auto SetUp() -> void override {
+        path = "/tmp/blackhole-spill-" + std::to_string(::getpid()) + "-" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        std::remove(path.c_str());
+    }
+
+    auto TearDown() -> void override {
+        std::remove(path.c_str());
+    }
+};
+
+auto pop(spill_t& spill) -> std::vector<std::string> {
+    std::vector<std::string> result;
+
+    slot_t slot;
+    while (spill.pop(slot)) {
+        result.push_back(slot.message);
+    }
+
+    return result;
+}
+
+TEST_F(spill_test, PushPop) {
+    spill_t spill(path, 64 * 1024);
+
+    const string_view message("unformatted message");
+    const attribute_list attributes{{"key", "value"}, {"id", 42}};
+    const attribute_pack pack{attributes};
+    record_t record(3, message, pack);
+
+    EXPECT_TRUE(spill.empty());
+    EXPECT_TRUE(spill.push(record, "0"));
+    EXPECT_TRUE(spill.push(record, "1"));
+    EXPECT_FALSE(spill.empty());
+
+    slot_t slot;
+    ASSERT_TRUE(spill.pop(slot));
+    ASSERT_TRUE(slot.valid);
+    EXPECT_EQ("0", slot.message);
+    EXPECT_EQ(message, slot.record.into_view().message());
+    EXPECT_EQ(3, slot.record.into_view().severity());
+    EXPECT_EQ(attributes, slot.record.into_view().attributes().at(0).get());
+
+    EXPECT_EQ(std::vector<std::string>{"1"}, pop(spill));
+    EXPECT_TRUE(spill.empty());
+}
+
+TEST_F(spill_test, Bounded) {
+    spill_t spill(path, 64 * 1024);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    std::size_t count = 0;
+    while (spill.push(record, std::string(1000, 'x'))) {
+        ++count;
+    }
+
+    EXPECT_LT(0, count);
+    EXPECT_GE(spill.capacity(), spill.occupancy());
+    EXPECT_EQ(count, pop(spill).size());
+}
+
+TEST_F(spill_test, WrapsAround) {
+    spill_t spill(path, 64 * 1024);
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    for (int round = 0; round < 100; ++round) {
+        std::vector<std::string> expected;
+
+        for (int i = 0; i < 10; ++i) {
+            expected.push_back(std::string(static_cast<std::size_t>(500 + round * 13), 'a' + i));
+            ASSERT_TRUE(spill.push(record, expected.back()));
+        }
+
+        EXPECT_EQ(expected, pop(spill));
+    }
+}
+
+TEST_F(spill_test, SurvivesReopen) {
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    {
+        spill_t spill(path, 64 * 1024);
+        spill.push(record, "0");
+        spill.push(record, "1");
+        spill.push(record, "2");
+
+        slot_t slot;
+        spill.pop(slot);
+    }
+
+    // The size of the existing file is kept.
+    spill_t spill(path, 128 * 1024);
+    EXPECT_EQ(64 * 1024, spill.capacity());
+    EXPECT_EQ((std::vector<std::string>{"1", "2"}), pop(spill));
+}
+
+TEST_F(spill_test, ThrowsIfLocked) {
+    spill_t spill(path, 64 * 1024);
+
+    EXPECT_THROW(spill_t(path, 64 * 1024), std::system_error);
+}
+
+TEST_F(spill_test, ThrowsIfNotSpillFile) {
+    {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        ASSERT_NE(nullptr, file);
+        std::fputs("precious data", file);
+        std::fclose(file);
+    }
+
+    EXPECT_THROW(spill_t(path, 64 * 1024), std::invalid_argument);
+}
+
+/// Overwrites the given bytes of the file at the given offset.
+auto corrupt(const std::string& path, off_t offset, const void* data, std::size_t size) -> void {
+    const auto fd = ::open(path.c_str(), O_WRONLY);
+    ASSERT_NE(-1, fd);
+    EXPECT_EQ(static_cast<ssize_t>(size), ::pwrite(fd, data, size, offset));
+    ::close(fd);
+}
+
+TEST_F(spill_test, SkipsDamagedEntry) {
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    {
+        spill_t spill(path, 64 * 1024);
+        spill.push(record, "0");
+        spill.push(record, "1");
+    }
+
+    // The thread name length of the first entry, which follows its size word, severity, pid,
+    // timestamp, lwp, tid and the name flag, now points far beyond the entry.
+    const std::uint32_t length = 0xffffffff;
+    corrupt(path, 4096 + 8 + 4 + 4 + 8 + 8 + 8 + 1, &length, sizeof(length));
+
+    spill_t spill(path, 64 * 1024);
+    EXPECT_EQ((std::vector<std::string>{"1"}), pop(spill));
+}
+
+TEST_F(spill_test, DropsRecordsAfterDamagedSize) {
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    {
+        spill_t spill(path, 64 * 1024);
+        spill.push(record, "0");
+        spill.push(record, "1");
+    }
+
+    const std::uint64_t size = 12345;
+    corrupt(path, 4096, &size, sizeof(size));
+
+    spill_t spill(path, 64 * 1024);
+    EXPECT_TRUE(pop(spill).empty());
+    EXPECT_TRUE(spill.empty());
+}
+
+TEST_F(spill_test, ThrowsIfUnsupportedVersion) {
+    {
+        spill_t spill(path, 64 * 1024);
+    }
+
+    const std::uint64_t version = 42;
+    corrupt(path, 8, &version, sizeof(version));
+
+    EXPECT_THROW(spill_t(path, 64 * 1024), std::invalid_argument);
+}
+
+TEST_F(spill_test, ResetsZeroedFile) {
+    // What a crash between resizing and writing the header leaves behind.
+    {
+        const auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+        ASSERT_NE(-1, fd);
+        EXPECT_EQ(0, ::ftruncate(fd, 4096 + 64 * 1024));
+        ::close(fd);
+    }
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    spill_t spill(path, 64 * 1024);
+    EXPECT_TRUE(spill.empty());
+    EXPECT_EQ(64 * 1024, spill.capacity());
+
+    EXPECT_TRUE(spill.push(record, "0"));
+    EXPECT_EQ((std::vector<std::string>{"0"}), pop(spill));
+}
+
+TEST_F(spill_test, ResetsFileWithHeaderOnly) {
+    {
+        spill_t spill(path, 64 * 1024);
+    }
+
+    // What a crash between writing the header and extending the file leaves behind.
+    EXPECT_EQ(0, ::truncate(path.c_str(), 40));
+
+    spill_t spill(path, 64 * 1024);
+    EXPECT_TRUE(spill.empty());
+    EXPECT_EQ(64 * 1024, spill.capacity());
+}
+
+TEST_F(spill_test, ThrowsIfSizeIsOutOfRange) {
+    EXPECT_THROW(spill_t(path, 1024), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace asynchronous
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -7,6 +7,8 @@
 #include <blackhole/record.hpp>
 #include <blackhole/sink/file.hpp>
 #include <src/sink/file.hpp>
+#include <src/sink/file/flusher/repeat.hpp>
+#include <src/sink/file/rotate/null.hpp>
 
 #include "mocks/node.hpp"
 #include "mocks/registry.hpp"
@@ -52,6 +54,105 @@ TEST(backend_t, Write) {
     EXPECT_EQ("le message\n", stream_.str());
 }
 
+TEST(backend_t, AppendDoesNotFlush) {
+    std::unique_ptr<std::stringstream> stream(new std::stringstream);
+    std::unique_ptr<mock::rotate_t> rotate(new mock::rotate_t);
+    std::unique_ptr<mock::flusher_t> flusher(new mock::flusher_t);
+
+    auto& stream_ = *stream;
+
+    EXPECT_CALL(*flusher, update(11))
+        .Times(1)
+        .WillOnce(Return(flusher_t::result_t::flush));
+
+    backend_t backend(std::move(stream), std::move(rotate), std::move(flusher));
+
+    EXPECT_TRUE(backend.append("le message"));
+    EXPECT_EQ("le message\n", stream_.str());
+}
+
+/// Stream, that counts how many times it has been flushed.
+class counting_stream_t : public std::ostream {
+    class buffer_t : public std::stringbuf {
+    public:
+        int syncs = 0;
+
+    protected:
+        auto sync() -> int override {
+            ++syncs;
+            return std::stringbuf::sync();
+        }
+    };
+
+    buffer_t buffer;
+
+public:
+    counting_stream_t() : std::ostream(nullptr) {
+        rdbuf(&buffer);
+    }
+
+    auto str() const -> std::string {
+        return buffer.str();
+    }
+
+    auto syncs() const -> int {
+        return buffer.syncs;
+    }
+};
+
+class counting_stream_factory_t : public stream_factory_t {
+public:
+    mutable counting_stream_t* stream = nullptr;
+
+    auto create(const std::string&, std::ios_base::openmode) const ->
+        std::unique_ptr<std::ostream> override
+    {
+        stream = new counting_stream_t;
+        return std::unique_ptr<std::ostream>(stream);
+    }
+};
+
+TEST(file_t, EmitBatchFlushesOnce) {
+    std::unique_ptr<counting_stream_factory_t> streams(new counting_stream_factory_t);
+    auto& streams_ = *streams;
+
+    file_t sink("/tmp/blackhole.log", std::move(streams),
+        std::unique_ptr<rotate_factory_t>(new rotate::null_factory_t),
+        std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(1)));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const sink_t::entry_t entries[] = {{record, "first"}, {record, "second"}, {record, "third"}};
+    sink.emit_batch(sink_t::batch_t(entries, 3));
+
+    ASSERT_NE(nullptr, streams_.stream);
+    EXPECT_EQ("first\nsecond\nthird\n", streams_.stream->str());
+    EXPECT_EQ(1, streams_.stream->syncs());
+}
+
+TEST(file_t, Flush) {
+    std::unique_ptr<counting_stream_factory_t> streams(new counting_stream_factory_t);
+    auto& streams_ = *streams;
+
+    file_t sink("/tmp/blackhole.log", std::move(streams),
+        std::unique_ptr<rotate_factory_t>(new rotate::null_factory_t),
+        std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(100)));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "first");
+
+    ASSERT_NE(nullptr, streams_.stream);
+    EXPECT_EQ(0, streams_.stream->syncs());
+
+    sink.flush();
+    EXPECT_EQ(1, streams_.stream->syncs());
+}
+
 TEST(builder, Build) {
     builder<file_t> builder("/tmp/blackhole.log");
 
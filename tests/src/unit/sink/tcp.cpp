@@ -62,6 +62,32 @@ TEST(tcp, SendsData) {
     EXPECT_EQ('}', buffer[1]);
 }
 
+TEST(tcp, SendsBatch) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const sink_t::entry_t entries[] = {{record, "{1}"}, {record, "{2}"}, {record, "{3}"}};
+    sink.emit_batch(sink_t::batch_t(entries, 3));
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    boost::array<char, 9> buffer;
+    const auto nread = boost::asio::read(socket, boost::asio::buffer(buffer),
+        boost::asio::transfer_exactly(9));
+
+    ASSERT_EQ(9, nread);
+    EXPECT_EQ("{1}{2}{3}", std::string(buffer.data(), buffer.size()));
+}
+
 TEST(tcp, ThrowsExceptionOnConnectionRefused) {
     tcp_t sink("127.0.0.1", 1023);
 
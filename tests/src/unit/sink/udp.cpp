@@ -49,6 +49,31 @@ TEST(udp_t, SendsData) {
     EXPECT_EQ('}', buffer[1]);
 }
 
+TEST(udp_t, SendsBatch) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+    const auto endpoint = socket.local_endpoint();
+
+    udp_t sink(endpoint.address().to_string(), endpoint.port());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const sink_t::entry_t entries[] = {{record, "{1}"}, {record, "{22}"}, {record, "{333}"}};
+    sink.emit_batch(sink_t::batch_t(entries, 3));
+
+    // Each message must be sent as a separate datagram.
+    for (const auto& expected : {"{1}", "{22}", "{333}"}) {
+        boost::array<char, 16> buffer;
+        boost::asio::ip::udp::endpoint remote;
+        const auto nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+
+        EXPECT_EQ(expected, std::string(buffer.data(), nread));
+    }
+}
+
 TEST(udp_t, FactoryType) {
     EXPECT_EQ(std::string("udp"), factory<udp_t>(mock_registry_t()).type());
 }